@@ -0,0 +1,742 @@
+/**
+ * @file incliarray_bench.cpp
+ * @brief Benchmark suite for NDArray ops with JSON output and a regression
+ * comparison mode.
+ *
+ * Sweeps every core op (broadcast and same-shape binary ops, scalar ops,
+ * unary ops, softmax and cross-entropy, layer and batch normalization,
+ * matrix multiplication, convolutions, pooling, `sum`, `sum(axis)`, `clone`
+ * and `backward`) across sizes, ranks, contiguous vs `slice()` view
+ * operands and thread counts, and reports latency percentiles, GFLOP/s and
+ * GB/s per case.
+ *
+ * Usage:
+ *   incliarray_bench [--out FILE] [--filter TEXT] [--threads 1,4]
+ *                    [--min-time MS] [--quick]
+ *   incliarray_bench compare BASE.json NEW.json [--threshold PERCENT]
+ *
+ * FLOP and byte counts are nominal: the arithmetic and the unique memory
+ * traffic of the op itself, not of temporaries or allocation.
+ */
+#include "../include/NDArray.h"
+#include "../include/Optimizer.h"
+#include "../include/SparseNDArray.h"
+#include "../include/StaticNDArray.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+// Columns added to the base of a view operand so the view is not contiguous
+const int64_t kViewPadding = 8;
+
+// A timed sample batches enough calls to last at least this long
+const double kMinBatchUs = 50.0;
+const size_t kMinSamples = 5;
+const size_t kMaxSamples = 2000;
+
+struct Options {
+  std::string out; // empty: stdout
+  std::string filter;
+  std::vector<int> threads;
+  double minTimeMs = 100.0;
+  bool quick = false;
+};
+
+struct Stats {
+  int64_t iterations = 0; // op calls per sample
+  size_t samples = 0;
+  double minUs = 0.0;
+  double p50Us = 0.0;
+  double p90Us = 0.0;
+  double p99Us = 0.0;
+  double meanUs = 0.0;
+};
+
+int _maxThreads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void _setThreads(int threads) {
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#else
+  (void)threads;
+#endif
+}
+
+// Nearest-rank percentile of sorted samples
+double _percentile(const std::vector<double> &sorted, double q) {
+  size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+  return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+Stats _measure(const std::function<void()> &fn, double minTimeMs) {
+  using Clock = std::chrono::steady_clock;
+  auto elapsedUs = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start)
+        .count();
+  };
+
+  // Warm-up call, also used to size the batches
+  Clock::time_point start = Clock::now();
+  fn();
+  double once = std::max(elapsedUs(start), 0.01);
+
+  Stats stats;
+  stats.iterations = std::max<int64_t>(
+      1, static_cast<int64_t>(std::ceil(kMinBatchUs / once)));
+
+  std::vector<double> samples;
+  double totalUs = 0.0;
+  while ((totalUs < minTimeMs * 1000.0 || samples.size() < kMinSamples) &&
+         samples.size() < kMaxSamples) {
+    start = Clock::now();
+    for (int64_t i = 0; i < stats.iterations; ++i)
+      fn();
+    double us = elapsedUs(start);
+    totalUs += us;
+    samples.push_back(us / stats.iterations);
+  }
+
+  std::sort(samples.begin(), samples.end());
+  stats.samples = samples.size();
+  stats.minUs = samples.front();
+  stats.p50Us = _percentile(samples, 0.50);
+  stats.p90Us = _percentile(samples, 0.90);
+  stats.p99Us = _percentile(samples, 0.99);
+  stats.meanUs = totalUs / (samples.size() * stats.iterations);
+  return stats;
+}
+
+// Power-of-two shape with `elements` elements spread over `rank` axes
+Shape _shapeFor(int64_t elements, int rank) {
+  int log2 = 0;
+  while ((int64_t(1) << (log2 + 1)) <= elements)
+    ++log2;
+
+  Shape shape;
+  for (int i = 0; i < rank; ++i)
+    shape.push_back(int64_t(1) << (log2 / rank + (i < log2 % rank ? 1 : 0)));
+  return shape;
+}
+
+std::string _shapeName(const Shape &shape) {
+  std::string name;
+  for (size_t i = 0; i < shape.size(); ++i)
+    name += (i > 0 ? "x" : "") + std::to_string(shape[i]);
+  return name;
+}
+
+// An operand in the requested layout. Views are slices of a base padded
+// along its last axis, so they are strided but cover the same elements.
+struct Operand {
+  std::unique_ptr<NDArray> base;
+  std::unique_ptr<NDArray> view;
+
+  NDArray &get() { return view ? *view : *base; }
+};
+
+Operand _makeOperand(const Shape &shape, bool asView, float low, float high) {
+  Operand operand;
+  Shape baseShape = shape;
+  if (asView)
+    baseShape.back() += kViewPadding;
+
+  operand.base = std::make_unique<NDArray>(baseShape);
+  operand.base->rand(low, high);
+  if (asView) {
+    std::vector<std::tuple<int64_t, int64_t>> ranges;
+    for (int64_t dim : shape)
+      ranges.push_back({0, dim});
+    operand.view = std::make_unique<NDArray>(operand.base->slice(ranges));
+  }
+  return operand;
+}
+
+class Runner {
+public:
+  explicit Runner(const Options &options) : options(options) {}
+
+  /**
+   * @brief Time `fn` as case op/shape/layout/threads unless filtered out.
+   * @param flops Nominal floating point operations per call
+   * @param bytes Nominal bytes read and written per call
+   */
+  void run(const std::string &op, const Shape &shape,
+           const std::string &layout, int threads, double flops, double bytes,
+           const std::function<void()> &fn) {
+    std::string name = op + "/" + _shapeName(shape) + "/" + layout + "/t" +
+                       std::to_string(threads);
+    if (!options.filter.empty() &&
+        name.find(options.filter) == std::string::npos)
+      return;
+
+    Stats stats = _measure(fn, options.minTimeMs);
+    double seconds = stats.p50Us * 1e-6;
+    double gflops = flops / seconds * 1e-9;
+    double gbps = bytes / seconds * 1e-9;
+
+    std::ostringstream line;
+    line << "    {\"name\": \"" << name << "\", \"op\": \"" << op
+         << "\", \"shape\": [";
+    for (size_t i = 0; i < shape.size(); ++i)
+      line << (i > 0 ? ", " : "") << shape[i];
+    line << "], \"layout\": \"" << layout << "\", \"threads\": " << threads
+         << ", \"iterations\": " << stats.iterations
+         << ", \"samples\": " << stats.samples << ", \"latency_us\": {\"min\": "
+         << stats.minUs << ", \"p50\": " << stats.p50Us
+         << ", \"p90\": " << stats.p90Us << ", \"p99\": " << stats.p99Us
+         << ", \"mean\": " << stats.meanUs << "}, \"gflops\": " << gflops
+         << ", \"gbps\": " << gbps << "}";
+    results.push_back(line.str());
+
+    std::fprintf(stderr, "%-44s p50 %10.2f us %8.2f GFLOP/s %8.2f GB/s\n",
+                 name.c_str(), stats.p50Us, gflops, gbps);
+  }
+
+  void write(std::ostream &out, int maxThreads) const {
+    out << "{\n  \"schema\": 1,\n  \"openmp\": "
+#ifdef _OPENMP
+        << "true"
+#else
+        << "false"
+#endif
+        << ",\n  \"max_threads\": " << maxThreads
+        << ",\n  \"min_time_ms\": " << options.minTimeMs
+        << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+      out << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    out << "  ]\n}\n";
+  }
+
+private:
+  const Options &options;
+  std::vector<std::string> results; // one JSON object per line
+};
+
+void _benchElementwise(Runner &runner, const Options &options, int threads) {
+  std::vector<int64_t> sizes = {1 << 10, 1 << 14, 1 << 18, 1 << 22};
+  if (options.quick)
+    sizes = {1 << 12, 1 << 18};
+  const double f = sizeof(float);
+
+  for (int64_t elements : sizes) {
+    for (int rank : {1, 2, 4}) {
+      for (bool asView : {false, true}) {
+        Shape shape = _shapeFor(elements, rank);
+        std::string layout = asView ? "view" : "contiguous";
+        double n = static_cast<double>(elements);
+
+        // Divisors are kept away from zero
+        Operand a = _makeOperand(shape, asView, 1.0f, 2.0f);
+        Operand b = _makeOperand(shape, asView, 1.0f, 2.0f);
+        Shape rowShape(shape.size(), 1);
+        rowShape.back() = shape.back();
+        Operand row = _makeOperand(rowShape, asView, 1.0f, 2.0f);
+        NDArray &A = a.get();
+        NDArray &B = b.get();
+        NDArray &R = row.get();
+
+        auto run = [&](const std::string &op, double flops, double bytes,
+                       const std::function<void()> &fn) {
+          runner.run(op, shape, layout, threads, flops, bytes, fn);
+        };
+
+        run("add", n, 3 * n * f, [&] { NDArray C = A + B; });
+        run("sub", n, 3 * n * f, [&] { NDArray C = A - B; });
+        run("mul", n, 3 * n * f,
+            [&] { NDArray C = A.element_wise_multiply(B); });
+        run("div", n, 3 * n * f, [&] { NDArray C = A / B; });
+
+        // Broadcasting a row across every leading position
+        run("add_bcast", n, 2 * n * f, [&] { NDArray C = A + R; });
+        run("sub_bcast", n, 2 * n * f, [&] { NDArray C = A - R; });
+        run("mul_bcast", n, 2 * n * f,
+            [&] { NDArray C = A.element_wise_multiply(R); });
+        run("div_bcast", n, 2 * n * f, [&] { NDArray C = A / R; });
+
+        run("add_scalar", n, 2 * n * f, [&] { NDArray C = A + 2.0f; });
+        run("sub_scalar", n, 2 * n * f, [&] { NDArray C = A - 2.0f; });
+        run("mul_scalar", n, 2 * n * f, [&] { NDArray C = A * 2.0f; });
+        run("div_scalar", n, 2 * n * f, [&] { NDArray C = A / 2.0f; });
+        run("pow_scalar", n, 2 * n * f, [&] { NDArray C = A ^ 2.0f; });
+
+        // Unary ops count one FLOP per element, as pow does
+        run("exp", n, 2 * n * f, [&] { NDArray C = A.exp(); });
+        run("exp_fast", n, 2 * n * f,
+            [&] { NDArray C = A.exp(MathMode::Fast); });
+        run("log", n, 2 * n * f, [&] { NDArray C = A.log(); });
+        run("tanh", n, 2 * n * f, [&] { NDArray C = A.tanh(); });
+        run("sigmoid", n, 2 * n * f, [&] { NDArray C = A.sigmoid(); });
+        run("relu", n, 2 * n * f, [&] { NDArray C = A.relu(); });
+        run("gelu", n, 2 * n * f, [&] { NDArray C = A.gelu(); });
+        run("gelu_fast", n, 2 * n * f,
+            [&] { NDArray C = A.gelu(MathMode::Fast); });
+
+        run("sum", n, n * f, [&] { NDArray C = A.sum(); });
+        run("sum_axis0", n, n * f, [&] { NDArray C = A.sum(0); });
+
+        // Fused row normalizations over the last axis
+        NDArrayI64 targets({elements / shape.back()});
+        targets.zeros();
+        run("softmax", 5 * n, 2 * n * f, [&] { NDArray C = A.softmax(); });
+        run("log_softmax", 5 * n, 2 * n * f,
+            [&] { NDArray C = A.logSoftmax(); });
+        run("cross_entropy", 4 * n, n * f,
+            [&] { NDArray C = A.crossEntropy(targets); });
+        NDArray gamma({shape.back()});
+        NDArray beta({shape.back()});
+        gamma.ones();
+        beta.zeros();
+        run("layer_norm", 8 * n, 2 * n * f,
+            [&] { NDArray C = A.layerNorm(gamma, beta); });
+
+        // Contiguous clones share the buffer copy-on-write: no traffic
+        run("clone", 0.0, asView ? 2 * n * f : 0.0,
+            [&] { NDArray C = A.clone(); });
+
+        // Backward of sum(A + B): seeds dY, then accumulates dA and dB
+        NDArray Y = A + B;
+        NDArray S = Y.sum();
+        run("backward", 2 * n, 6 * n * f, [&] { S.backward(); });
+      }
+    }
+  }
+}
+
+void _benchMatmul(Runner &runner, const Options &options, int threads) {
+  std::vector<int64_t> sizes = {64, 256, 512};
+  if (options.quick)
+    sizes = {64, 256};
+  const double f = sizeof(float);
+
+  for (int64_t s : sizes) {
+    for (bool asView : {false, true}) {
+      Shape shape = {s, s};
+      Operand a = _makeOperand(shape, asView, -1.0f, 1.0f);
+      Operand b = _makeOperand(shape, asView, -1.0f, 1.0f);
+      NDArray &A = a.get();
+      NDArray &B = b.get();
+      double n = static_cast<double>(s);
+
+      runner.run("matmul", shape, asView ? "view" : "contiguous", threads,
+                 2 * n * n * n, 3 * n * n * f, [&] { NDArray C = A * B; });
+    }
+
+    // Fused bias + ReLU epilogue against the same product
+    Shape shape = {s, s};
+    NDArray x(shape), w(shape), bias({s});
+    x.rand(-1.0f, 1.0f);
+    w.rand(-1.0f, 1.0f);
+    bias.rand(-1.0f, 1.0f);
+    double n = static_cast<double>(s);
+    runner.run("linear_relu", shape, "contiguous", threads,
+               2 * n * n * n + 2 * n * n, (3 * n * n + n) * f,
+               [&] { NDArray y = x.linear(w, bias, Activation::ReLU); });
+  }
+}
+
+// Convolution layers of a small CNN on a batch of 32x32 feature maps: the
+// im2col + GEMM path (3x3), the direct 1x1 and depthwise paths, conv1d and
+// the backward of the 3x3 layer
+void _benchConv(Runner &runner, const Options &options, int threads) {
+  const int64_t batch = options.quick ? 2 : 8;
+  const int64_t channels = 32;
+  const int64_t side = 32;
+  const double f = sizeof(float);
+
+  struct Layer {
+    std::string name;
+    int64_t outChannels, kernel, padding, groups;
+  };
+  std::vector<Layer> layers = {{"conv2d_3x3", channels, 3, 1, 1},
+                               {"conv2d_1x1", channels, 1, 0, 1},
+                               {"conv2d_depthwise", channels, 3, 1, channels}};
+
+  Shape shape = {batch, channels, side, side};
+  NDArray x(shape);
+  x.rand(-1.0f, 1.0f);
+  double pixels = static_cast<double>(batch * side * side);
+  for (const Layer &layer : layers) {
+    NDArray w({layer.outChannels, channels / layer.groups, layer.kernel,
+               layer.kernel});
+    NDArray b({layer.outChannels});
+    w.rand(-1.0f, 1.0f);
+    b.rand(-1.0f, 1.0f);
+    double macs = pixels * layer.outChannels * (channels / layer.groups) *
+                  layer.kernel * layer.kernel;
+    double bytes = (x.size + w.size + pixels * layer.outChannels) * f;
+    runner.run(layer.name, shape, "contiguous", threads, 2 * macs, bytes, [&] {
+      NDArray y = x.conv2d(w, b, 1, layer.padding, 1, layer.groups);
+    });
+
+    if (layer.kernel == 3 && layer.groups == 1) {
+      NDArray y = x.conv2d(w, b, 1, layer.padding);
+      NDArray loss = y.sum();
+      runner.run(layer.name + "_backward", shape, "contiguous", threads,
+                 4 * macs, 2 * bytes, [&] { loss.backward(); });
+    }
+  }
+
+  // Normalization and pooling of the same feature maps
+  NDArray gamma({channels}), beta({channels});
+  NDArray runningMean({channels}), runningVar({channels});
+  gamma.ones();
+  beta.zeros();
+  runningMean.zeros();
+  runningVar.ones();
+  double n = static_cast<double>(x.size);
+  runner.run("batch_norm", shape, "contiguous", threads, 6 * n, 2 * n * f, [&] {
+    NDArray y = x.batchNorm(gamma, beta, runningMean, runningVar);
+  });
+  runner.run("max_pool2d", shape, "contiguous", threads, n, 1.25 * n * f,
+             [&] { NDArray y = x.maxPool2d(2); });
+  runner.run("avg_pool2d", shape, "contiguous", threads, 9 * n, 2 * n * f,
+             [&] { NDArray y = x.avgPool2d(3, 1, 1); });
+
+  Shape sequence = {batch, 2 * channels, 256};
+  NDArray s(sequence), w({2 * channels, 2 * channels, 5}), b({2 * channels});
+  s.rand(-1.0f, 1.0f);
+  w.rand(-1.0f, 1.0f);
+  b.rand(-1.0f, 1.0f);
+  double macs = static_cast<double>(batch * 256 * w.size);
+  runner.run("conv1d", sequence, "contiguous", threads, 2 * macs,
+             (2 * s.size + w.size) * f,
+             [&] { NDArray y = s.conv1d(w, b, 1, 2); });
+}
+
+// Forward and backward of a 4x4 layer relu(x * W + b), with compile-time
+// shapes and with the same graph built from NDArrays
+void _benchStatic(Runner &runner, int threads) {
+  NDArray x({4, 4}), w({4, 4}), b({1, 4});
+  x.rand(-1.0f, 1.0f);
+  w.rand(-1.0f, 1.0f);
+  b.rand(-1.0f, 1.0f);
+  auto sx = StaticNDArray<4, 4>::fromNDArray(x);
+  auto sw = StaticNDArray<4, 4>::fromNDArray(w);
+  auto sb = StaticNDArray<1, 4>::fromNDArray(b);
+
+  Shape shape = {4, 4};
+  const double flops = 2 * 64 + 32 + 4 * 64;
+  const double bytes = 36 * 2 * sizeof(float);
+  float sink = 0.0f;
+  runner.run("static_layer", shape, "static", threads, flops, bytes, [&] {
+    auto h = sx * sw;
+    auto z = h + sb;
+    auto y = z.relu();
+    auto loss = y.sum();
+    loss.backward();
+    sink += loss.data[0] + sw.grad[0];
+  });
+  runner.run("static_layer", shape, "contiguous", threads, flops, bytes, [&] {
+    NDArray h = x * w;
+    NDArray z = h + b;
+    NDArray y = z.relu();
+    NDArray loss = y.sum();
+    loss.backward();
+    sink += loss.data[0] + w.grad[0];
+  });
+  if (std::isnan(sink))
+    std::fprintf(stderr, "static_layer: NaN\n");
+}
+
+// Batched matmul through einsum, and a matrix-matrix-vector chain that
+// einsum contracts right to left against the left-to-right product a
+// hand-written expression would use
+void _benchEinsum(Runner &runner, const Options &options, int threads) {
+  const int64_t batch = options.quick ? 8 : 32;
+  const int64_t n = options.quick ? 256 : 512;
+  const double f = sizeof(float);
+
+  NDArray a({batch, 128, 128}), b({batch, 128, 128});
+  a.rand(-1.0f, 1.0f);
+  b.rand(-1.0f, 1.0f);
+  double macs = static_cast<double>(batch * 128 * 128 * 128);
+  double elements = static_cast<double>(batch * 128 * 128);
+  runner.run("einsum_bmm", {batch, 128, 128}, "contiguous", threads,
+             2 * macs, 3 * elements * f,
+             [&] { NDArray y = NDArray::einsum("bij,bjk->bik", a, b); });
+
+  NDArray x({n, n}), w({n, n}), v({n, 1});
+  x.rand(-1.0f, 1.0f);
+  w.rand(-1.0f, 1.0f);
+  v.rand(-1.0f, 1.0f);
+  double square = static_cast<double>(n * n);
+  runner.run("einsum_chain", {n, n}, "contiguous", threads, 4 * square,
+             2 * square * f,
+             [&] { NDArray y = NDArray::einsum("ij,jk,kl->il", x, w, v); });
+  runner.run("einsum_chain_reference", {n, n}, "contiguous", threads,
+             2 * square * n, 3 * square * f, [&] {
+               NDArray xw = x * w;
+               NDArray y = xw * v;
+             });
+}
+
+// Sparse features (1% non-zero) times a dense embedding table, against the
+// same product computed densely
+void _benchSparse(Runner &runner, const Options &options, int threads) {
+  const int64_t rows = options.quick ? 256 : 1024;
+  const int64_t features = 4096;
+  const int64_t width = 64;
+  const double f = sizeof(float);
+
+  NDArray featureMatrix({rows, features});
+  featureMatrix.bernoulli(0.01);
+  SparseNDArray sparse = SparseNDArray::fromDense(featureMatrix);
+  NDArray table({features, width});
+  table.rand(-1.0f, 1.0f);
+
+  Shape shape = {rows, features};
+  double nnz = static_cast<double>(sparse.nnz());
+  double bytes = nnz * (f + 8) + (nnz + rows) * width * f;
+  runner.run("spmm", shape, "csr_1pct", threads, 2 * nnz * width, bytes,
+             [&] { NDArray y = sparse * table; });
+
+  NDArray y = sparse * table;
+  NDArray loss = y.sum();
+  runner.run("spmm_backward", shape, "csr_1pct", threads, 4 * nnz * width,
+             2 * bytes, [&] { loss.backward(); });
+
+  double elements = static_cast<double>(rows * features);
+  runner.run("spmm_dense_reference", shape, "contiguous", threads,
+             2 * elements * width, (elements + (rows + features) * width) * f,
+             [&] { NDArray y = featureMatrix * table; });
+}
+
+// Lookups of a batch of token ids (with repeats) in a large embedding table;
+// the backward writes only the looked-up rows
+void _benchEmbedding(Runner &runner, const Options &options, int threads) {
+  const int64_t vocabulary = options.quick ? 50000 : 200000;
+  const int64_t width = 128;
+  const int64_t tokens = 8192;
+  const double f = sizeof(float);
+
+  NDArray table({vocabulary, width});
+  table.rand(-1.0f, 1.0f);
+  NDArrayI64 ids({tokens});
+  ids.randint(0, static_cast<int>(vocabulary / 16));
+
+  Shape shape = {tokens, width};
+  double n = static_cast<double>(tokens * width);
+  runner.run("embedding", shape, "contiguous", threads, 0, 2 * n * f,
+             [&] { NDArray y = table.embedding(ids); });
+
+  NDArray y = table.embedding(ids);
+  NDArray loss = y.sum();
+  runner.run("embedding_backward", shape, "contiguous", threads, n, 3 * n * f,
+             [&] { loss.backward(); });
+}
+
+// One optimizer step over the weights and biases of a small MLP, so that
+// tensors of very different sizes are updated in the same pass
+void _benchOptimizer(Runner &runner, const Options &options, int threads) {
+  const int64_t width = options.quick ? 256 : 1024;
+  std::vector<Shape> shapes = {{width, width},     {width},
+                               {width, 4 * width}, {4 * width},
+                               {4 * width, width}, {width}};
+  std::vector<NDArray> params;
+  params.reserve(shapes.size());
+  int64_t total = 0;
+  for (const Shape &shape : shapes) {
+    params.emplace_back(shape);
+    params.back().rand(-1.0f, 1.0f);
+    std::fill(params.back().grad, params.back().grad + params.back().size,
+              1e-3f);
+    total += params.back().size;
+  }
+  std::vector<std::reference_wrapper<NDArray>> refs(params.begin(),
+                                                    params.end());
+  Shape shape = {total};
+  double n = static_cast<double>(total);
+  const double f = sizeof(float);
+
+  SGD sgd(refs, {0.01f, 0.9f, true, 1e-4f});
+  runner.run("sgd_nesterov_step", shape, "contiguous", threads, 6 * n,
+             4 * n * f, [&] { sgd.step(); });
+
+  AdamW adamw(refs, {1e-3f, 0.9f, 0.999f, 1e-8f, 0.01f, 1.0f});
+  runner.run("adamw_clip_step", shape, "contiguous", threads, 14 * n,
+             8 * n * f, [&] { adamw.step(); });
+  runner.run("zero_grad", shape, "contiguous", threads, 0, n * f,
+             [&] { adamw.zeroGrad(); });
+}
+
+// Reads "name" -> p50 latency from a file written by this tool (one result
+// object per line)
+std::map<std::string, double> _readResults(const std::string &path) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error("Could not open '" + path + "'.");
+
+  std::map<std::string, double> result;
+  const std::string nameKey = "\"name\": \"";
+  const std::string p50Key = "\"p50\": ";
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t name = line.find(nameKey);
+    size_t p50 = line.find(p50Key);
+    if (name == std::string::npos || p50 == std::string::npos)
+      continue;
+    name += nameKey.size();
+    result[line.substr(name, line.find('"', name) - name)] =
+        std::strtod(line.c_str() + p50 + p50Key.size(), nullptr);
+  }
+  return result;
+}
+
+// Prints the p50 change of every case; returns 1 if any case got slower by
+// more than `thresholdPercent`
+int _compare(const std::string &basePath, const std::string &newPath,
+             double thresholdPercent) {
+  std::map<std::string, double> base = _readResults(basePath);
+  std::map<std::string, double> current = _readResults(newPath);
+
+  int regressions = 0;
+  int improvements = 0;
+  std::printf("%-44s %12s %12s %9s\n", "case", "base p50 us", "new p50 us",
+              "change");
+  for (const auto &[name, newUs] : current) {
+    auto it = base.find(name);
+    if (it == base.end()) {
+      std::printf("%-44s %12s %12.2f %9s  new\n", name.c_str(), "-", newUs,
+                  "-");
+      continue;
+    }
+
+    double change = (newUs / it->second - 1.0) * 100.0;
+    const char *status = "";
+    if (change > thresholdPercent) {
+      status = "  REGRESSION";
+      ++regressions;
+    } else if (change < -thresholdPercent) {
+      status = "  faster";
+      ++improvements;
+    }
+    std::printf("%-44s %12.2f %12.2f %+8.1f%%%s\n", name.c_str(), it->second,
+                newUs, change, status);
+  }
+  for (const auto &[name, baseUs] : base) {
+    if (current.count(name) == 0)
+      std::printf("%-44s %12.2f %12s %9s  missing\n", name.c_str(), baseUs,
+                  "-", "-");
+  }
+
+  std::printf("\n%d regression(s), %d improvement(s) beyond %.1f%%\n",
+              regressions, improvements, thresholdPercent);
+  return regressions > 0 ? 1 : 0;
+}
+
+void _usage() {
+  std::cerr
+      << "usage: incliarray_bench [--out FILE] [--filter TEXT] "
+         "[--threads 1,4] [--min-time MS] [--quick]\n"
+         "       incliarray_bench compare BASE.json NEW.json "
+         "[--threshold PERCENT]\n";
+}
+
+std::vector<int> _parseList(const std::string &text) {
+  std::vector<int> values;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    values.push_back(std::max(1, std::atoi(item.c_str())));
+  return values;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+
+  if (!args.empty() && args[0] == "compare") {
+    if (args.size() != 3 && !(args.size() == 5 && args[3] == "--threshold")) {
+      _usage();
+      return 2;
+    }
+    double threshold = args.size() == 5 ? std::atof(args[4].c_str()) : 10.0;
+    try {
+      return _compare(args[1], args[2], threshold);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 2;
+    }
+  }
+
+  Options options;
+  for (size_t i = 0; i < args.size(); ++i) {
+    bool hasValue = i + 1 < args.size();
+    if (args[i] == "--quick") {
+      options.quick = true;
+    } else if (args[i] == "--out" && hasValue) {
+      options.out = args[++i];
+    } else if (args[i] == "--filter" && hasValue) {
+      options.filter = args[++i];
+    } else if (args[i] == "--threads" && hasValue) {
+      options.threads = _parseList(args[++i]);
+    } else if (args[i] == "--min-time" && hasValue) {
+      options.minTimeMs = std::atof(args[++i].c_str());
+    } else {
+      _usage();
+      return 2;
+    }
+  }
+  if (options.quick && options.minTimeMs == 100.0)
+    options.minTimeMs = 20.0;
+
+  int maxThreads = _maxThreads();
+  if (options.threads.empty()) {
+    options.threads = {1};
+    if (maxThreads > 1)
+      options.threads.push_back(maxThreads);
+  }
+
+  // A fixed seed keeps operands identical between runs being compared
+  Generator::global().manualSeed(0);
+
+  Runner runner(options);
+  for (int threads : options.threads) {
+    _setThreads(threads);
+    _benchElementwise(runner, options, threads);
+    _benchMatmul(runner, options, threads);
+    _benchConv(runner, options, threads);
+    _benchOptimizer(runner, options, threads);
+    _benchSparse(runner, options, threads);
+    _benchEmbedding(runner, options, threads);
+    _benchStatic(runner, threads);
+    _benchEinsum(runner, options, threads);
+  }
+  _setThreads(maxThreads);
+
+  if (options.out.empty()) {
+    runner.write(std::cout, maxThreads);
+  } else {
+    std::ofstream out(options.out);
+    if (!out) {
+      std::cerr << "Could not open '" << options.out << "' for writing."
+                << std::endl;
+      return 2;
+    }
+    runner.write(out, maxThreads);
+  }
+  return 0;
+}
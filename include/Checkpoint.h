@@ -0,0 +1,85 @@
+/**
+ * @file Checkpoint.h
+ * @brief Checkpoint: binary save/restore of named NDArrays (data and grads).
+ *
+ * This header declares the Checkpoint class, which provides:
+ * - A chunked container format holding label, shape, strides, data and
+ *   optionally grad for a set of NDArrays
+ * - Streaming writes through a fixed-size chunk buffer (no full copy of any
+ *   tensor is ever made)
+ * - A CRC32C checksum per chunk, verified on load
+ * - Optional fast compression (byte shuffle + LZ77) per chunk
+ * - Loading into preallocated tensors, reading uncompressed chunks straight
+ *   into the target buffers
+ *
+ * Design notes:
+ * - Tensors are identified by their `label`, which must be non-empty and
+ *   unique within a checkpoint.
+ * - Data is stored in logical row‑major order, so views can be saved and any
+ *   layout can be restored into; the saved strides are kept for inspection.
+ * - All integers are stored little-endian.
+ */
+#pragma once
+
+#include "NDArray.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Options controlling how a checkpoint is written. */
+struct CheckpointOptions {
+  bool includeGrad = false;   /**< Also store each tensor's grad buffer. */
+  bool compress = false;      /**< Compress chunks (kept raw if no gain). */
+  int chunkBytes = 4 << 20;   /**< Uncompressed bytes per chunk. */
+};
+
+/** Metadata of one tensor stored in a checkpoint. */
+struct CheckpointEntry {
+  std::string label;            /**< Tensor label used as its key. */
+  std::vector<int64_t> shape;   /**< Shape of the saved tensor. */
+  std::vector<int64_t> strides; /**< Saved strides (informational). */
+  bool hasGrad = false;         /**< Whether a grad section follows the data. */
+};
+
+class Checkpoint {
+public:
+  /**
+   * @brief Write `arrays` to `path`, keyed by their labels.
+   * @param path Destination file (overwritten)
+   * @param arrays Tensors to save; labels must be non-empty and unique
+   * @param options Grad inclusion, compression and chunk size
+   * @throws std::invalid_argument on missing/duplicate labels or a
+   *         non-positive chunk size
+   * @throws std::runtime_error if the file cannot be written
+   */
+  static void save(const std::string &path,
+                   const std::vector<std::reference_wrapper<NDArray>> &arrays,
+                   CheckpointOptions options = {});
+
+  /**
+   * @brief List the tensors stored in a checkpoint without reading payloads.
+   *
+   * Useful to preallocate targets before load().
+   *
+   * @throws std::runtime_error if the file cannot be read or is malformed
+   */
+  static std::vector<CheckpointEntry> entries(const std::string &path);
+
+  /**
+   * @brief Restore tensors from `path` into preallocated `arrays`.
+   *
+   * Each target is matched by label and must have the saved shape (strides
+   * may differ). Stored tensors without a matching target are skipped.
+   *
+   * @param path Checkpoint file
+   * @param arrays Targets, matched by label
+   * @param loadGrad Also restore grads when the checkpoint has them
+   * @throws std::invalid_argument on a shape mismatch
+   * @throws std::runtime_error if a target is missing from the file, the file
+   *         is malformed, or a chunk fails its checksum
+   */
+  static void load(const std::string &path,
+                   const std::vector<std::reference_wrapper<NDArray>> &arrays,
+                   bool loadGrad = true);
+};
@@ -0,0 +1,112 @@
+/**
+ * @file MemoryTracker.h
+ * @brief MemoryTracker: opt-in accounting of array buffer allocations.
+ *
+ * This header declares the MemoryTracker class and its snapshot types,
+ * which provide:
+ * - Attribution of every data and grad buffer allocated by arrays to the
+ *   producing `op` and to a label (the array's label, else the innermost
+ *   MemoryTracker::Scope of the allocating thread)
+ * - Live, peak and cumulative bytes, split into data and grad, in total and
+ *   per op and per label
+ * - A snapshot API and a report listing the largest live buffers
+ *
+ * Design notes:
+ * - Disabled by default; while disabled an allocation costs one relaxed
+ *   atomic load. Buffers allocated while enabled are still accounted for
+ *   when they are released after disable().
+ * - Tracked buffers: the data + grad allocation of new arrays, gradient
+ *   buffers of adopted memory and copy‑on‑write copies. Memory adopted with
+ *   fromBuffer() is owned by the caller and not counted.
+ */
+#pragma once
+
+#include "Shape.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/** Byte counters of a set of allocations. */
+struct MemoryUsage {
+  int64_t liveBytes = 0;       /**< Currently allocated. */
+  int64_t liveDataBytes = 0;   /**< Live bytes holding data. */
+  int64_t liveGradBytes = 0;   /**< Live bytes holding gradients. */
+  int64_t peakBytes = 0;       /**< Maximum of liveBytes so far. */
+  int64_t cumulativeBytes = 0; /**< Total ever allocated. */
+  int64_t liveAllocations = 0; /**< Buffers currently allocated. */
+  int64_t allocations = 0;     /**< Buffers ever allocated. */
+};
+
+/** One live tracked buffer. */
+struct LiveAllocation {
+  uint64_t id = 0;       /**< Allocation order (from 1). */
+  std::string op;        /**< Op that produced the array ("" for leaves). */
+  std::string label;     /**< Label the bytes are attributed to. */
+  Shape shape;           /**< Shape of the array at allocation. */
+  int64_t dataBytes = 0; /**< Bytes holding data. */
+  int64_t gradBytes = 0; /**< Bytes holding the gradient. */
+};
+
+/** Point-in-time view of all tracked memory. */
+struct MemorySnapshot {
+  MemoryUsage total;                           /**< All tracked buffers. */
+  std::map<std::string, MemoryUsage> byOp;     /**< Keyed by producing op. */
+  std::map<std::string, MemoryUsage> byLabel;  /**< Keyed by label. */
+  std::vector<LiveAllocation> live;            /**< Largest first. */
+};
+
+class MemoryTracker {
+public:
+  /**
+   * @brief Attributes allocations of the current thread without a label of
+   *        their own to `name` while in scope (nested scopes join with '/').
+   */
+  class Scope {
+  public:
+    explicit Scope(const std::string &name);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    size_t previousLength;
+  };
+
+  /** @brief Start tracking new allocations. */
+  static void enable();
+
+  /** @brief Stop tracking new allocations. */
+  static void disable();
+
+  /** @brief Whether new allocations are tracked. */
+  static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+  /** @brief Forget all counters and live records. */
+  static void reset();
+
+  /**
+   * @brief Record a buffer allocation (no-op while disabled).
+   * @return Token to pass to release(); 0 if not tracked
+   */
+  static uint64_t allocate(const std::string &op, const std::string &label,
+                           const Shape &shape, int64_t dataBytes,
+                           int64_t gradBytes);
+
+  /** @brief Record the release of a buffer (no-op for token 0). */
+  static void release(uint64_t token);
+
+  /** @brief Current counters and live buffers. */
+  static MemorySnapshot snapshot();
+
+  /**
+   * @brief Print totals, per op and per label usage and the `top` largest
+   *        live buffers.
+   */
+  static void printReport(std::ostream &out = std::cout, size_t top = 10);
+
+private:
+  static inline std::atomic<bool> active{false};
+};
@@ -1,34 +1,78 @@
 /**
  * @file NDArray.h
- * @brief NDArray: a minimal NumPy-like N-dimensional float array.
+ * @brief NDArray: a minimal NumPy-like N-dimensional array.
  *
- * This header declares the NDArray class, which provides:
+ * This header declares the BasicNDArray<T> class template, which provides:
  * - Row‑major storage with explicit shape and strides
  * - Safe element access via multi-index or flat index (when contiguous)
- * - Non-owning views via slice (detached from autograd)
- * - Reshape for owning, contiguous arrays
+ * - Zero-copy views (slice with steps, transpose, permute, expand,
+ *   squeeze/unsqueeze) that participate in autograd
+ * - Reshape of any array whose layout allows it without copying
  * - Broadcasting arithmetic (+, -, /, element-wise multiply)
  * - Scalar arithmetic variants
- * - 2D matrix multiplication
+ * - 2D matrix multiplication and a fused linear layer
+ * - 1D and 2D convolutions (strided, padded, dilated, grouped)
+ * - Max/average pooling and fused layer and batch normalization
+ * - Element-wise unary ops (exp, log, tanh, sigmoid, relu, gelu, sqrt, abs)
+ * - Fused softmax, log-softmax and cross-entropy
  * - Lightweight reverse‑mode autograd for core ops
  *
  * Design notes:
  * - Memory ownership is explicit. Only base arrays (ownsData == true) allocate
- *   and manage their memory. Views never own.
- * - Autograd records lightweight operation metadata on results (except slices
- *   and clones, which are detached).
- * - Slices are detached views by default (no autograd participation). Use
- *   clone() to materialize an owning tensor when needed.
+ *   and manage their memory. Views never own, but keep the base buffer alive;
+ *   buffers are released when the last array or view using them is destroyed.
+ * - Autograd records lightweight operation metadata on results (except clones,
+ *   which are detached).
+ * - `grad` has the same layout as `data`: it is indexed with `strides`. A view
+ *   only rewrites shape/strides/offset and shares both buffers of its base,
+ *   so gradients accumulated into a view land in the base's gradient at the
+ *   same positions (summed over repeated positions of expanded axes).
+ * - Use clone() to materialize an owning tensor when needed. Clones of
+ *   contiguous arrays are copy‑on‑write: storage is shared until one side is
+ *   mutated.
+ * - Shapes, strides and indices are inline `Shape` values (at most kMaxDims
+ *   axes), so metadata never touches the heap; a new array allocates only its
+ *   data/grad buffer.
+ * - The element type is a template parameter. Kernels are compiled once per
+ *   supported type (float, double, int32_t, int64_t) in NDArray.cpp; `NDArray`
+ *   remains the float array. Shape/stride/broadcast helpers are type-agnostic
+ *   and shared by every instantiation.
  */
 #pragma once
 
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "Shape.h"
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <unordered_set>
 #include <vector>
 
-class NDArray {
+/**
+ * Accuracy of the transcendental unary ops (exp, log, tanh, sigmoid, gelu) on
+ * float arrays. Other element types always use the C++ standard library.
+ */
+enum class MathMode {
+  Accurate, /**< Vectorized exp/log/tanh/sigmoid, max error over all float
+                 inputs 1.05 / 0.85 / 1.35 / 2.5 ULP (subnormal results
+                 kept); gelu uses erf evaluated in double (0.5 ULP). */
+  Fast      /**< Shorter polynomials (relative error <= 8e-6); gelu uses the
+                 tanh approximation. */
+};
+
+/** Activation applied in the epilogue of BasicNDArray::linear(). */
+enum class Activation { None, ReLU, GELU, Tanh, Sigmoid };
+
+class SparseNDArray;
+
+template <typename T> class BasicNDArray {
+  // Sparse ops build NDArray graph nodes and report their backward cost
+  friend class SparseNDArray;
+
 private:
   /**
    * @brief Internal constructor used for creating non-owning views or
@@ -37,12 +81,25 @@ private:
    * This does not allocate memory. When ownsData == false, the lifetime of
    * the provided data pointer must outlive the NDArray instance.
    *
-   * Autograd: callers decide whether to pass graph metadata. Slice uses this
-   * constructor but returns a detached view (prev empty, op empty).
+   * Autograd: callers decide whether to pass graph metadata. A `grad` buffer
+   * covering every offset reachable through `strides` is allocated unless
+   * `grad` is given (views pass their base's gradient).
    */
-  NDArray(std::vector<int> shape, std::vector<int> strides, float *data,
-          bool ownsData, std::string label = "", std::string op = "",
-          std::vector<std::reference_wrapper<NDArray>> prev = {});
+  BasicNDArray(Shape shape, Shape strides, T *data,
+               bool ownsData, std::string label = "", std::string op = "",
+               std::vector<std::reference_wrapper<BasicNDArray>> prev = {},
+               T *grad = nullptr);
+
+  /**
+   * @brief Create a view of this array's buffers (no copy).
+   *
+   * The view shares data and grad with this array starting at `offset`, and
+   * records this array as its graph parent under `op`. Its backward is a
+   * no‑op: gradients written through the view already sit in this array's
+   * gradient.
+   */
+  BasicNDArray makeView(Shape newShape, Shape newStrides, int64_t offset,
+                        std::string op);
 
   /**
    * @brief Build a topological ordering of nodes reachable from `arr`.
@@ -51,33 +108,110 @@ private:
    * appear before children, enabling reverse‑mode backprop from outputs to
    * inputs.
    */
-  void build_topo(std::unordered_set<NDArray *> &visited, NDArray *arr,
-                  std::vector<std::reference_wrapper<NDArray>> &topo);
+  void build_topo(std::unordered_set<BasicNDArray *> &visited,
+                  BasicNDArray *arr,
+                  std::vector<std::reference_wrapper<BasicNDArray>> &topo);
+
+  /**
+   * Keeps the memory behind `data` alive for as long as any array or view
+   * references it: the array's own allocation, an adopted buffer or a file
+   * mapping. Empty for borrowed memory.
+   */
+  std::shared_ptr<void> dataOwner;
+
+  /** Owns the `grad` buffer; shared by copies of the array. */
+  std::shared_ptr<void> gradOwner;
+
+  /**
+   * Whether `data` may be shared copy‑on‑write with clones (tracked by the
+   * `dataOwner` reference count).
+   */
+  bool copyOnWrite = false;
+
+  /**
+   * Whether no other array or view holds `data`. The grad buffer of an array
+   * built by the main constructor lives in the same allocation, so its own
+   * `gradOwner` alias is not counted.
+   */
+  bool dataUnshared() const;
+
+  /**
+   * Every buffer this array used before a copy‑on‑write copy, released with
+   * the array: backward closures of earlier ops capture raw `data` pointers
+   * and may still read any of them.
+   */
+  std::vector<std::shared_ptr<void>> retiredData;
+
+  /** Nominal cost of `_backward`, reported when the profiler is enabled. */
+  OpCost backwardCost;
+
+  /**
+   * @brief Shared driver of the element‑wise unary ops.
+   *
+   * `forward(in, out, n)` maps `n` contiguous elements (`in` may equal
+   * `out`); `backward(a, y, dOut, dA, n)` accumulates into a contiguous `dA`
+   * given inputs `a` and outputs `y`. Strided inputs are gathered first and
+   * their gradient contributions scattered back through `strides`.
+   */
+  template <typename Forward, typename Backward>
+  BasicNDArray unaryOp(const std::string &opName, int64_t flopsPerElement,
+                       Forward forward, Backward backward);
+
+  /** @brief Shared implementation of softmax() and logSoftmax(). */
+  BasicNDArray softmaxAlong(int axis, bool logarithm);
+
+  /** @brief linear() for one activation (selected at compile time). */
+  template <Activation A>
+  BasicNDArray fusedLinear(BasicNDArray &weight, BasicNDArray &bias);
+
+  /**
+   * @brief Shared implementation of conv1d() and conv2d() (`bias` may be
+   *        null).
+   */
+  BasicNDArray convolution(const std::string &opName, int spatialDims,
+                           BasicNDArray &weight, BasicNDArray *bias,
+                           int64_t stride, int64_t padding, int64_t dilation,
+                           int64_t groups);
+
+  /** @brief Shared implementation of maxPool2d() and avgPool2d(). */
+  BasicNDArray pool2d(const std::string &opName, bool maximum, int64_t kernel,
+                      int64_t stride, int64_t padding);
+
+  /**
+   * @brief Shared implementation of indexSelect() and embedding(): picks
+   *        entries of `axis` and lays the result out as `outShape`.
+   */
+  BasicNDArray selectAlong(const std::string &opName, const std::string &opTag,
+                           int axis, const BasicNDArray<int64_t> &indices,
+                           Shape outShape);
 
 public:
-  /** Raw data pointer in row‑major layout. Points to `size` floats. */
-  float *data; /**< Raw data pointer in row‑major layout (length = size). */
+  /** Element type stored in `data` and `grad`. */
+  using value_type = T;
+
+  /** Raw data pointer in row‑major layout. Points to `size` elements. */
+  T *data; /**< Raw data pointer in row‑major layout (length = size). */
   /** Dimensions of the array, e.g. {rows, cols} for 2D. */
-  std::vector<int> shape; /**< Shape dimensions; product equals `size`. */
+  Shape shape; /**< Shape dimensions; product equals `size`. */
   /** Row‑major strides in elements; stride[i] is step for axis i. */
-  std::vector<int> strides; /**< Row‑major strides per axis (in elements). */
+  Shape strides; /**< Row‑major strides per axis (in elements). */
   /** Number of dimensions (shape.size()). */
   int ndim; /**< Number of axes. */
   /** Total number of elements (product of `shape`). */
-  int size = 0; /**< Total element count. */
+  int64_t size = 0; /**< Total element count (may exceed 2^31). */
   /** Whether this NDArray owns and manages the memory referenced by `data`.
    */
   bool ownsData; /**< True if this tensor allocated and owns its memory. */
 
-  /** Gradient buffer aligned with logical indexing (allocated when
-   * constructed). */
-  float *grad; /**< Gradient storage parallel to `data`. */
+  /** Gradient buffer with the same layout as `data` (indexed with
+   * `strides`; shared with the base for views). */
+  T *grad; /**< Gradient storage parallel to `data`. */
   /** Operation tag for debug/inspection (e.g. "+", "-", "elem_mul", "*"). */
   std::string op; /**< Debug op tag. */
   /** Optional human‑readable label for this tensor. */
   std::string label; /**< User/debug label. */
-  /** Parents in autograd graph. Empty for detached tensors (slice/clone). */
-  std::vector<std::reference_wrapper<NDArray>> prev; /**< Graph parents. */
+  /** Parents in autograd graph. Empty for leaves and detached clones. */
+  std::vector<std::reference_wrapper<BasicNDArray>> prev; /**< Graph parents. */
   /** Select between printing data or gradient buffers. */
   enum class PrintType { Data, Grad }; /**< Print selector. */
   /** Backpropagation closure; invoked during backward(). */
@@ -90,8 +224,39 @@ public:
    * `ownsData = true`. This constructor creates a base tensor that can
    * participate in autograd.
    */
-  NDArray(std::vector<int> shape, std::string label = "", std::string op = "",
-          std::vector<std::reference_wrapper<NDArray>> prev = {});
+  BasicNDArray(Shape shape, std::string label = "",
+               std::string op = "",
+               std::vector<std::reference_wrapper<BasicNDArray>> prev = {});
+
+  /**
+   * @brief Wrap an existing row‑major buffer without copying.
+   *
+   * Equivalent to fromBuffer(data, shape, strides, deleter) with standard
+   * row‑major strides.
+   */
+  static BasicNDArray fromBuffer(T *data, Shape shape,
+                                 std::function<void(T *)> deleter = nullptr);
+
+  /**
+   * @brief Wrap an existing buffer with explicit strides without copying.
+   *
+   * With a `deleter`, the array adopts the buffer: `deleter(data)` is called
+   * once the last array or view referencing it is destroyed, so producers can
+   * release through their own allocator. A contiguous adopted buffer behaves
+   * like a base array (`ownsData == true`). Without a deleter the buffer is
+   * borrowed (`ownsData == false`) and must outlive every array using it.
+   * The result is a fresh leaf for autograd; only `grad` is allocated.
+   *
+   * @param data Pointer to the first element
+   * @param shape Dimensions of the array
+   * @param strides Per‑axis steps in elements (length == shape.size())
+   * @param deleter Release callback, or nullptr to borrow
+   * @throws std::invalid_argument if shape/strides lengths differ, a dimension
+   *         is negative, or data is null for a non-empty shape. Ownership is
+   *         not transferred when this throws.
+   */
+  static BasicNDArray fromBuffer(T *data, Shape shape, Shape strides,
+                                 std::function<void(T *)> deleter = nullptr);
 
   /**
    * @brief Print selected metadata fields.
@@ -112,7 +277,7 @@ public:
    * @return The element value
    * @throws std::invalid_argument if indices.size() != ndim
    */
-  float get(std::vector<int> indices, PrintType type = PrintType::Data) const;
+  T get(const Shape &indices, PrintType type = PrintType::Data) const;
 
   /**
    * @brief Read an element by flat index.
@@ -126,7 +291,7 @@ public:
    * @throws std::out_of_range if index is outside [0, size)
    * @throws std::runtime_error if the array is not contiguous or not owning
    */
-  float get(int index, PrintType type = PrintType::Data) const;
+  T get(int64_t index, PrintType type = PrintType::Data) const;
 
   /**
    * @brief Write an element by multi‑dimensional indices.
@@ -134,7 +299,7 @@ public:
    * @param value Value to write into data buffer
    * @throws std::invalid_argument if indices.size() != ndim
    */
-  void set(std::vector<int> indices, float value);
+  void set(const Shape &indices, T value);
 
   /**
    * @brief Write an element by flat index.
@@ -147,22 +312,81 @@ public:
    * @throws std::out_of_range if index is outside [0, size)
    * @throws std::runtime_error if the array is not contiguous or not owning
    */
-  void set(int index, float value);
+  void set(int64_t index, T value);
 
   /**
    * @brief Return a non‑owning view restricted by per‑axis [start, stop)
    * slices.
    *
-   * The returned NDArray shares `data` with the base tensor and has updated
-   * shape/strides/offset. It is DETACHED from autograd: no graph is recorded
-   * and its `_backward` is a no‑op.
+   * The returned NDArray shares `data` and `grad` with the base tensor and
+   * has updated shape/strides/offset. Gradients flowing into the view are
+   * accumulated into the corresponding positions of the base.
    *
    * @param indices A vector (length == ndim) of (start, stop) pairs, inclusive
    *        start and exclusive stop for each axis
-   * @return A detached view (non‑owning)
-   * @throws std::invalid_argument if the number of slices != ndim
+   * @return A view (non‑owning)
+   * @throws std::invalid_argument if the number of slices != ndim or a range
+   *         is out of bounds
    */
-  NDArray slice(std::vector<std::tuple<int, int>> indices);
+  BasicNDArray slice(std::vector<std::tuple<int64_t, int64_t>> indices);
+
+  /**
+   * @brief Strided slice: per‑axis (start, stop, step) ranges.
+   *
+   * Selects start, start + step, ... up to (excluding) stop, like Python's
+   * `a[start:stop:step]` without wrap-around. Negative steps walk backwards
+   * (use stop == -1 to include index 0). The view's strides are the base
+   * strides times the steps; autograd as for slice().
+   *
+   * @throws std::invalid_argument if the number of slices != ndim, a step is
+   *         0 or a selected index is out of bounds
+   */
+  BasicNDArray
+  slice(std::vector<std::tuple<int64_t, int64_t, int64_t>> indices);
+
+  /**
+   * @brief Swap two axes (default: the last two). Zero-copy view.
+   * @throws std::invalid_argument if ndim < 2 or an axis is out of range
+   */
+  BasicNDArray transpose(int axis0 = -2, int axis1 = -1);
+
+  /**
+   * @brief Reorder axes: result axis i is input axis `axes[i]`. Zero-copy
+   * view.
+   * @throws std::invalid_argument if `axes` is not a permutation of the axes
+   */
+  BasicNDArray permute(Shape axes);
+
+  /**
+   * @brief Broadcast to `newShape` without copying.
+   *
+   * Size‑1 axes and new leading axes get stride 0, so every position along
+   * them reads the same element. In backward, the gradients of those
+   * positions are summed into that element.
+   *
+   * @throws std::invalid_argument if the shape is not broadcastable to
+   *         `newShape`
+   */
+  BasicNDArray expand(Shape newShape);
+
+  /**
+   * @brief Remove all size‑1 axes (keeps one axis for single-element arrays).
+   * Zero-copy view.
+   */
+  BasicNDArray squeeze();
+
+  /**
+   * @brief Remove a size‑1 axis (supports negative axes). Zero-copy view.
+   * @throws std::invalid_argument if the axis is out of range or not size 1
+   */
+  BasicNDArray squeeze(int axis);
+
+  /**
+   * @brief Insert a size‑1 axis at `axis` (in [-ndim-1, ndim]). Zero-copy
+   * view.
+   * @throws std::invalid_argument if the axis is out of range
+   */
+  BasicNDArray unsqueeze(int axis);
 
   /**
    * @brief Whether the logical layout matches standard row‑major contiguous
@@ -173,14 +397,18 @@ public:
   /**
    * @brief Reshape this array to a new shape with the same number of elements.
    *
-   * Only allowed for owning, contiguous arrays. Updates `shape` and recomputes
-   * `strides` to standard row‑major.
+   * Never copies: updates `shape` and `strides` in place. Contiguous arrays get
+   * standard row‑major strides; views (transposed, strided, expanded) can be
+   * reshaped when the axes being merged or split are laid out contiguously
+   * relative to each other, e.g. splitting any axis or merging the rows of a
+   * column slice.
    *
    * @param newShape Target shape (product must equal current size)
-   * @throws std::runtime_error if the array is not owning or not contiguous
+   * @throws std::runtime_error if the layout cannot be reshaped without a copy
+   *         (clone() first)
    * @throws std::invalid_argument if newShape is empty or incompatible in size
    */
-  void reshape(std::vector<int> newShape);
+  void reshape(Shape newShape);
 
   /**
    * @brief Pretty‑print the data or gradients.
@@ -200,7 +428,7 @@ public:
    * @brief Fill with a constant value.
    * @throws std::runtime_error if the array does not own its memory
    */
-  void fill(float value);
+  void fill(T value);
 
   /**
    * @brief Set all elements to 0.
@@ -214,24 +442,67 @@ public:
 
   /**
    * @brief Fill with uniform integer values in [low, high).
+   *
+   * Like every random fill, draws from `generator` (the global one by
+   * default): element i depends only on the generator's seed and position in
+   * its stream, so results are reproducible for a given seed and identical
+   * for any number of threads.
+   *
    * @param low Inclusive lower bound
    * @param high Exclusive upper bound
+   * @param generator Source of randomness
+   * @throws std::invalid_argument if low >= high
    * @throws std::runtime_error if the array does not own its memory
    */
-  void randint(int low, int high);
+  void randint(int low, int high, Generator &generator = Generator::global());
 
   /**
    * @brief Fill with uniform real values in [0, 1).
-   * @throws std::runtime_error if the array does not own its memory
+   * @throws std::runtime_error if the array does not own its memory or the
+   *         element type is not floating point
    */
-  void rand();
+  void rand(Generator &generator = Generator::global());
 
   /**
-   * @brief Fill with uniform real values in [low, high).
+   * @brief Fill with uniform values in [low, high).
+   *
+   * Real-valued for floating point element types, integer-valued for integer
+   * element types.
+   *
    * @throws std::invalid_argument if low >= high
    * @throws std::runtime_error if the array does not own its memory
    */
-  void rand(float low, float high);
+  void rand(T low, T high, Generator &generator = Generator::global());
+
+  /**
+   * @brief Fill with normally distributed values (Box–Muller).
+   * @param mean Mean of the distribution
+   * @param stddev Standard deviation (non-negative)
+   * @throws std::invalid_argument if stddev < 0
+   * @throws std::runtime_error if the array does not own its memory or the
+   *         element type is not floating point
+   */
+  void randn(T mean = T(0), T stddev = T(1),
+             Generator &generator = Generator::global());
+
+  /**
+   * @brief Fill with Bernoulli samples: 1 with probability `p`, else 0.
+   * @throws std::invalid_argument if p is outside [0, 1]
+   * @throws std::runtime_error if the array does not own its memory
+   */
+  void bernoulli(double p, Generator &generator = Generator::global());
+
+  /**
+   * @brief Fill with an inverted-dropout mask for drop probability `p`.
+   *
+   * Each element is 0 with probability `p` and 1 / (1 - p) otherwise, so
+   * `x.element_wise_multiply(mask)` keeps the expected value of `x`.
+   *
+   * @throws std::invalid_argument if p is outside [0, 1)
+   * @throws std::runtime_error if the array does not own its memory or the
+   *         element type is not floating point
+   */
+  void dropoutMask(double p, Generator &generator = Generator::global());
 
   /**
    * @brief Broadcasted element‑wise addition (this + other).
@@ -239,50 +510,202 @@ public:
    * Autograd: result records graph metadata and accumulates dA += dOut and
    * dB += dOut with broadcasting.
    */
-  NDArray operator+(NDArray &other);
+  BasicNDArray operator+(BasicNDArray &other);
 
   /**
    * @brief Scalar addition (this + value), shape‑preserving.
    */
-  NDArray operator+(float value);
+  BasicNDArray operator+(T value);
 
   /**
    * @brief Broadcasted element‑wise subtraction (this - other).
    *
    * Autograd: dA += dOut, dB += -dOut with broadcasting.
    */
-  NDArray operator-(NDArray &other);
+  BasicNDArray operator-(BasicNDArray &other);
 
   /**
    * @brief Scalar subtraction (this - value), shape‑preserving.
    */
-  NDArray operator-(float value);
+  BasicNDArray operator-(T value);
 
   /**
    * @brief 2D matrix multiplication (no broadcasting).
+   *
+   * Operands may have any 2D strides (row‑major, column‑major/transposed,
+   * padded rows, slices); the kernel reads them in place without a
+   * contiguous copy.
+   *
    * @throws std::invalid_argument if either input is not 2D or dims mismatch
-   * Autograd: implements dA = dC * B^T and dB = A^T * dC.
+   * Autograd: implements dA = dC * B^T and dB = A^T * dC, with the transposes
+   * expressed through strides (never materialized).
+   */
+  BasicNDArray operator*(BasicNDArray &other);
+
+  /**
+   * @brief Fused linear layer: activation(this * weight + bias).
+   *
+   * `this` is (m x k), `weight` (k x n) and `bias` has n elements (shape {n}
+   * or {1, n}). The GEMM adds the bias and applies the activation to each
+   * output tile right after computing it, so no intermediate is
+   * materialized. Autograd: one pass forms dZ = dOut * activation'(Z) and
+   * reduces it over rows into dBias; two GEMMs give dThis += dZ * weight^T
+   * and dWeight += this^T * dZ. GELU keeps its pre‑activation for backward;
+   * the other activations differentiate from the output.
+   *
+   * @throws std::invalid_argument if the shapes do not match
+   * @throws std::runtime_error for GELU, Tanh or Sigmoid on integer arrays
    */
-  NDArray operator*(NDArray &other);
+  BasicNDArray linear(BasicNDArray &weight, BasicNDArray &bias,
+                      Activation activation = Activation::None);
+
+  /**
+   * @brief Einstein summation, e.g. einsum("bij,bjk->bik", {a, b}).
+   *
+   * Each comma-separated term labels the axes of one operand with letters;
+   * labels after "->" name the output axes (without "->": the labels used
+   * once, in alphabetical order, uppercase first). A label repeated within a
+   * term takes a diagonal, and labels missing from the output are summed.
+   * Ellipses are not supported.
+   *
+   * Labels used by a single operand are summed first; the operands are then
+   * contracted pairwise in the order with the fewest multiply-adds (searched
+   * exhaustively up to 10 operands, greedily beyond), each step lowered to a
+   * GEMM per batch index. Operands and the output are read and written
+   * through their strides when their labels merge into GEMM axes, and packed
+   * otherwise. Autograd: the gradient of each operand is the einsum of dOut
+   * with the other operands, evaluated the same way.
+   *
+   * @return A new contiguous array (shape {1} for a scalar output)
+   * @throws std::invalid_argument on a malformed equation, a term that does
+   *         not match its operand's rank, or inconsistent label extents
+   */
+  static BasicNDArray
+  einsum(const std::string &equation,
+         std::vector<std::reference_wrapper<BasicNDArray>> operands);
+
+  /** @brief einsum() over operands passed as arguments. */
+  template <typename... Rest>
+  static BasicNDArray einsum(const std::string &equation, BasicNDArray &first,
+                             Rest &...rest) {
+    return einsum(equation, {std::ref(first), std::ref(rest)...});
+  }
+
+  /**
+   * @brief 2D convolution (cross-correlation) of (N, C, H, W) input with
+   *        (O, C / groups, kH, kW) weights and an (O) bias.
+   *
+   * Output is (N, O, Ho, Wo) with Ho = (H + 2 * padding - dilation * (kH -
+   * 1) - 1) / stride + 1 (same for Wo). Lowered to im2col + GEMM per image
+   * and group; 1x1 kernels (unit stride, no padding) multiply the input
+   * directly and depthwise convolutions (one input channel per group) use a
+   * direct kernel. Parallel across images and groups. Autograd: dInput,
+   * dWeight and dBias.
+   *
+   * @throws std::invalid_argument if shapes, groups or the geometry do not
+   *         match
+   */
+  BasicNDArray conv2d(BasicNDArray &weight, BasicNDArray &bias,
+                      int64_t stride = 1, int64_t padding = 0,
+                      int64_t dilation = 1, int64_t groups = 1);
+
+  /** @brief conv2d() without a bias. */
+  BasicNDArray conv2d(BasicNDArray &weight, int64_t stride = 1,
+                      int64_t padding = 0, int64_t dilation = 1,
+                      int64_t groups = 1);
+
+  /**
+   * @brief 1D convolution of (N, C, L) input with (O, C / groups, k)
+   *        weights and an (O) bias; output (N, O, Lo). Same lowering and
+   *        autograd as conv2d().
+   */
+  BasicNDArray conv1d(BasicNDArray &weight, BasicNDArray &bias,
+                      int64_t stride = 1, int64_t padding = 0,
+                      int64_t dilation = 1, int64_t groups = 1);
+
+  /** @brief conv1d() without a bias. */
+  BasicNDArray conv1d(BasicNDArray &weight, int64_t stride = 1,
+                      int64_t padding = 0, int64_t dilation = 1,
+                      int64_t groups = 1);
+
+  /**
+   * @brief 2D max pooling of (N, C, H, W) input over kernel x kernel windows.
+   *
+   * @param stride Window step (0: same as kernel)
+   * @param padding Implicit padding on each side, at most kernel / 2; padded
+   *        positions never win
+   *
+   * The offset of each window's maximum is cached, so backward routes dOut
+   * straight to it. Planes are processed in parallel.
+   *
+   * @throws std::invalid_argument on a bad geometry
+   */
+  BasicNDArray maxPool2d(int64_t kernel, int64_t stride = 0,
+                         int64_t padding = 0);
+
+  /**
+   * @brief 2D average pooling of (N, C, H, W) input; same geometry as
+   *        maxPool2d(). Padded positions count as zeros in the average.
+   *
+   * @throws std::runtime_error on integer arrays
+   */
+  BasicNDArray avgPool2d(int64_t kernel, int64_t stride = 0,
+                         int64_t padding = 0);
+
+  /**
+   * @brief Layer normalization over the last axis:
+   *        (x - mean) / sqrt(var + eps) * gamma + beta.
+   *
+   * gamma and beta have shape {features}. Mean and variance come from one
+   * Welford pass per row and the affine transform is applied in the same
+   * sweep that normalizes. Fused backward for x, gamma and beta: rows in
+   * parallel for dx, blocks of features for dGamma and dBeta.
+   *
+   * @throws std::invalid_argument if gamma or beta do not match
+   * @throws std::runtime_error on integer arrays
+   */
+  BasicNDArray layerNorm(BasicNDArray &gamma, BasicNDArray &beta,
+                         T eps = T(1e-5));
+
+  /**
+   * @brief Batch normalization of (N, C, ...) input per channel.
+   *
+   * In training, normalizes with the batch mean and (biased) variance from
+   * a Welford pass per channel and updates `runningMean` and `runningVar`
+   * in place with `momentum` (unbiased variance); otherwise normalizes with
+   * the running statistics. gamma, beta and the running statistics have
+   * shape {C}. Fused backward for x, gamma and beta, parallel across
+   * channels.
+   *
+   * @throws std::invalid_argument on shape mismatch or a single value per
+   *         channel in training
+   * @throws std::runtime_error on integer arrays
+   */
+  BasicNDArray batchNorm(BasicNDArray &gamma, BasicNDArray &beta,
+                         BasicNDArray &runningMean, BasicNDArray &runningVar,
+                         bool training = true, T momentum = T(0.1),
+                         T eps = T(1e-5));
 
   /**
    * @brief Scalar element wise multiplication (no broadcasting).
    * @param value Value to multiply array with.
    */
-  NDArray operator*(float value);
+  BasicNDArray operator*(T value);
 
   /**
    * @brief Broadcasted element‑wise division (this / other).
    *
-   * Warns on division by zero. Autograd: dA += dOut / other, dB += -(this /
-   * other^2) * dOut.
+   * Warns on division by zero (throws std::domain_error for integer element
+   * types). Autograd: dA += dOut / other, dB += -(this / other^2) * dOut.
    */
-  NDArray operator/(NDArray &other);
+  BasicNDArray operator/(BasicNDArray &other);
 
   /**
    * @brief Scalar division (this / value), shape‑preserving, warns on zero.
+   *
+   * Integer element types throw std::domain_error instead of warning.
    */
-  NDArray operator/(float value);
+  BasicNDArray operator/(T value);
 
   /**
    * @brief Scalar element-wise power (this ^ value).
@@ -290,19 +713,71 @@ public:
    * Raises each element to the given scalar power. Autograd: dA += value *
    * A^(value - 1) * dOut.
    */
-  NDArray operator^(float value);
+  BasicNDArray operator^(float value);
+
+  /**
+   * @brief Element‑wise e^x. Autograd: dA += out * dOut.
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray exp(MathMode mode = MathMode::Accurate);
+
+  /**
+   * @brief Element‑wise natural logarithm (NaN below 0, -inf at 0).
+   *
+   * Autograd: dA += dOut / this; contributions at 0 are skipped.
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray log(MathMode mode = MathMode::Accurate);
+
+  /**
+   * @brief Element‑wise hyperbolic tangent. Autograd: dA += (1 - out^2) *
+   *        dOut.
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray tanh(MathMode mode = MathMode::Accurate);
+
+  /**
+   * @brief Element‑wise logistic function 1 / (1 + e^-x). Autograd: dA +=
+   *        out * (1 - out) * dOut.
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray sigmoid(MathMode mode = MathMode::Accurate);
+
+  /** @brief Element‑wise max(x, 0). Autograd: dA += (this > 0) * dOut. */
+  BasicNDArray relu();
+
+  /**
+   * @brief Element‑wise GELU, x * Phi(x).
+   *
+   * `Accurate` evaluates the exact erf form; `Fast` the tanh approximation
+   * 0.5x(1 + tanh(sqrt(2/pi)(x + 0.044715x^3))), with the matching
+   * derivative in backward.
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray gelu(MathMode mode = MathMode::Accurate);
+
+  /**
+   * @brief Element‑wise square root (NaN below 0).
+   *
+   * Autograd: dA += dOut / (2 * out); contributions at 0 are skipped.
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray sqrt();
+
+  /** @brief Element‑wise |x|. Autograd: dA += sign(this) * dOut. */
+  BasicNDArray abs();
 
   /**
    * @brief Broadcasted element‑wise multiplication.
    *
    * Autograd: dA += other * dOut; dB += this * dOut.
    */
-  NDArray element_wise_multiply(NDArray &other);
+  BasicNDArray element_wise_multiply(BasicNDArray &other);
 
   /**
    * @brief Scalar element‑wise multiplication (this * value).
    */
-  NDArray element_wise_multiply(float value);
+  BasicNDArray element_wise_multiply(T value);
 
   /**
    * @brief Reduce all elements to a scalar sum.
@@ -310,7 +785,7 @@ public:
    * Returns a 1-element NDArray holding the total sum. Autograd: distributes
    * the upstream gradient uniformly to every input element (dA += 1 * dOut).
    */
-  NDArray sum();
+  BasicNDArray sum();
 
   /**
    * @brief Sum along a specified axis (keep dimension as size 1).
@@ -322,7 +797,103 @@ public:
    * @param axis The axis along which to compute the sum (supports negatives)
    * @throws std::invalid_argument if axis is out of range after normalization
    */
-  NDArray sum(int axis);
+  BasicNDArray sum(int axis);
+
+  /**
+   * @brief Softmax along `axis`: exp(x - max) / sum(exp(x - max)).
+   *
+   * Fused and overflow‑free: each row is read once to find its max and sum
+   * together (partial sums are rescaled when the max rises) and once to write
+   * the result; rows run in parallel with OpenMP. Autograd: dA += out *
+   * (dOut - sum(dOut * out)) per row.
+   *
+   * @param axis Axis to normalize over (supports negatives)
+   * @throws std::invalid_argument if axis is out of range
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray softmax(int axis = -1);
+
+  /**
+   * @brief Log‑softmax along `axis`: x - max - log(sum(exp(x - max))).
+   *
+   * Same single‑pass fused kernel as softmax(). Autograd: dA += dOut -
+   * exp(out) * sum(dOut) per row.
+   *
+   * @param axis Axis to normalize over (supports negatives)
+   * @throws std::invalid_argument if axis is out of range
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray logSoftmax(int axis = -1);
+
+  /**
+   * @brief Mean cross‑entropy of logits (classes along the last axis)
+   *        against class indices.
+   *
+   * `targets` holds one class per row of logits (any shape with that many
+   * elements). Returns a 1‑element array with mean(logsumexp(row) -
+   * row[target]), computed in one pass per row without materializing
+   * probabilities. Autograd: dA += (softmax(row) - onehot(target)) * dOut /
+   * rows, recomputed from the saved per‑row logsumexp.
+   *
+   * @throws std::invalid_argument if the number of targets does not match
+   * @throws std::out_of_range if a target is not a valid class index
+   * @throws std::runtime_error for integer element types
+   */
+  BasicNDArray crossEntropy(const BasicNDArray<int64_t> &targets);
+
+  /**
+   * @brief Pick entries along `axis` by index: the result has `axis` of
+   *        length indices.size, holding entry indices[i] at position i.
+   *
+   * Whole slices are copied in parallel. Autograd touches only the selected
+   * slices: indices are sorted once, and each distinct index accumulates the
+   * grads of all its positions (in position order) on one thread.
+   *
+   * @param axis Axis to select along (supports negatives)
+   * @param indices Indices into `axis`, read in row‑major order (any shape)
+   * @throws std::invalid_argument if axis is out of range
+   * @throws std::out_of_range if an index is outside [0, shape[axis])
+   */
+  BasicNDArray indexSelect(int axis, const BasicNDArray<int64_t> &indices);
+
+  /**
+   * @brief Look up rows of this table: shape indices.shape + shape[1:].
+   *
+   * Same kernel and sparse backward as indexSelect(0, indices); only the
+   * looked‑up rows of the table's grad are written.
+   *
+   * @throws std::invalid_argument if this array is a scalar
+   * @throws std::out_of_range if an index is outside [0, shape[0])
+   */
+  BasicNDArray embedding(const BasicNDArray<int64_t> &indices);
+
+  /**
+   * @brief out[..., j, ...] = this[..., index[..., j, ...], ...] along
+   *        `axis`; the result has the shape of `index`.
+   *
+   * `index` has the same rank as this array and no larger extent on the
+   * other axes. Autograd adds each output grad to the element it was read
+   * from.
+   *
+   * @throws std::invalid_argument on a bad axis or index shape
+   * @throws std::out_of_range if an index is outside [0, shape[axis])
+   */
+  BasicNDArray gather(int axis, const BasicNDArray<int64_t> &index);
+
+  /**
+   * @brief Copy of this array with src[..., j, ...] added at
+   *        [..., index[..., j, ...], ...] along `axis`.
+   *
+   * `index` has the same rank as this array and `src`, no larger extent than
+   * `src` on any axis and than this array on the other axes. Repeated
+   * indices accumulate in index order. Autograd: dThis += dOut and dSrc +=
+   * gather(dOut, axis, index).
+   *
+   * @throws std::invalid_argument on a bad axis or index/src shape
+   * @throws std::out_of_range if an index is outside [0, shape[axis])
+   */
+  BasicNDArray scatterAdd(int axis, const BasicNDArray<int64_t> &index,
+                          BasicNDArray &src);
 
   /**
    * @brief Reverse‑mode backprop: accumulate gradients into all reachable
@@ -336,8 +907,73 @@ public:
   /**
    * @brief Materialize a contiguous, owning copy. Detached from autograd.
    *
-   * If the source is contiguous, performs a fast contiguous copy; otherwise
-   * uses a stride‑aware copy. The returned tensor has no graph linkage.
+   * A contiguous source whose buffer is not aliased by views shares that
+   * buffer copy‑on‑write: no data is copied until either side is written
+   * (set, fill*, rand*, ensureUnique) or a view is taken of it. Other sources
+   * are copied eagerly with a stride‑aware copy. The returned tensor has no
+   * graph linkage.
+   */
+  BasicNDArray clone();
+
+  /**
+   * @brief Give this array a private copy of copy‑on‑write shared data.
+   *
+   * Called by every mutating member. Call it before writing through `data`
+   * directly if the array may be (or have) a clone(); no‑op otherwise.
+   */
+  void ensureUnique();
+
+  /**
+   * @brief Convert to another element type. Detached from autograd.
+   *
+   * Returns a contiguous, owning array whose elements are `static_cast<U>` of
+   * the source elements (stride‑aware for views).
+   */
+  template <typename U> BasicNDArray<U> astype() const;
+
+  /**
+   * @brief Load an array from a NumPy `.npy` file.
+   *
+   * The file's dtype must match the element type (`<f4`, `<f8`, `<i4`, `<i8`).
+   * With `mapped == true` the file is memory-mapped (private, copy-on-write
+   * pages) and the result is a non‑owning array directly over the mapped
+   * data: no parse of the payload, no copy. The mapping stays alive as long as
+   * the array or any view of it does. Fortran-ordered files map to
+   * column-major strides. With `mapped == false` the payload is read into a
+   * new owning, contiguous array in one large read.
+   *
+   * @param path Path of the `.npy` file
+   * @param mapped Whether to memory-map instead of reading
+   * @throws std::runtime_error if the file cannot be opened, mapped or read,
+   *         or its header is malformed
+   * @throws std::invalid_argument if the dtype does not match the element type
    */
-  NDArray clone();
+  static BasicNDArray loadNpy(const std::string &path, bool mapped = true);
+
+  /**
+   * @brief Save the array to a NumPy `.npy` file (format version 1.0).
+   *
+   * Contiguous arrays are written with a single sequential write; views are
+   * gathered into large chunks first. Only data is saved (no grad, no graph).
+   *
+   * @param path Destination path (overwritten)
+   * @throws std::runtime_error if the file cannot be written
+   */
+  void saveNpy(const std::string &path) const;
 };
+
+/** The float array: the library's primary type. */
+using NDArray = BasicNDArray<float>;
+/** Double-precision array (e.g. for accumulation checks). */
+using NDArrayF64 = BasicNDArray<double>;
+/** 32-bit integer array (e.g. index tensors). */
+using NDArrayI32 = BasicNDArray<int32_t>;
+/** 64-bit integer array (e.g. index tensors). */
+using NDArrayI64 = BasicNDArray<int64_t>;
+
+// Member definitions live in NDArray.cpp and are explicitly instantiated there
+// for the supported element types only.
+extern template class BasicNDArray<float>;
+extern template class BasicNDArray<double>;
+extern template class BasicNDArray<int32_t>;
+extern template class BasicNDArray<int64_t>;
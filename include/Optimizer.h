@@ -0,0 +1,165 @@
+/**
+ * @file Optimizer.h
+ * @brief Optimizers: SGD (momentum, Nesterov), Adam and AdamW over NDArrays.
+ *
+ * This header declares the Optimizer base class and its SGD, Adam and AdamW
+ * implementations, which provide:
+ * - A parameter list updated from the grads left by backward()
+ * - A fused update that walks every parameter in one parallel pass, applying
+ *   gradient scaling, weight decay, the optimizer state update and the
+ *   parameter update in a single pass over each buffer
+ * - Gradient clipping by global norm, either folded into step() as a grad
+ *   multiplier (one extra read of the grads) or applied to them with
+ *   clipGradNorm()
+ * - Bulk zeroing of all grads with zeroGrad()
+ *
+ * Design notes:
+ * - Parameters must be contiguous, so data, grad and optimizer state share
+ *   one flat layout and every loop is unit-stride and auto-vectorized.
+ * - The update is split into fixed-size chunks spanning all parameters;
+ *   threads take whole chunks, so small tensors are batched together and
+ *   large ones are split.
+ * - The global norm is reduced per chunk and then over chunks in a fixed
+ *   order, so results do not depend on the number of threads.
+ * - Parameters are held by reference and must outlive the optimizer; their
+ *   buffers are made unique (copy-on-write) before each update.
+ */
+#pragma once
+
+#include "NDArray.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/** Options of SGD. */
+struct SGDOptions {
+  float lr = 0.01f;          /**< Learning rate. */
+  float momentum = 0.0f;     /**< Momentum factor (0 disables the buffer). */
+  bool nesterov = false;     /**< Nesterov momentum (requires momentum > 0). */
+  float weightDecay = 0.0f;  /**< L2 penalty added to the gradient. */
+  float maxGradNorm = 0.0f;  /**< Clip the global grad norm (0 disables). */
+};
+
+/** Options of Adam and AdamW. */
+struct AdamOptions {
+  float lr = 1e-3f;          /**< Learning rate. */
+  float beta1 = 0.9f;        /**< Decay of the first moment estimate. */
+  float beta2 = 0.999f;      /**< Decay of the second moment estimate. */
+  float eps = 1e-8f;         /**< Added to the denominator for stability. */
+  float weightDecay = 0.0f;  /**< L2 penalty (Adam) or decoupled (AdamW). */
+  float maxGradNorm = 0.0f;  /**< Clip the global grad norm (0 disables). */
+};
+
+class Optimizer {
+public:
+  /**
+   * @brief Hold `params` for updates.
+   * @throws std::invalid_argument if a parameter is non-contiguous or listed
+   *         twice
+   */
+  explicit Optimizer(std::vector<std::reference_wrapper<NDArray>> params);
+  virtual ~Optimizer() = default;
+
+  /** @brief Apply one update from the current grads. */
+  virtual void step() = 0;
+
+  /** @brief Set the grads of all parameters to zero. */
+  void zeroGrad();
+
+  /** @brief Global L2 norm of all parameter grads. */
+  float gradNorm() const;
+
+  /**
+   * @brief Scale all grads so that their global L2 norm is at most
+   *        `maxNorm`.
+   * @return The norm before clipping
+   * @throws std::invalid_argument if maxNorm is not positive
+   */
+  float clipGradNorm(float maxNorm);
+
+  /** @brief Parameters updated by this optimizer. */
+  const std::vector<std::reference_wrapper<NDArray>> &parameters() const {
+    return params;
+  }
+
+  /** Number of steps taken so far. */
+  int64_t steps = 0; /**< Incremented by step(). */
+
+protected:
+  /** A slice of one parameter processed by a single thread. */
+  struct Chunk {
+    int tensor;    /**< Index into `params`. */
+    int64_t begin; /**< First element within the parameter. */
+    int64_t count; /**< Number of elements. */
+    int64_t state; /**< Offset of the slice in flat optimizer state. */
+  };
+
+  /** @brief Make parameter buffers unique before writing them. */
+  void prepare();
+
+  /**
+   * @brief Grad multiplier implementing clipping to `maxNorm` (1 when
+   *        disabled or below the limit).
+   */
+  float clipScale(float maxNorm) const;
+
+  /** @brief Run `kernel(chunk)` over all chunks, in parallel when large. */
+  void forEachChunk(const std::function<void(const Chunk &)> &kernel) const;
+
+  std::vector<std::reference_wrapper<NDArray>> params; /**< Parameters. */
+  std::vector<Chunk> chunks; /**< Chunks covering every parameter. */
+  int64_t totalSize = 0;     /**< Total parameter element count. */
+};
+
+/** Stochastic gradient descent with optional momentum and weight decay. */
+class SGD : public Optimizer {
+public:
+  /**
+   * @throws std::invalid_argument on a negative rate, momentum or weight
+   *         decay, or Nesterov without momentum
+   */
+  SGD(std::vector<std::reference_wrapper<NDArray>> params,
+      SGDOptions options = {});
+
+  /** @brief p -= lr * (g + momentum * buf) (Nesterov) or lr * buf. */
+  void step() override;
+
+  SGDOptions options; /**< Hyperparameters, may be changed between steps. */
+
+private:
+  std::vector<float> momentumBuffer; /**< Flat momentum state. */
+};
+
+/** Adam with L2 weight decay added to the gradient. */
+class Adam : public Optimizer {
+public:
+  /**
+   * @throws std::invalid_argument on a negative rate, eps or weight decay, or
+   *         betas outside [0, 1)
+   */
+  Adam(std::vector<std::reference_wrapper<NDArray>> params,
+       AdamOptions options = {});
+
+  /** @brief Bias-corrected Adam update. */
+  void step() override;
+
+  AdamOptions options; /**< Hyperparameters, may be changed between steps. */
+
+protected:
+  /** @param decoupled Apply weight decay to the parameter (AdamW). */
+  Adam(std::vector<std::reference_wrapper<NDArray>> params,
+       AdamOptions options, bool decoupled);
+
+private:
+  bool decoupled;                  /**< Decoupled weight decay (AdamW). */
+  std::vector<float> firstMoment;  /**< Flat first moment estimates. */
+  std::vector<float> secondMoment; /**< Flat second moment estimates. */
+};
+
+/** Adam with decoupled weight decay: p -= lr * weightDecay * p. */
+class AdamW : public Adam {
+public:
+  /** @copydoc Adam::Adam */
+  AdamW(std::vector<std::reference_wrapper<NDArray>> params,
+        AdamOptions options = {});
+};
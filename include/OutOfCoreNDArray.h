@@ -0,0 +1,177 @@
+/**
+ * @file OutOfCoreNDArray.h
+ * @brief OutOfCoreNDArray: file-backed float arrays processed tile by tile.
+ *
+ * This header declares the OutOfCoreNDArray class, which provides:
+ * - Float arrays whose data lives in a `.npy` file instead of memory
+ * - Tiles along axis 0 (blocks of whole rows) loaded on demand
+ * - Broadcasting element-wise and scalar arithmetic, `sum`, `sum(axis)` and
+ *   2D matrix multiplication that run one tile at a time
+ * - Read-ahead: the next tile is read on a background thread while the
+ *   current one is being computed on
+ *
+ * Design notes:
+ * - Resident memory is bounded by a few tiles (inputs being read ahead, the
+ *   tile in flight and its result), independent of the array size.
+ * - Tiles are ordinary NDArrays, so every op reuses the in-memory kernels.
+ * - Results are written to new files: temporary ones (deleted with the last
+ *   handle) unless a path is given. Backing files are plain C-ordered `.npy`
+ *   files, so they can also be opened with NDArray::loadNpy.
+ * - Out-of-core arrays are inference/data-processing only: no autograd.
+ */
+#pragma once
+
+#include "NDArray.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class OutOfCoreNDArray {
+public:
+  /** Default memory budget of a single tile. */
+  static constexpr size_t defaultTileBytes = 64 << 20;
+
+  /** Dimensions of the array. */
+  std::vector<int64_t> shape; /**< Shape dimensions; product equals `size`. */
+  /** Row‑major strides in elements. */
+  std::vector<int64_t> strides; /**< Row‑major strides per axis. */
+  /** Number of dimensions (shape.size()). */
+  int ndim = 0; /**< Number of axes. */
+  /** Total number of elements (product of `shape`). */
+  int64_t size = 0; /**< Total element count. */
+  /** Backing `.npy` file. */
+  std::string path; /**< File holding the data. */
+  /** Number of rows (indices along axis 0) per tile. */
+  int64_t tileRows = 1; /**< Tile height. */
+
+  /**
+   * @brief Create a zero-filled file-backed array.
+   * @param path Destination `.npy` file (overwritten); empty for a temporary
+   * @param shape Dimensions of the array
+   * @param tileBytes Memory budget per tile (at least one row)
+   * @throws std::runtime_error if the file cannot be created
+   */
+  static OutOfCoreNDArray create(const std::string &path,
+                                 std::vector<int64_t> shape,
+                                 size_t tileBytes = defaultTileBytes);
+
+  /**
+   * @brief Open an existing C-ordered float32 `.npy` file.
+   * @throws std::runtime_error if the file cannot be read or is malformed
+   * @throws std::invalid_argument if it is not C-ordered `<f4`
+   */
+  static OutOfCoreNDArray open(const std::string &path,
+                               size_t tileBytes = defaultTileBytes);
+
+  /**
+   * @brief Write an in-memory array to a file-backed one.
+   * @param source Array to copy (views are supported)
+   * @param path Destination `.npy` file; empty for a temporary
+   * @param tileBytes Memory budget per tile
+   */
+  static OutOfCoreNDArray fromNDArray(const NDArray &source,
+                                      const std::string &path = "",
+                                      size_t tileBytes = defaultTileBytes);
+
+  /** @brief Load the whole array into memory. */
+  NDArray toNDArray() const;
+
+  /** @brief Number of tiles along axis 0. */
+  int64_t numTiles() const;
+
+  /**
+   * @brief Read one tile (rows [tile * tileRows, ...) ) into memory.
+   * @throws std::out_of_range if tile is outside [0, numTiles())
+   */
+  NDArray readTile(int64_t tile) const;
+
+  /**
+   * @brief Overwrite one tile with `values` (shape must match the tile).
+   * @throws std::out_of_range if tile is outside [0, numTiles())
+   * @throws std::invalid_argument on a shape mismatch
+   */
+  void writeTile(int64_t tile, const NDArray &values);
+
+  /**
+   * @brief Element‑wise ops with another file-backed array of equal shape.
+   * @throws std::invalid_argument if shapes differ
+   */
+  OutOfCoreNDArray operator+(const OutOfCoreNDArray &other) const;
+  OutOfCoreNDArray operator-(const OutOfCoreNDArray &other) const;
+  OutOfCoreNDArray operator/(const OutOfCoreNDArray &other) const;
+  OutOfCoreNDArray element_wise_multiply(const OutOfCoreNDArray &other) const;
+
+  /**
+   * @brief Broadcasted element‑wise ops with an in-memory array.
+   *
+   * `other` must broadcast to this array's shape without adding leading
+   * dimensions (e.g. a bias row).
+   *
+   * @throws std::invalid_argument if shapes are not broadcastable that way
+   */
+  OutOfCoreNDArray operator+(NDArray &other) const;
+  OutOfCoreNDArray operator-(NDArray &other) const;
+  OutOfCoreNDArray operator/(NDArray &other) const;
+  OutOfCoreNDArray element_wise_multiply(NDArray &other) const;
+
+  /** @brief Scalar ops, shape‑preserving. */
+  OutOfCoreNDArray operator+(float value) const;
+  OutOfCoreNDArray operator-(float value) const;
+  OutOfCoreNDArray operator*(float value) const;
+  OutOfCoreNDArray operator/(float value) const;
+
+  /**
+   * @brief Reduce all elements to a 1-element in-memory array.
+   *
+   * Tile partial sums are accumulated in double precision.
+   */
+  NDArray sum() const;
+
+  /**
+   * @brief Sum along an axis (kept as size 1), supports negative axes.
+   * @throws std::invalid_argument if axis is out of range
+   */
+  OutOfCoreNDArray sum(int axis) const;
+
+  /**
+   * @brief 2D matrix multiplication with another file-backed matrix.
+   *
+   * Each row block of this array is multiplied by the row tiles of `other`
+   * (matching column blocks of the block), accumulating one output tile.
+   * Blocks are cut so that the output tile also fits the tile budget.
+   *
+   * @throws std::invalid_argument if either input is not 2D or dims mismatch
+   */
+  OutOfCoreNDArray operator*(const OutOfCoreNDArray &other) const;
+
+  /**
+   * @brief 2D matrix multiplication with an in-memory matrix (e.g. weights).
+   * @throws std::invalid_argument if either input is not 2D or dims mismatch
+   */
+  OutOfCoreNDArray operator*(NDArray &other) const;
+
+private:
+  /** Removes temporary backing files once the last handle is gone. */
+  std::shared_ptr<void> fileOwner;
+  /** Byte offset of the payload within the file. */
+  size_t dataOffset = 0;
+  /** Elements per row (product of shape[1:]). */
+  size_t rowElements = 1;
+  /** Memory budget per tile; results of ops are tiled with it too. */
+  size_t tileBytes = defaultTileBytes;
+
+  void readRows(int64_t row0, int64_t rows, float *dst) const;
+  void writeRows(int64_t row0, int64_t rows, const float *src);
+  std::vector<int64_t> tileShape(int64_t rows) const;
+  int64_t tileRowCount(int64_t tile) const;
+  int64_t mapRows(const std::vector<int64_t> &outShape) const;
+
+  OutOfCoreNDArray mapTiles(
+      const std::vector<int64_t> &outShape,
+      const std::function<NDArray(NDArray &, int64_t, int64_t)> &kernel) const;
+
+  friend class OutOfCoreTileReader;
+};
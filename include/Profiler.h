@@ -0,0 +1,88 @@
+/**
+ * @file Profiler.h
+ * @brief Profiler: opt-in per-op timing with a summary table and Chrome
+ * trace export.
+ *
+ * This header declares the Profiler class and its event types, which
+ * provide:
+ * - One event per forward op and per `_backward` run inside `backward()`,
+ *   with op name, label, shapes, wall time, nominal FLOPs and bytes, and
+ *   thread id
+ * - An aggregated summary table (per op and phase)
+ * - Export as Chrome `trace_event` JSON (chrome://tracing, Perfetto)
+ *
+ * Design notes:
+ * - Disabled by default; while disabled an op pays a single relaxed atomic
+ *   load and records nothing.
+ * - FLOP and byte counts are nominal: the arithmetic and the unique memory
+ *   traffic of the op, not of temporaries.
+ * - Events are appended under a mutex, so ops may run on several threads.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/** Whether an event comes from a forward op or from its backward closure. */
+enum class ProfilePhase { Forward, Backward };
+
+/** Nominal cost of one op invocation. */
+struct OpCost {
+  uint64_t flops = 0;        /**< Floating point operations. */
+  uint64_t bytesRead = 0;    /**< Bytes read from operands. */
+  uint64_t bytesWritten = 0; /**< Bytes written to results or grads. */
+};
+
+/** One timed op invocation. */
+struct ProfileEvent {
+  std::string op;     /**< Op of the node, e.g. "+" or "sum_axis". */
+  std::string label;  /**< Node label, else the labels of its inputs. */
+  std::string shapes; /**< Input and output shapes, e.g. "2x3, 3x4 -> 2x4". */
+  ProfilePhase phase = ProfilePhase::Forward;
+  int64_t startNs = 0;    /**< Start time (Profiler::now()). */
+  int64_t durationNs = 0; /**< Wall time. */
+  OpCost cost;            /**< Nominal FLOPs and bytes. */
+  int threadId = 0;       /**< Small id of the recording thread (from 1). */
+};
+
+class Profiler {
+public:
+  /** @brief Start recording events. */
+  static void enable();
+
+  /** @brief Stop recording events (recorded events are kept). */
+  static void disable();
+
+  /** @brief Whether events are being recorded. */
+  static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+  /** @brief Drop all recorded events. */
+  static void reset();
+
+  /** @brief Nanoseconds on a steady clock since the process started. */
+  static int64_t now();
+
+  /** @brief Append an event; its threadId is filled in. */
+  static void record(ProfileEvent event);
+
+  /** @brief Copy of the recorded events in recording order. */
+  static std::vector<ProfileEvent> events();
+
+  /**
+   * @brief Print per-op totals (calls, time, share, mean, GFLOP/s, GB/s),
+   *        forward and backward separately, slowest first.
+   */
+  static void printSummary(std::ostream &out = std::cout);
+
+  /**
+   * @brief Write the events as Chrome `trace_event` JSON.
+   * @throws std::runtime_error if the file cannot be written
+   */
+  static void exportChromeTrace(const std::string &path);
+
+private:
+  static inline std::atomic<bool> active{false};
+};
@@ -0,0 +1,133 @@
+/**
+ * @file QuantizedNDArray.h
+ * @brief QuantizedNDArray: int8 storage with per-tensor or per-channel scales.
+ *
+ * This header declares the QuantizedNDArray class, which provides:
+ * - Symmetric and affine int8 quantization of an NDArray
+ * - Per-tensor or per-channel (single axis) scale and zero point
+ * - Dequantization back to a float NDArray
+ * - 2D int8 matrix multiplication with exact integer accumulation (int32
+ *   within blocks of k, int64 across them) and a fused dequantize (float
+ *   output) or requantize (int8 output) epilogue
+ *
+ * Design notes:
+ * - Values are always stored contiguously in row‑major order, independent of
+ *   the layout of the NDArray they were quantized from.
+ * - Quantized tensors are inference-only: they are detached from autograd.
+ * - A real value x maps to q = clamp(round(x / scale) + zeroPoint). The
+ *   symmetric scheme uses zeroPoint == 0 and the range [-127, 127]; the affine
+ *   scheme uses the full [-128, 127] range.
+ */
+#pragma once
+
+#include "NDArray.h"
+#include <cstdint>
+#include <vector>
+
+/** Mapping between real values and int8 codes. */
+enum class QuantScheme {
+  Symmetric, /**< zeroPoint == 0, range [-127, 127]. */
+  Affine     /**< Arbitrary zeroPoint, range [-128, 127]. */
+};
+
+class QuantizedNDArray {
+public:
+  /** Quantized values, contiguous row‑major (length = size). */
+  std::vector<int8_t> values; /**< int8 codes. */
+  /** Dimensions of the array. */
+  std::vector<int64_t> shape; /**< Shape dimensions; product equals `size`. */
+  /** Row‑major strides in elements. */
+  std::vector<int64_t> strides; /**< Row‑major strides per axis. */
+  /** Number of dimensions (shape.size()). */
+  int ndim = 0; /**< Number of axes. */
+  /** Total number of elements (product of `shape`). */
+  int64_t size = 0; /**< Total element count. */
+  /** Scale per channel (or a single entry for per-tensor quantization). */
+  std::vector<float> scales; /**< Real value of one quantization step. */
+  /** Zero point per channel (or a single entry for per-tensor). */
+  std::vector<int32_t> zeroPoints; /**< int8 code representing 0.0f. */
+  /** Channel axis for per-channel quantization, -1 for per-tensor. */
+  int axis = -1; /**< Quantization axis. */
+  /** Scheme the tensor was quantized with. */
+  QuantScheme scheme = QuantScheme::Symmetric; /**< Quantization scheme. */
+
+  /**
+   * @brief Construct an empty quantized tensor of given shape.
+   *
+   * Values are zero-initialized and the tensor is per-tensor with scale 1 and
+   * zero point 0. Mostly used as an output buffer by matmul().
+   */
+  QuantizedNDArray(std::vector<int64_t> shape,
+                   QuantScheme scheme = QuantScheme::Symmetric);
+
+  /**
+   * @brief Quantize a whole tensor with a single scale and zero point.
+   *
+   * The scale is derived from the min/max (affine) or max |x| (symmetric) of
+   * all elements. Works on views and non‑contiguous inputs.
+   *
+   * @param input Tensor to quantize
+   * @param scheme Symmetric or affine mapping
+   * @return Contiguous quantized copy of `input`
+   */
+  static QuantizedNDArray quantize(const NDArray &input,
+                                   QuantScheme scheme = QuantScheme::Symmetric);
+
+  /**
+   * @brief Quantize with one scale and zero point per index along `axis`.
+   *
+   * Typical use is weights of shape {in, out} quantized along axis 1 (output
+   * channels). Negative axes are supported.
+   *
+   * @param input Tensor to quantize
+   * @param axis Channel axis (supports negatives)
+   * @param scheme Symmetric or affine mapping
+   * @throws std::invalid_argument if axis is out of range after normalization
+   */
+  static QuantizedNDArray quantizePerChannel(
+      const NDArray &input, int axis,
+      QuantScheme scheme = QuantScheme::Symmetric);
+
+  /**
+   * @brief Map the int8 codes back to real values.
+   * @return A new owning, contiguous float NDArray (detached from autograd)
+   */
+  NDArray dequantize() const;
+
+  /**
+   * @brief 2D quantized matrix multiplication with a float output.
+   *
+   * Accumulates int8 products exactly (int32 within blocks of 512 along k,
+   * int64 across blocks, so any k is safe) and applies zero-point correction
+   * and the dequantize scale in the epilogue, producing the float result
+   * directly.
+   * The GEMM is cache-blocked and runs output blocks on multiple threads
+   * when OpenMP is available; results do not depend on the thread count.
+   * `this` may be per-tensor or per-channel along axis 0 (rows); `other` may
+   * be per-tensor or per-channel along axis 1 (columns).
+   *
+   * @throws std::invalid_argument if either input is not 2D, dims mismatch, or
+   *         the per-channel axes are not (0, 1)
+   */
+  NDArray operator*(const QuantizedNDArray &other) const;
+
+  /**
+   * @brief 2D quantized matrix multiplication with an int8 output.
+   *
+   * Same kernel as operator*, but the epilogue requantizes the accumulators
+   * to per-tensor int8 with the given output parameters.
+   *
+   * @param other Right-hand operand (K x N)
+   * @param outScale Scale of the output tensor
+   * @param outZeroPoint Zero point of the output tensor
+   * @param outScheme Scheme recorded on (and clamping range of) the output
+   * @throws std::invalid_argument on the same conditions as operator*, or if
+   *         outScale <= 0
+   */
+  QuantizedNDArray matmul(const QuantizedNDArray &other, float outScale,
+                          int32_t outZeroPoint = 0,
+                          QuantScheme outScheme = QuantScheme::Affine) const;
+
+  /** @brief Whether the tensor carries one scale per channel. */
+  bool perChannel() const;
+};
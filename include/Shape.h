@@ -0,0 +1,140 @@
+/**
+ * @file Shape.h
+ * @brief SmallVector: fixed-capacity inline vector used for array metadata.
+ *
+ * This header declares the SmallVector class template and the `Shape` alias,
+ * which provide:
+ * - Storage for shapes, strides and multi-indices inside the array object
+ *   (no heap allocation, cheap to copy into backward closures)
+ * - The subset of the std::vector interface the library and its users rely
+ *   on (indexing, iteration, push_back/insert/erase, comparison)
+ * - Implicit conversion from and to std::vector (of any integer type), and
+ *   construction from braced lists, so `NDArray({2, 3})` and
+ *   `std::vector<int> s = a.shape` keep working
+ *
+ * Design notes:
+ * - Capacity is a compile-time constant; growing past it throws
+ *   std::length_error.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template <typename T, int Capacity> class SmallVector {
+public:
+  using value_type = T;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  SmallVector() = default;
+
+  /** @brief `count` copies of `value`. */
+  SmallVector(size_t count, T value) { assign(count, value); }
+
+  SmallVector(std::initializer_list<T> values) {
+    checkCapacity(values.size());
+    std::copy(values.begin(), values.end(), items);
+    length = static_cast<int>(values.size());
+  }
+
+  /** @brief Copy from a std::vector of any integer type. */
+  template <typename U> SmallVector(const std::vector<U> &values) {
+    checkCapacity(values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+      items[i] = static_cast<T>(values[i]);
+    length = static_cast<int>(values.size());
+  }
+
+  /** @brief Copy into a std::vector (e.g. `std::vector<int>`). */
+  template <typename U> operator std::vector<U>() const {
+    return std::vector<U>(begin(), end());
+  }
+
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+  static constexpr size_t capacity() { return Capacity; }
+
+  T &operator[](size_t i) { return items[i]; }
+  const T &operator[](size_t i) const { return items[i]; }
+  T &back() { return items[length - 1]; }
+  const T &back() const { return items[length - 1]; }
+
+  T *data() { return items; }
+  const T *data() const { return items; }
+  iterator begin() { return items; }
+  iterator end() { return items + length; }
+  const_iterator begin() const { return items; }
+  const_iterator end() const { return items + length; }
+
+  void clear() { length = 0; }
+
+  void assign(size_t count, T value) {
+    checkCapacity(count);
+    std::fill(items, items + count, value);
+    length = static_cast<int>(count);
+  }
+
+  void resize(size_t count, T value = T()) {
+    checkCapacity(count);
+    if (count > static_cast<size_t>(length))
+      std::fill(items + length, items + count, value);
+    length = static_cast<int>(count);
+  }
+
+  void push_back(T value) {
+    checkCapacity(length + 1);
+    items[length++] = value;
+  }
+
+  void pop_back() { --length; }
+
+  iterator insert(const_iterator pos, T value) {
+    checkCapacity(length + 1);
+    T *at = items + (pos - items);
+    std::copy_backward(at, items + length, items + length + 1);
+    *at = value;
+    ++length;
+    return at;
+  }
+
+  iterator erase(const_iterator pos) {
+    T *at = items + (pos - items);
+    std::copy(at + 1, items + length, at);
+    --length;
+    return at;
+  }
+
+  friend bool operator==(const SmallVector &a, const SmallVector &b) {
+    return a.length == b.length && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const SmallVector &a, const SmallVector &b) {
+    return !(a == b);
+  }
+
+private:
+  static void checkCapacity(size_t count) {
+    if (count > static_cast<size_t>(Capacity)) {
+      throw std::length_error("At most " + std::to_string(Capacity) +
+                              " dimensions are supported.");
+    }
+  }
+
+  T items[Capacity] = {};
+  int length = 0;
+};
+
+/** Maximum number of dimensions of an array. */
+constexpr int kMaxDims = 8;
+
+/**
+ * Shapes, strides and multi-indices of arrays (inline, at most kMaxDims).
+ * 64-bit so arrays may exceed 2^31 elements.
+ */
+using Shape = SmallVector<int64_t, kMaxDims>;
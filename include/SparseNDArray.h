@@ -0,0 +1,143 @@
+/**
+ * @file SparseNDArray.h
+ * @brief SparseNDArray: 2D float matrices in CSR or COO format.
+ *
+ * This header declares the SparseNDArray class, which provides:
+ * - Compressed sparse row (CSR) and coordinate (COO) storage of a 2D matrix
+ * - Construction from (row, col, value) triplets, from CSR arrays, or from a
+ *   dense NDArray keeping entries with |x| > threshold
+ * - Conversion between formats and back to a dense NDArray
+ * - Sparse x dense matrix multiplication (SpMM), parallel over rows with
+ *   work split by non-zero count
+ * - Autograd through SpMM: a dense grad for the dense operand and a sparse
+ *   grad (same pattern as `values`) for the sparse one
+ *
+ * Design notes:
+ * - Entries are kept sorted in row-major order without duplicates in both
+ *   formats, so COO is CSR with explicit row indices instead of row pointers.
+ * - A sparse matrix is a leaf of the autograd graph: its grad accumulates in
+ *   `grad` (parallel to `values`) and it has no parents. Like NDArray
+ *   operands, it must outlive backward() of the results it produced.
+ * - Results of SpMM are bit-identical for any number of threads: each output
+ *   row and each gradient element is reduced in a fixed order.
+ */
+#pragma once
+
+#include "NDArray.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Storage format of a SparseNDArray. */
+enum class SparseFormat {
+  CSR, /**< Row pointers + column indices. */
+  COO  /**< Row indices + column indices. */
+};
+
+class SparseNDArray {
+public:
+  /** Dimensions {rows, cols}. */
+  std::vector<int64_t> shape; /**< Always two entries. */
+  /** Storage format. */
+  SparseFormat format = SparseFormat::CSR; /**< CSR or COO. */
+  /** CSR only: entries of row r are [rowPointers[r], rowPointers[r + 1]). */
+  std::vector<int64_t> rowPointers; /**< rows + 1 offsets (CSR), else empty. */
+  /** COO only: row of each entry. */
+  std::vector<int64_t> rowIndices; /**< nnz row indices (COO), else empty. */
+  /** Column of each entry. */
+  std::vector<int64_t> colIndices; /**< nnz column indices. */
+  /** Stored values, row-major order. */
+  std::vector<float> values; /**< nnz values. */
+  /** Gradient of each stored value (same pattern as `values`). */
+  std::vector<float> grad; /**< nnz grads, accumulated by backward(). */
+  /** Optional label for debugging. */
+  std::string label; /**< Human-readable label. */
+
+  /**
+   * @brief Build a matrix from (row, col, value) triplets in any order.
+   *
+   * Duplicate coordinates are summed.
+   *
+   * @param shape {rows, cols}
+   * @param rows Row index of each entry
+   * @param cols Column index of each entry
+   * @param values Value of each entry
+   * @param format Storage format of the result
+   * @throws std::invalid_argument if shape is not 2D or negative, or the
+   *         triplet lengths differ
+   * @throws std::out_of_range if an index is out of range
+   */
+  SparseNDArray(std::vector<int64_t> shape, const std::vector<int64_t> &rows,
+                const std::vector<int64_t> &cols,
+                const std::vector<float> &values,
+                SparseFormat format = SparseFormat::COO);
+
+  /**
+   * @brief Build a CSR matrix from its arrays (copied).
+   * @throws std::invalid_argument if the row pointers are not monotonic from
+   *         0 to nnz, or column indices are out of range, unsorted or
+   *         duplicated within a row
+   */
+  static SparseNDArray fromCSR(std::vector<int64_t> shape,
+                               std::vector<int64_t> rowPointers,
+                               std::vector<int64_t> colIndices,
+                               std::vector<float> values);
+
+  /**
+   * @brief Keep the entries of a 2D dense array with |x| > threshold.
+   *
+   * Works on views and non-contiguous inputs.
+   *
+   * @param dense 2D array to convert
+   * @param threshold Magnitude at or below which entries are dropped
+   * @param format Storage format of the result
+   * @throws std::invalid_argument if dense is not 2D or threshold < 0
+   */
+  static SparseNDArray fromDense(const NDArray &dense, float threshold = 0.0f,
+                                 SparseFormat format = SparseFormat::CSR);
+
+  /** @brief Copy in CSR format (grads are kept). */
+  SparseNDArray toCSR() const;
+
+  /** @brief Copy in COO format (grads are kept). */
+  SparseNDArray toCOO() const;
+
+  /**
+   * @brief Materialize as a dense matrix.
+   * @return A new owning, contiguous NDArray (detached from autograd)
+   */
+  NDArray toDense() const;
+
+  /**
+   * @brief Dense matrix holding `grad` at the stored positions.
+   * @return A new owning, contiguous NDArray (detached from autograd)
+   */
+  NDArray gradToDense() const;
+
+  /**
+   * @brief Sparse x dense matrix multiplication with autograd.
+   *
+   * Computes this (M x K) times `dense` (K x N) as an M x N NDArray; only
+   * stored entries are multiplied. backward() accumulates this^T * dY into
+   * the grad of `dense` and dot(dY[r, :], dense[c, :]) into `grad` for each
+   * stored (r, c).
+   *
+   * @throws std::invalid_argument if dense is not 2D or dims mismatch
+   */
+  NDArray matmul(NDArray &dense);
+
+  /** @brief Same as matmul(dense). */
+  NDArray operator*(NDArray &dense) { return matmul(dense); }
+
+  /** @brief Number of stored entries. */
+  int64_t nnz() const { return static_cast<int64_t>(values.size()); }
+
+  /** @brief Set all value grads to zero. */
+  void zeroGrad();
+
+private:
+  SparseNDArray() = default;
+
+  /** @brief CSR row pointers of this matrix in either format. */
+  std::vector<int64_t> csrRowPointers() const;
+};
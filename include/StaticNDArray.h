@@ -0,0 +1,617 @@
+/**
+ * @file StaticNDArray.h
+ * @brief BasicStaticNDArray: small arrays with a compile-time shape.
+ *
+ * This header declares the BasicStaticNDArray class template and the
+ * `StaticNDArray<Dims...>` alias, which provide:
+ * - Inline (stack) storage of data and grad; no heap allocation in any op
+ * - Shape, strides and broadcasting resolved at compile time (incompatible
+ *   shapes are a compile error), with index maps held in constexpr tables
+ * - Kernels fully unrolled for arrays of up to 64 elements
+ * - Element-wise +, -, *, / with broadcasting and scalars, 2D matmul,
+ *   transpose, sum (all or one axis) and exp/log/tanh/sigmoid/relu
+ * - Autograd through all of the above with backward()
+ * - Conversion from and to BasicNDArray
+ *
+ * Design notes:
+ * - Meant for tiny tensors (transforms, small MLP layers); large shapes work
+ *   but live on the stack.
+ * - Graph nodes record at most two parents and a plain function pointer for
+ *   their backward, instead of a parent vector and a std::function. As with
+ *   BasicNDArray, operands must be lvalues that outlive backward().
+ * - Conversions copy and are detached from autograd. Static arrays are not
+ *   profiled or tracked by MemoryTracker.
+ * - Header-only: every shape instantiates its own kernels.
+ */
+#pragma once
+
+#include "NDArray.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T, int64_t... Dims> class BasicStaticNDArray;
+
+namespace detail {
+/** Arrays of at most this many elements get fully unrolled kernels. */
+constexpr int64_t kStaticUnroll = 64;
+
+template <typename F, size_t... I>
+inline void _staticForUnrolled(F &f, std::index_sequence<I...>) {
+  (f(static_cast<int64_t>(I)), ...);
+}
+
+/** @brief Calls f(i) for i in [0, N), unrolled when N is small. */
+template <int64_t N, typename F> inline void _staticFor(F &&f) {
+  if constexpr (N <= kStaticUnroll) {
+    _staticForUnrolled(f, std::make_index_sequence<N>{});
+  } else {
+    for (int64_t i = 0; i < N; ++i)
+      f(i);
+  }
+}
+
+template <size_t Rank>
+constexpr std::array<int64_t, Rank>
+_staticStrides(const std::array<int64_t, Rank> &shape) {
+  std::array<int64_t, Rank> strides{};
+  int64_t stride = 1;
+  for (size_t d = Rank; d-- > 0;) {
+    strides[d] = stride;
+    stride *= shape[d];
+  }
+  return strides;
+}
+
+/**
+ * @brief For every element of `out`, the flat index of the element of `in`
+ *        it reads under broadcasting (shapes aligned on the right).
+ */
+template <int64_t Size, size_t OutRank, size_t InRank>
+constexpr std::array<int64_t, Size>
+_broadcastMap(const std::array<int64_t, OutRank> &out,
+              const std::array<int64_t, InRank> &in) {
+  std::array<int64_t, InRank> inStrides = _staticStrides(in);
+  std::array<int64_t, Size> map{};
+  for (int64_t i = 0; i < Size; ++i) {
+    int64_t rest = i;
+    int64_t offset = 0;
+    for (size_t d = OutRank; d-- > 0;) {
+      int64_t coordinate = rest % out[d];
+      rest /= out[d];
+      size_t back = OutRank - 1 - d;
+      if (back < InRank) {
+        size_t inDim = InRank - 1 - back;
+        offset += in[inDim] == 1 ? 0 : coordinate * inStrides[inDim];
+      }
+    }
+    map[i] = offset;
+  }
+  return map;
+}
+
+/** Shape, validity and index maps of broadcasting shape A against B. */
+template <size_t RankA, size_t RankB> struct StaticBroadcastShape {
+  static constexpr size_t rank = RankA > RankB ? RankA : RankB;
+
+  static constexpr std::array<int64_t, rank>
+  shape(const std::array<int64_t, RankA> &a,
+        const std::array<int64_t, RankB> &b) {
+    std::array<int64_t, rank> result{};
+    for (size_t back = 0; back < rank; ++back) {
+      int64_t da = back < RankA ? a[RankA - 1 - back] : 1;
+      int64_t db = back < RankB ? b[RankB - 1 - back] : 1;
+      result[rank - 1 - back] = da > db ? da : db;
+    }
+    return result;
+  }
+
+  static constexpr bool valid(const std::array<int64_t, RankA> &a,
+                              const std::array<int64_t, RankB> &b) {
+    for (size_t back = 0; back < rank; ++back) {
+      int64_t da = back < RankA ? a[RankA - 1 - back] : 1;
+      int64_t db = back < RankB ? b[RankB - 1 - back] : 1;
+      if (da != db && da != 1 && db != 1)
+        return false;
+    }
+    return true;
+  }
+};
+
+template <typename A, typename B> struct StaticBroadcast;
+
+/** Result type and index maps of a broadcast binary op on A and B. */
+template <typename T, int64_t... DA, int64_t... DB>
+struct StaticBroadcast<BasicStaticNDArray<T, DA...>,
+                       BasicStaticNDArray<T, DB...>> {
+  using Shapes = StaticBroadcastShape<sizeof...(DA), sizeof...(DB)>;
+  static constexpr std::array<int64_t, sizeof...(DA)> a = {DA...};
+  static constexpr std::array<int64_t, sizeof...(DB)> b = {DB...};
+  static constexpr bool valid = Shapes::valid(a, b);
+  static constexpr std::array<int64_t, Shapes::rank> shape =
+      Shapes::shape(a, b);
+
+  template <size_t... I>
+  static BasicStaticNDArray<T, shape[I]...> make(std::index_sequence<I...>);
+  using type = decltype(make(std::make_index_sequence<Shapes::rank>{}));
+
+  static constexpr std::array<int64_t, type::size> mapA =
+      _broadcastMap<type::size>(shape, a);
+  static constexpr std::array<int64_t, type::size> mapB =
+      _broadcastMap<type::size>(shape, b);
+};
+
+/** Autograd node of a static array: two parents and a backward function. */
+template <typename T> struct StaticNode {
+  StaticNode *prev[2] = {nullptr, nullptr}; /**< Graph parents. */
+  void (*backwardFn)(StaticNode &node) = nullptr; /**< Null for leaves. */
+  T scalar = T(0);      /**< Scalar operand of scalar ops. */
+  uint64_t visited = 0; /**< Traversal stamp used by backward(). */
+};
+
+inline thread_local uint64_t staticTraversal = 0;
+
+template <typename T>
+void _staticTopo(StaticNode<T> *node, uint64_t stamp,
+                 std::vector<StaticNode<T> *> &order) {
+  if (node == nullptr || node->visited == stamp)
+    return;
+  node->visited = stamp;
+  _staticTopo(node->prev[0], stamp, order);
+  _staticTopo(node->prev[1], stamp, order);
+  order.push_back(node);
+}
+
+enum class StaticBinary { Add, Sub, Mul, Div };
+enum class StaticUnary { Exp, Log, Tanh, Sigmoid, ReLU };
+
+template <StaticBinary Op, typename T> inline T _staticApply(T a, T b) {
+  if constexpr (Op == StaticBinary::Add)
+    return a + b;
+  else if constexpr (Op == StaticBinary::Sub)
+    return a - b;
+  else if constexpr (Op == StaticBinary::Mul)
+    return a * b;
+  else
+    return a / b;
+}
+
+template <StaticUnary Op, typename T> inline T _staticApply(T x) {
+  if constexpr (Op == StaticUnary::Exp)
+    return std::exp(x);
+  else if constexpr (Op == StaticUnary::Log)
+    return std::log(x);
+  else if constexpr (Op == StaticUnary::Tanh)
+    return std::tanh(x);
+  else if constexpr (Op == StaticUnary::Sigmoid)
+    return T(1) / (T(1) + std::exp(-x));
+  else
+    return x > T(0) ? x : T(0);
+}
+
+/** @brief d(op)/dx at input x with output y. */
+template <StaticUnary Op, typename T> inline T _staticDerivative(T x, T y) {
+  if constexpr (Op == StaticUnary::Exp)
+    return y;
+  else if constexpr (Op == StaticUnary::Log)
+    return T(1) / x;
+  else if constexpr (Op == StaticUnary::Tanh)
+    return T(1) - y * y;
+  else if constexpr (Op == StaticUnary::Sigmoid)
+    return y * (T(1) - y);
+  else
+    return x > T(0) ? T(1) : T(0);
+}
+} // namespace detail
+
+template <typename T, int64_t... Dims>
+class BasicStaticNDArray : public detail::StaticNode<T> {
+  static_assert(sizeof...(Dims) > 0, "Static arrays need at least one axis.");
+  static_assert(((Dims > 0) && ...), "Static array dimensions must be > 0.");
+
+public:
+  /** Element type stored in `data` and `grad`. */
+  using value_type = T;
+
+  /** Number of axes. */
+  static constexpr int ndim = sizeof...(Dims);
+  /** Total number of elements. */
+  static constexpr int64_t size = (Dims * ...);
+  /** Dimensions of the array. */
+  static constexpr std::array<int64_t, sizeof...(Dims)> shape = {Dims...};
+  /** Row‑major strides in elements. */
+  static constexpr std::array<int64_t, sizeof...(Dims)> strides =
+      detail::_staticStrides(shape);
+
+  /** Values in row‑major order. */
+  std::array<T, size> data{}; /**< Inline data (zero-initialized). */
+  /** Gradient parallel to `data`. */
+  std::array<T, size> grad{}; /**< Inline gradient (zero-initialized). */
+
+  /** @brief Zero-filled array. */
+  BasicStaticNDArray() = default;
+
+  /** @brief Array holding `values` in row‑major order. */
+  BasicStaticNDArray(const std::array<T, size> &values) : data(values) {}
+
+  /**
+   * @brief Copy of a BasicNDArray of the same shape (any layout).
+   * @throws std::invalid_argument if the shapes differ
+   */
+  static BasicStaticNDArray fromNDArray(const BasicNDArray<T> &source) {
+    bool same = source.ndim == ndim;
+    for (int d = 0; same && d < ndim; ++d)
+      same = source.shape[d] == shape[d];
+    if (!same) {
+      throw std::invalid_argument(
+          "fromNDArray() requires an array of the static shape.");
+    }
+
+    BasicStaticNDArray result;
+    for (int64_t i = 0; i < size; ++i) {
+      int64_t offset = 0;
+      for (int d = 0; d < ndim; ++d)
+        offset += i / strides[d] % shape[d] * source.strides[d];
+      result.data[i] = source.data[offset];
+    }
+    return result;
+  }
+
+  /**
+   * @brief Copy into a new owning, contiguous BasicNDArray (detached from
+   *        autograd).
+   */
+  BasicNDArray<T> toNDArray() const {
+    BasicNDArray<T> result(Shape{Dims...});
+    std::copy(data.begin(), data.end(), result.data);
+    return result;
+  }
+
+  /** @brief Element at a full multi-index (one index per axis). */
+  template <typename... Index> T &operator()(Index... index) {
+    static_assert(sizeof...(Index) == sizeof...(Dims),
+                  "Expected one index per axis.");
+    return data[offsetOf({static_cast<int64_t>(index)...})];
+  }
+
+  /** @brief Element at a full multi-index (one index per axis). */
+  template <typename... Index> const T &operator()(Index... index) const {
+    static_assert(sizeof...(Index) == sizeof...(Dims),
+                  "Expected one index per axis.");
+    return data[offsetOf({static_cast<int64_t>(index)...})];
+  }
+
+  /** @brief Fill all elements with `value`. */
+  void fill(T value) { data.fill(value); }
+
+  /** @brief Fill with zeros. */
+  void zeros() { data.fill(T(0)); }
+
+  /** @brief Fill with ones. */
+  void ones() { data.fill(T(1)); }
+
+  /** @brief Set the grad to zero. */
+  void zeroGrad() { grad.fill(T(0)); }
+
+  /** @brief Element‑wise add with broadcasting. */
+  template <int64_t... D> auto operator+(BasicStaticNDArray<T, D...> &other) {
+    return binary<detail::StaticBinary::Add>(other);
+  }
+
+  /** @brief Element‑wise subtract with broadcasting. */
+  template <int64_t... D> auto operator-(BasicStaticNDArray<T, D...> &other) {
+    return binary<detail::StaticBinary::Sub>(other);
+  }
+
+  /** @brief Element‑wise multiply with broadcasting. */
+  template <int64_t... D>
+  auto element_wise_multiply(BasicStaticNDArray<T, D...> &other) {
+    return binary<detail::StaticBinary::Mul>(other);
+  }
+
+  /** @brief Element‑wise divide with broadcasting. */
+  template <int64_t... D> auto operator/(BasicStaticNDArray<T, D...> &other) {
+    return binary<detail::StaticBinary::Div>(other);
+  }
+
+  /** @brief Add a scalar to every element. */
+  BasicStaticNDArray operator+(T value) {
+    return scalarOp<detail::StaticBinary::Add>(value);
+  }
+
+  /** @brief Subtract a scalar from every element. */
+  BasicStaticNDArray operator-(T value) {
+    return scalarOp<detail::StaticBinary::Sub>(value);
+  }
+
+  /** @brief Multiply every element by a scalar. */
+  BasicStaticNDArray operator*(T value) {
+    return scalarOp<detail::StaticBinary::Mul>(value);
+  }
+
+  /** @brief Divide every element by a scalar. */
+  BasicStaticNDArray operator/(T value) {
+    return scalarOp<detail::StaticBinary::Div>(value);
+  }
+
+  /**
+   * @brief 2D matrix multiplication: (M x K) * (K x N) -> (M x N).
+   *
+   * Shapes are checked at compile time. Autograd: dA += dOut * B^T and
+   * dB += A^T * dOut.
+   */
+  template <int64_t K, int64_t N>
+  BasicStaticNDArray<T, shape[0], N>
+  operator*(BasicStaticNDArray<T, K, N> &other) {
+    static_assert(ndim == 2, "Matrix multiplication requires 2D arrays.");
+    static_assert(K == shape[ndim - 1], "Inner dimensions must match.");
+    using Other = BasicStaticNDArray<T, K, N>;
+    using Out = BasicStaticNDArray<T, shape[0], N>;
+    Out result;
+    detail::_staticFor<Out::size>([&](int64_t e) {
+      int64_t i = e / N;
+      int64_t j = e % N;
+      T acc = T(0);
+      for (int64_t k = 0; k < K; ++k)
+        acc += data[i * K + k] * other.data[k * N + j];
+      result.data[e] = acc;
+    });
+    link(result, &other, &matmulBackward<Other, Out>);
+    return result;
+  }
+
+  /** @brief Transposed copy of a 2D array. */
+  BasicStaticNDArray<T, shape[ndim - 1], shape[0]> transpose() {
+    static_assert(ndim == 2, "transpose() requires a 2D array.");
+    using Out = BasicStaticNDArray<T, shape[ndim - 1], shape[0]>;
+    Out result;
+    detail::_staticFor<size>([&](int64_t e) {
+      result.data[e % shape[1] * shape[0] + e / shape[1]] = data[e];
+    });
+    link(result, nullptr, &transposeBackward<Out>);
+    return result;
+  }
+
+  /** @brief Sum of all elements as a 1‑element array. */
+  BasicStaticNDArray<T, 1> sum() {
+    using Out = BasicStaticNDArray<T, 1>;
+    Out result;
+    T total = T(0);
+    detail::_staticFor<size>([&](int64_t e) { total += data[e]; });
+    result.data[0] = total;
+    link(result, nullptr, &sumBackward<Out>);
+    return result;
+  }
+
+  /** @brief Sum along `Axis` (supports negatives), kept as size 1. */
+  template <int Axis> auto sum() {
+    constexpr int axis = Axis < 0 ? Axis + ndim : Axis;
+    static_assert(axis >= 0 && axis < ndim, "Axis out of range in sum().");
+    using Traits = detail::StaticBroadcast<Reduced<axis>, BasicStaticNDArray>;
+    using Out = Reduced<axis>;
+    Out result;
+    // Input element e lands on the output element that broadcasts to it
+    detail::_staticFor<size>([&](int64_t e) {
+      result.data[Traits::mapA[e]] += data[e];
+    });
+    link(result, nullptr, &sumBackward<Out, axis>);
+    return result;
+  }
+
+  /** @brief Element‑wise exp. */
+  BasicStaticNDArray exp() { return unary<detail::StaticUnary::Exp>(); }
+
+  /** @brief Element‑wise natural log. */
+  BasicStaticNDArray log() { return unary<detail::StaticUnary::Log>(); }
+
+  /** @brief Element‑wise tanh. */
+  BasicStaticNDArray tanh() { return unary<detail::StaticUnary::Tanh>(); }
+
+  /** @brief Element‑wise logistic sigmoid. */
+  BasicStaticNDArray sigmoid() {
+    return unary<detail::StaticUnary::Sigmoid>();
+  }
+
+  /** @brief Element‑wise max(x, 0). */
+  BasicStaticNDArray relu() { return unary<detail::StaticUnary::ReLU>(); }
+
+  /**
+   * @brief Reverse‑mode backprop from this array.
+   *
+   * Sets this->grad to ones and runs every reachable node's backward in
+   * reverse topological order. Only the traversal list touches the heap, and
+   * it is reused across calls on the same thread.
+   */
+  void backward() {
+    static thread_local std::vector<detail::StaticNode<T> *> order;
+    order.clear();
+    detail::_staticTopo<T>(this, ++detail::staticTraversal, order);
+    grad.fill(T(1));
+    for (size_t i = order.size(); i-- > 0;) {
+      if (order[i]->backwardFn != nullptr)
+        order[i]->backwardFn(*order[i]);
+    }
+  }
+
+private:
+  template <typename U, int64_t... D> friend class BasicStaticNDArray;
+
+  /** Shape of sum<Axis>(): `Axis` replaced by 1. */
+  template <int Axis, size_t... I>
+  static BasicStaticNDArray<T, (static_cast<int>(I) == Axis ? 1 : shape[I])...>
+      reducedType(std::index_sequence<I...>);
+  template <int Axis>
+  using Reduced =
+      decltype(reducedType<Axis>(std::make_index_sequence<sizeof...(Dims)>{}));
+
+  static int64_t offsetOf(const std::array<int64_t, sizeof...(Dims)> &index) {
+    int64_t offset = 0;
+    for (int d = 0; d < ndim; ++d)
+      offset += index[d] * strides[d];
+    return offset;
+  }
+
+  /** @brief Record this (and `other`) as parents of `result`. */
+  template <typename Out>
+  void link(Out &result, detail::StaticNode<T> *other,
+            void (*backwardFn)(detail::StaticNode<T> &)) {
+    result.prev[0] = this;
+    result.prev[1] = other;
+    result.backwardFn = backwardFn;
+  }
+
+  template <detail::StaticBinary Op, int64_t... D>
+  auto binary(BasicStaticNDArray<T, D...> &other) {
+    using Other = BasicStaticNDArray<T, D...>;
+    using Traits = detail::StaticBroadcast<BasicStaticNDArray, Other>;
+    static_assert(Traits::valid, "Shapes cannot be broadcast together.");
+    using Out = typename Traits::type;
+    Out result;
+    detail::_staticFor<Out::size>([&](int64_t e) {
+      result.data[e] = detail::_staticApply<Op>(data[Traits::mapA[e]],
+                                                other.data[Traits::mapB[e]]);
+    });
+    link(result, &other, &binaryBackward<Op, Other, Out>);
+    return result;
+  }
+
+  template <detail::StaticBinary Op, typename Other, typename Out>
+  static void binaryBackward(detail::StaticNode<T> &node) {
+    using Traits = detail::StaticBroadcast<BasicStaticNDArray, Other>;
+    auto &out = static_cast<Out &>(node);
+    auto &a = static_cast<BasicStaticNDArray &>(*node.prev[0]);
+    auto &b = static_cast<Other &>(*node.prev[1]);
+    detail::_staticFor<Out::size>([&](int64_t e) {
+      int64_t ia = Traits::mapA[e];
+      int64_t ib = Traits::mapB[e];
+      T dOut = out.grad[e];
+      if constexpr (Op == detail::StaticBinary::Add) {
+        a.grad[ia] += dOut;
+        b.grad[ib] += dOut;
+      } else if constexpr (Op == detail::StaticBinary::Sub) {
+        a.grad[ia] += dOut;
+        b.grad[ib] -= dOut;
+      } else if constexpr (Op == detail::StaticBinary::Mul) {
+        T x = a.data[ia];
+        a.grad[ia] += dOut * b.data[ib];
+        b.grad[ib] += dOut * x;
+      } else {
+        T y = b.data[ib];
+        T x = a.data[ia];
+        a.grad[ia] += dOut / y;
+        b.grad[ib] -= dOut * x / (y * y);
+      }
+    });
+  }
+
+  template <detail::StaticBinary Op> BasicStaticNDArray scalarOp(T value) {
+    BasicStaticNDArray result;
+    detail::_staticFor<size>([&](int64_t e) {
+      result.data[e] = detail::_staticApply<Op>(data[e], value);
+    });
+    result.scalar = value;
+    link(result, nullptr, &scalarBackward<Op>);
+    return result;
+  }
+
+  template <detail::StaticBinary Op>
+  static void scalarBackward(detail::StaticNode<T> &node) {
+    auto &out = static_cast<BasicStaticNDArray &>(node);
+    auto &a = static_cast<BasicStaticNDArray &>(*node.prev[0]);
+    T value = node.scalar;
+    detail::_staticFor<size>([&](int64_t e) {
+      if constexpr (Op == detail::StaticBinary::Mul)
+        a.grad[e] += out.grad[e] * value;
+      else if constexpr (Op == detail::StaticBinary::Div)
+        a.grad[e] += out.grad[e] / value;
+      else
+        a.grad[e] += out.grad[e];
+    });
+  }
+
+  template <detail::StaticUnary Op> BasicStaticNDArray unary() {
+    static_assert(Op == detail::StaticUnary::ReLU ||
+                      std::is_floating_point_v<T>,
+                  "Transcendental ops require a floating point element type.");
+    BasicStaticNDArray result;
+    detail::_staticFor<size>([&](int64_t e) {
+      result.data[e] = detail::_staticApply<Op>(data[e]);
+    });
+    link(result, nullptr, &unaryBackward<Op>);
+    return result;
+  }
+
+  template <detail::StaticUnary Op>
+  static void unaryBackward(detail::StaticNode<T> &node) {
+    auto &out = static_cast<BasicStaticNDArray &>(node);
+    auto &a = static_cast<BasicStaticNDArray &>(*node.prev[0]);
+    detail::_staticFor<size>([&](int64_t e) {
+      a.grad[e] +=
+          out.grad[e] * detail::_staticDerivative<Op>(a.data[e], out.data[e]);
+    });
+  }
+
+  template <typename Other, typename Out>
+  static void matmulBackward(detail::StaticNode<T> &node) {
+    constexpr int64_t M = shape[0];
+    constexpr int64_t K = shape[1];
+    constexpr int64_t N = Other::shape[1];
+    auto &out = static_cast<Out &>(node);
+    auto &a = static_cast<BasicStaticNDArray &>(*node.prev[0]);
+    auto &b = static_cast<Other &>(*node.prev[1]);
+    // dA[i, k] += sum_j dOut[i, j] * B[k, j]
+    detail::_staticFor<M * K>([&](int64_t e) {
+      int64_t i = e / K;
+      int64_t k = e % K;
+      T acc = T(0);
+      for (int64_t j = 0; j < N; ++j)
+        acc += out.grad[i * N + j] * b.data[k * N + j];
+      a.grad[e] += acc;
+    });
+    // dB[k, j] += sum_i A[i, k] * dOut[i, j]
+    detail::_staticFor<K * N>([&](int64_t e) {
+      int64_t k = e / N;
+      int64_t j = e % N;
+      T acc = T(0);
+      for (int64_t i = 0; i < M; ++i)
+        acc += a.data[i * K + k] * out.grad[i * N + j];
+      b.grad[e] += acc;
+    });
+  }
+
+  template <typename Out>
+  static void transposeBackward(detail::StaticNode<T> &node) {
+    auto &out = static_cast<Out &>(node);
+    auto &a = static_cast<BasicStaticNDArray &>(*node.prev[0]);
+    detail::_staticFor<size>([&](int64_t e) {
+      a.grad[e] += out.grad[e % shape[1] * shape[0] + e / shape[1]];
+    });
+  }
+
+  template <typename Out, int Axis = -1>
+  static void sumBackward(detail::StaticNode<T> &node) {
+    auto &out = static_cast<Out &>(node);
+    auto &a = static_cast<BasicStaticNDArray &>(*node.prev[0]);
+    if constexpr (Axis < 0) {
+      T dOut = out.grad[0];
+      detail::_staticFor<size>([&](int64_t e) { a.grad[e] += dOut; });
+    } else {
+      using Traits = detail::StaticBroadcast<Out, BasicStaticNDArray>;
+      detail::_staticFor<size>([&](int64_t e) {
+        a.grad[e] += out.grad[Traits::mapA[e]];
+      });
+    }
+  }
+};
+
+/** Float static array, e.g. `StaticNDArray<4, 4>`. */
+template <int64_t... Dims> using StaticNDArray =
+    BasicStaticNDArray<float, Dims...>;
+/** Double precision static array. */
+template <int64_t... Dims> using StaticNDArrayF64 =
+    BasicStaticNDArray<double, Dims...>;
@@ -0,0 +1,583 @@
+#include "../include/Checkpoint.h"
+#include "./utils.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+// File layout (all integers little-endian):
+//   "INCLICKP" | u32 version | u32 tensorCount
+//   per tensor:
+//     u32 labelLength | label | u32 dtype | u32 ndim | i64 shape[ndim]
+//     | i64 strides[ndim] | u32 flags | u64 elementCount
+//   (version 1 files store shape and strides as i32; still readable)
+//     data section [grad section if flags & kHasGrad]
+//   section: chunks until elementCount * sizeof(float) raw bytes are covered
+//     u32 rawBytes | u32 storedBytes | u32 crc32c(raw) | payload
+//   A chunk is compressed iff storedBytes != rawBytes.
+
+namespace {
+const char kMagic[] = "INCLICKP";
+const size_t kMagicLength = 8;
+const uint32_t kVersion = 2;
+const uint32_t kVersionInt32Dims = 1;
+const uint32_t kDtypeFloat32 = 0;
+const uint32_t kHasGrad = 1;
+
+// CRC32C (Castagnoli); uses the SSE4.2 crc32 instruction when available
+uint32_t _crc32c(const unsigned char *bytes, size_t n) {
+  uint32_t crc = 0xFFFFFFFFu;
+#if defined(__SSE4_2__)
+  while (n >= 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes, 8);
+    crc = static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+    bytes += 8;
+    n -= 8;
+  }
+  while (n--) {
+    crc = _mm_crc32_u8(crc, *bytes++);
+  }
+#else
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  while (n--) {
+    crc = table[(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+  }
+#endif
+  return ~crc;
+}
+
+// Groups byte k of every element together; floats of similar magnitude then
+// share long runs of equal exponent bytes, which LZ picks up.
+void _shuffle(const unsigned char *src, unsigned char *dst, size_t bytes,
+              size_t elementSize) {
+  size_t count = bytes / elementSize;
+  for (size_t b = 0; b < elementSize; ++b) {
+    for (size_t i = 0; i < count; ++i) {
+      dst[b * count + i] = src[i * elementSize + b];
+    }
+  }
+}
+
+void _unshuffle(const unsigned char *src, unsigned char *dst, size_t bytes,
+                size_t elementSize) {
+  size_t count = bytes / elementSize;
+  for (size_t b = 0; b < elementSize; ++b) {
+    for (size_t i = 0; i < count; ++i) {
+      dst[i * elementSize + b] = src[b * count + i];
+    }
+  }
+}
+
+uint32_t _read32(const unsigned char *p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+// Appends a length in the 4-bit nibble + 255-continuation encoding
+bool _putLength(unsigned char *dst, size_t cap, size_t &op, size_t length) {
+  while (length >= 255) {
+    if (op >= cap)
+      return false;
+    dst[op++] = 255;
+    length -= 255;
+  }
+  if (op >= cap)
+    return false;
+  dst[op++] = static_cast<unsigned char>(length);
+  return true;
+}
+
+// Writes one sequence: literals src[anchor, anchor + literals) followed by
+// an optional back-reference (matchLength == 0 marks the final sequence).
+bool _putSequence(unsigned char *dst, size_t cap, size_t &op,
+                  const unsigned char *literals, size_t literalLength,
+                  size_t offset, size_t matchLength) {
+  if (op >= cap)
+    return false;
+  size_t tokenPos = op++;
+  unsigned char token = static_cast<unsigned char>(
+      std::min<size_t>(literalLength, 15) << 4);
+  if (literalLength >= 15 && !_putLength(dst, cap, op, literalLength - 15))
+    return false;
+  if (op + literalLength > cap)
+    return false;
+  std::memcpy(dst + op, literals, literalLength);
+  op += literalLength;
+
+  if (matchLength > 0) {
+    size_t code = matchLength - 4;
+    token |= static_cast<unsigned char>(std::min<size_t>(code, 15));
+    if (op + 2 > cap)
+      return false;
+    dst[op++] = static_cast<unsigned char>(offset & 0xff);
+    dst[op++] = static_cast<unsigned char>(offset >> 8);
+    if (code >= 15 && !_putLength(dst, cap, op, code - 15))
+      return false;
+  }
+  dst[tokenPos] = token;
+  return true;
+}
+
+// Greedy LZ77 with a 64 KiB window and 4-byte hashed matches. Returns the
+// compressed size, or 0 if the output would not be smaller than `cap`.
+size_t _lzCompress(const unsigned char *src, size_t n, unsigned char *dst,
+                   size_t cap) {
+  const int hashBits = 14;
+  std::vector<uint32_t> table(size_t(1) << hashBits, 0); // position + 1
+  size_t ip = 0, anchor = 0, op = 0;
+
+  while (ip + 4 <= n) {
+    uint32_t sequence = _read32(src + ip);
+    uint32_t h = (sequence * 2654435761u) >> (32 - hashBits);
+    size_t candidate = table[h];
+    table[h] = static_cast<uint32_t>(ip + 1);
+
+    if (candidate > 0 && ip - (candidate - 1) <= 65535 &&
+        _read32(src + candidate - 1) == sequence) {
+      size_t ref = candidate - 1;
+      size_t length = 4;
+      while (ip + length < n && src[ref + length] == src[ip + length])
+        length++;
+      if (!_putSequence(dst, cap, op, src + anchor, ip - anchor, ip - ref,
+                        length))
+        return 0;
+      ip += length;
+      anchor = ip;
+    } else {
+      ip++;
+    }
+  }
+
+  if (!_putSequence(dst, cap, op, src + anchor, n - anchor, 0, 0))
+    return 0;
+  return op;
+}
+
+// Inverse of _lzCompress with full bounds checking. Returns false on
+// malformed input.
+bool _lzDecompress(const unsigned char *src, size_t n, unsigned char *dst,
+                   size_t rawSize) {
+  size_t ip = 0, op = 0;
+  auto getLength = [&](size_t &length) {
+    unsigned char b;
+    do {
+      if (ip >= n)
+        return false;
+      b = src[ip++];
+      length += b;
+    } while (b == 255);
+    return true;
+  };
+
+  while (ip < n) {
+    unsigned char token = src[ip++];
+    size_t literalLength = token >> 4;
+    if (literalLength == 15 && !getLength(literalLength))
+      return false;
+    if (ip + literalLength > n || op + literalLength > rawSize)
+      return false;
+    std::memcpy(dst + op, src + ip, literalLength);
+    ip += literalLength;
+    op += literalLength;
+
+    if (ip == n)
+      break;
+
+    if (ip + 2 > n)
+      return false;
+    size_t offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    size_t matchLength = token & 15;
+    if (matchLength == 15 && !getLength(matchLength))
+      return false;
+    matchLength += 4;
+    if (offset == 0 || offset > op || op + matchLength > rawSize)
+      return false;
+    // Byte-wise: source and destination may overlap
+    for (size_t i = 0; i < matchLength; ++i, ++op)
+      dst[op] = dst[op - offset];
+  }
+
+  return op == rawSize;
+}
+
+template <typename V> void _put(std::ofstream &out, V value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(V));
+}
+
+template <typename V> V _get(std::ifstream &in) {
+  V value;
+  in.read(reinterpret_cast<char *>(&value), sizeof(V));
+  if (!in)
+    throw std::runtime_error("Unexpected end of checkpoint file.");
+  return value;
+}
+
+// Writes float elements as a sequence of checksummed (and optionally
+// compressed) chunks. Contiguous runs are written straight from the source.
+class ChunkWriter {
+public:
+  ChunkWriter(std::ofstream &out, const CheckpointOptions &options)
+      : out(out), compress(options.compress) {
+    chunkElements =
+        std::max<size_t>(1, static_cast<size_t>(options.chunkBytes) /
+                                sizeof(float));
+    buffer.resize(chunkElements);
+    if (compress) {
+      shuffled.resize(chunkElements * sizeof(float));
+      packed.resize(chunkElements * sizeof(float));
+    }
+  }
+
+  // Contiguous source: chunks are emitted without staging copies
+  void writeContiguous(const float *src, size_t count) {
+    for (size_t pos = 0; pos < count; pos += chunkElements) {
+      size_t n = std::min(chunkElements, count - pos);
+      emit(src + pos, n);
+    }
+  }
+
+  // Strided source (data or grad of `array`, both laid out by its strides):
+  // gathered into the chunk buffer in row-major order
+  void writeStrided(const NDArray &array, const float *base) {
+    Shape index(array.shape.size(), 0);
+    size_t filled = 0;
+    for (int64_t i = 0; i < array.size; ++i) {
+      buffer[filled++] = base[detail::_computeOffset(index, array.strides)];
+      if (filled == chunkElements) {
+        emit(buffer.data(), filled);
+        filled = 0;
+      }
+
+      for (int dim = static_cast<int>(array.shape.size()) - 1; dim >= 0;
+           --dim) {
+        index[dim]++;
+        if (index[dim] < array.shape[dim])
+          break;
+        index[dim] = 0;
+      }
+    }
+    if (filled > 0)
+      emit(buffer.data(), filled);
+  }
+
+private:
+  void emit(const float *src, size_t count) {
+    const unsigned char *raw = reinterpret_cast<const unsigned char *>(src);
+    uint32_t rawBytes = static_cast<uint32_t>(count * sizeof(float));
+    uint32_t crc = _crc32c(raw, rawBytes);
+
+    const unsigned char *payload = raw;
+    uint32_t storedBytes = rawBytes;
+    if (compress) {
+      _shuffle(raw, shuffled.data(), rawBytes, sizeof(float));
+      // Only keep the compressed form if it is strictly smaller
+      size_t packedBytes = _lzCompress(shuffled.data(), rawBytes,
+                                       packed.data(), rawBytes - 1);
+      if (packedBytes > 0) {
+        payload = packed.data();
+        storedBytes = static_cast<uint32_t>(packedBytes);
+      }
+    }
+
+    _put<uint32_t>(out, rawBytes);
+    _put<uint32_t>(out, storedBytes);
+    _put<uint32_t>(out, crc);
+    out.write(reinterpret_cast<const char *>(payload), storedBytes);
+  }
+
+  std::ofstream &out;
+  bool compress;
+  size_t chunkElements;
+  std::vector<float> buffer;
+  std::vector<unsigned char> shuffled;
+  std::vector<unsigned char> packed;
+};
+
+// Reads a section of `count` float elements. Uncompressed chunks of a
+// contiguous destination are read directly into it.
+class ChunkReader {
+public:
+  explicit ChunkReader(std::ifstream &in) : in(in) {}
+
+  void readContiguous(float *dst, size_t count) {
+    size_t pos = 0;
+    while (pos < count) {
+      size_t n = readChunk(dst + pos, count - pos);
+      pos += n;
+    }
+  }
+
+  void readStrided(NDArray &array, float *base) {
+    Shape index(array.shape.size(), 0);
+    size_t remaining = array.size;
+    while (remaining > 0) {
+      size_t n = readChunk(nullptr, remaining);
+      for (size_t i = 0; i < n; ++i) {
+        base[detail::_computeOffset(index, array.strides)] = staging[i];
+        for (int dim = static_cast<int>(array.shape.size()) - 1; dim >= 0;
+             --dim) {
+          index[dim]++;
+          if (index[dim] < array.shape[dim])
+            break;
+          index[dim] = 0;
+        }
+      }
+      remaining -= n;
+    }
+  }
+
+  void skip(size_t count) {
+    size_t bytes = count * sizeof(float);
+    while (bytes > 0) {
+      uint32_t rawBytes = _get<uint32_t>(in);
+      uint32_t storedBytes = _get<uint32_t>(in);
+      _get<uint32_t>(in);
+      if (rawBytes == 0 || rawBytes > bytes)
+        throw std::runtime_error("Malformed checkpoint chunk.");
+      in.seekg(storedBytes, std::ios::cur);
+      bytes -= rawBytes;
+    }
+  }
+
+private:
+  // Decodes one chunk into `dst` (or the staging buffer when dst is null)
+  // and returns its element count, which may not exceed `capacity`.
+  size_t readChunk(float *dst, size_t capacity) {
+    uint32_t rawBytes = _get<uint32_t>(in);
+    uint32_t storedBytes = _get<uint32_t>(in);
+    uint32_t crc = _get<uint32_t>(in);
+    size_t count = rawBytes / sizeof(float);
+    if (rawBytes == 0 || rawBytes % sizeof(float) != 0 ||
+        storedBytes > rawBytes || count > capacity) {
+      throw std::runtime_error("Malformed checkpoint chunk.");
+    }
+
+    float *target = dst;
+    if (target == nullptr) {
+      staging.resize(count);
+      target = staging.data();
+    }
+    unsigned char *out = reinterpret_cast<unsigned char *>(target);
+
+    if (storedBytes == rawBytes) {
+      in.read(reinterpret_cast<char *>(out), rawBytes);
+    } else {
+      packed.resize(storedBytes);
+      shuffled.resize(rawBytes);
+      in.read(reinterpret_cast<char *>(packed.data()), storedBytes);
+      if (in && !_lzDecompress(packed.data(), storedBytes, shuffled.data(),
+                               rawBytes)) {
+        throw std::runtime_error("Corrupt compressed checkpoint chunk.");
+      }
+      _unshuffle(shuffled.data(), out, rawBytes, sizeof(float));
+    }
+    if (!in)
+      throw std::runtime_error("Unexpected end of checkpoint file.");
+    if (_crc32c(out, rawBytes) != crc)
+      throw std::runtime_error("Checkpoint chunk failed its checksum.");
+
+    return count;
+  }
+
+  std::ifstream &in;
+  std::vector<float> staging;
+  std::vector<unsigned char> packed;
+  std::vector<unsigned char> shuffled;
+};
+
+// Reads a tensor header; the stream is left at the start of its data section
+CheckpointEntry _readEntryHeader(std::ifstream &in, uint32_t version,
+                                 uint64_t &elementCount) {
+  CheckpointEntry entry;
+  uint32_t labelLength = _get<uint32_t>(in);
+  entry.label.resize(labelLength);
+  in.read(&entry.label[0], labelLength);
+  if (_get<uint32_t>(in) != kDtypeFloat32)
+    throw std::runtime_error("Unsupported dtype in checkpoint.");
+
+  uint32_t ndim = _get<uint32_t>(in);
+  auto getDim = [&in, version]() -> int64_t {
+    return version == kVersionInt32Dims ? _get<int32_t>(in)
+                                        : _get<int64_t>(in);
+  };
+  for (uint32_t i = 0; i < ndim; ++i)
+    entry.shape.push_back(getDim());
+  for (uint32_t i = 0; i < ndim; ++i)
+    entry.strides.push_back(getDim());
+  entry.hasGrad = (_get<uint32_t>(in) & kHasGrad) != 0;
+  elementCount = _get<uint64_t>(in);
+  return entry;
+}
+
+// Returns the tensor count; `version` receives the file format version
+uint32_t _readFileHeader(std::ifstream &in, const std::string &path,
+                         uint32_t &version) {
+  char magic[kMagicLength];
+  in.read(magic, kMagicLength);
+  if (!in || std::memcmp(magic, kMagic, kMagicLength) != 0)
+    throw std::runtime_error("'" + path + "' is not a checkpoint file.");
+  version = _get<uint32_t>(in);
+  if (version != kVersion && version != kVersionInt32Dims)
+    throw std::runtime_error("Unsupported checkpoint version in '" + path +
+                             "'.");
+  return _get<uint32_t>(in);
+}
+} // namespace
+
+void Checkpoint::save(
+    const std::string &path,
+    const std::vector<std::reference_wrapper<NDArray>> &arrays,
+    CheckpointOptions options) {
+  if (options.chunkBytes < static_cast<int>(sizeof(float))) {
+    throw std::invalid_argument("Checkpoint chunk size must be at least " +
+                                std::to_string(sizeof(float)) + " bytes.");
+  }
+
+  std::unordered_set<std::string> labels;
+  for (const NDArray &array : arrays) {
+    if (array.label.empty()) {
+      throw std::invalid_argument(
+          "Every tensor saved in a checkpoint needs a label.");
+    }
+    if (!labels.insert(array.label).second) {
+      throw std::invalid_argument("Duplicate checkpoint label '" +
+                                  array.label + "'.");
+    }
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw std::runtime_error("Could not open '" + path + "' for writing.");
+
+  out.write(kMagic, kMagicLength);
+  _put<uint32_t>(out, kVersion);
+  _put<uint32_t>(out, static_cast<uint32_t>(arrays.size()));
+
+  ChunkWriter writer(out, options);
+  for (const NDArray &array : arrays) {
+    _put<uint32_t>(out, static_cast<uint32_t>(array.label.size()));
+    out.write(array.label.data(), array.label.size());
+    _put<uint32_t>(out, kDtypeFloat32);
+    _put<uint32_t>(out, static_cast<uint32_t>(array.shape.size()));
+    for (int64_t dim : array.shape)
+      _put<int64_t>(out, dim);
+    for (int64_t stride : array.strides)
+      _put<int64_t>(out, stride);
+    _put<uint32_t>(out, options.includeGrad ? kHasGrad : 0);
+    _put<uint64_t>(out, static_cast<uint64_t>(array.size));
+
+    if (array.isContiguous())
+      writer.writeContiguous(array.data, array.size);
+    else
+      writer.writeStrided(array, array.data);
+
+    // The grad buffer has the same layout as the data
+    if (options.includeGrad) {
+      if (array.isContiguous())
+        writer.writeContiguous(array.grad, array.size);
+      else
+        writer.writeStrided(array, array.grad);
+    }
+  }
+
+  if (!out)
+    throw std::runtime_error("Failed writing '" + path + "'.");
+}
+
+std::vector<CheckpointEntry> Checkpoint::entries(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Could not open '" + path + "'.");
+
+  uint32_t version = 0;
+  uint32_t count = _readFileHeader(in, path, version);
+  ChunkReader reader(in);
+  std::vector<CheckpointEntry> result;
+  for (uint32_t t = 0; t < count; ++t) {
+    uint64_t elementCount = 0;
+    result.push_back(_readEntryHeader(in, version, elementCount));
+    reader.skip(elementCount);
+    if (result.back().hasGrad)
+      reader.skip(elementCount);
+  }
+  return result;
+}
+
+void Checkpoint::load(
+    const std::string &path,
+    const std::vector<std::reference_wrapper<NDArray>> &arrays,
+    bool loadGrad) {
+  std::unordered_map<std::string, NDArray *> targets;
+  for (NDArray &array : arrays)
+    targets[array.label] = &array;
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Could not open '" + path + "'.");
+
+  uint32_t version = 0;
+  uint32_t count = _readFileHeader(in, path, version);
+  ChunkReader reader(in);
+  std::unordered_set<std::string> restored;
+  for (uint32_t t = 0; t < count; ++t) {
+    uint64_t elementCount = 0;
+    CheckpointEntry entry = _readEntryHeader(in, version, elementCount);
+
+    auto it = targets.find(entry.label);
+    if (it == targets.end()) {
+      reader.skip(elementCount);
+      if (entry.hasGrad)
+        reader.skip(elementCount);
+      continue;
+    }
+
+    NDArray &target = *it->second;
+    if (target.shape != entry.shape ||
+        static_cast<uint64_t>(target.size) != elementCount) {
+      throw std::invalid_argument("Shape mismatch restoring '" + entry.label +
+                                  "' from checkpoint.");
+    }
+
+    target.ensureUnique();
+    if (target.isContiguous())
+      reader.readContiguous(target.data, elementCount);
+    else
+      reader.readStrided(target, target.data);
+
+    if (entry.hasGrad) {
+      if (!loadGrad)
+        reader.skip(elementCount);
+      else if (target.isContiguous())
+        reader.readContiguous(target.grad, elementCount);
+      else
+        reader.readStrided(target, target.grad);
+    }
+    restored.insert(entry.label);
+  }
+
+  for (const auto &target : targets) {
+    if (restored.find(target.first) == restored.end()) {
+      throw std::runtime_error("Tensor '" + target.first +
+                               "' not found in checkpoint '" + path + "'.");
+    }
+  }
+}
@@ -0,0 +1,204 @@
+#include "../include/MemoryTracker.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+struct TrackerState {
+  std::mutex mutex;
+  uint64_t nextId = 1;
+  MemoryUsage total;
+  std::map<std::string, MemoryUsage> byOp;
+  std::map<std::string, MemoryUsage> byLabel;
+  std::unordered_map<uint64_t, LiveAllocation> records;
+};
+
+// Never destroyed: arrays with static storage may release buffers during
+// program exit
+TrackerState &_state() {
+  static TrackerState *state = new TrackerState();
+  return *state;
+}
+
+// Innermost Scope name of this thread ("outer/inner" when nested)
+thread_local std::string scopeName;
+
+void _add(MemoryUsage &usage, const LiveAllocation &record) {
+  int64_t bytes = record.dataBytes + record.gradBytes;
+  usage.liveBytes += bytes;
+  usage.liveDataBytes += record.dataBytes;
+  usage.liveGradBytes += record.gradBytes;
+  usage.peakBytes = std::max(usage.peakBytes, usage.liveBytes);
+  usage.cumulativeBytes += bytes;
+  usage.liveAllocations++;
+  usage.allocations++;
+}
+
+void _remove(MemoryUsage &usage, const LiveAllocation &record) {
+  usage.liveBytes -= record.dataBytes + record.gradBytes;
+  usage.liveDataBytes -= record.dataBytes;
+  usage.liveGradBytes -= record.gradBytes;
+  usage.liveAllocations--;
+}
+
+std::string _opKey(const std::string &op) {
+  return op.empty() ? "(leaf)" : op;
+}
+
+std::string _labelKey(const std::string &label) {
+  return label.empty() ? "(unlabelled)" : label;
+}
+
+std::string _megabytes(int64_t bytes) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.2f", bytes / (1024.0 * 1024.0));
+  return text;
+}
+
+void _printUsage(std::ostream &out, const char *keyTitle,
+                 const std::map<std::string, MemoryUsage> &usages) {
+  std::vector<std::pair<std::string, MemoryUsage>> rows(usages.begin(),
+                                                        usages.end());
+  std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+    return a.second.liveBytes != b.second.liveBytes
+               ? a.second.liveBytes > b.second.liveBytes
+               : a.second.peakBytes > b.second.peakBytes;
+  });
+
+  char line[160];
+  std::snprintf(line, sizeof(line), "%-20s %10s %10s %10s %10s %12s %7s\n",
+                keyTitle, "live MB", "data MB", "grad MB", "peak MB",
+                "total MB", "live #");
+  out << line;
+  for (const auto &[key, usage] : rows) {
+    std::snprintf(line, sizeof(line),
+                  "%-20s %10s %10s %10s %10s %12s %7lld\n", key.c_str(),
+                  _megabytes(usage.liveBytes).c_str(),
+                  _megabytes(usage.liveDataBytes).c_str(),
+                  _megabytes(usage.liveGradBytes).c_str(),
+                  _megabytes(usage.peakBytes).c_str(),
+                  _megabytes(usage.cumulativeBytes).c_str(),
+                  static_cast<long long>(usage.liveAllocations));
+    out << line;
+  }
+}
+} // namespace
+
+MemoryTracker::Scope::Scope(const std::string &name)
+    : previousLength(scopeName.size()) {
+  scopeName += (scopeName.empty() ? "" : "/") + name;
+}
+
+MemoryTracker::Scope::~Scope() { scopeName.resize(previousLength); }
+
+void MemoryTracker::enable() { active.store(true, std::memory_order_relaxed); }
+
+void MemoryTracker::disable() {
+  active.store(false, std::memory_order_relaxed);
+}
+
+void MemoryTracker::reset() {
+  TrackerState &state = _state();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.total = MemoryUsage();
+  state.byOp.clear();
+  state.byLabel.clear();
+  state.records.clear();
+}
+
+uint64_t MemoryTracker::allocate(const std::string &op,
+                                 const std::string &label, const Shape &shape,
+                                 int64_t dataBytes, int64_t gradBytes) {
+  if (!enabled())
+    return 0;
+
+  LiveAllocation record;
+  record.op = op;
+  record.label = label.empty() ? scopeName : label;
+  record.shape = shape;
+  record.dataBytes = dataBytes;
+  record.gradBytes = gradBytes;
+
+  TrackerState &state = _state();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  record.id = state.nextId++;
+  _add(state.total, record);
+  _add(state.byOp[_opKey(record.op)], record);
+  _add(state.byLabel[_labelKey(record.label)], record);
+  uint64_t token = record.id;
+  state.records.emplace(token, std::move(record));
+  return token;
+}
+
+void MemoryTracker::release(uint64_t token) {
+  if (token == 0)
+    return;
+
+  TrackerState &state = _state();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  auto it = state.records.find(token);
+  if (it == state.records.end())
+    return; // tracked before the last reset()
+
+  const LiveAllocation &record = it->second;
+  _remove(state.total, record);
+  _remove(state.byOp[_opKey(record.op)], record);
+  _remove(state.byLabel[_labelKey(record.label)], record);
+  state.records.erase(it);
+}
+
+MemorySnapshot MemoryTracker::snapshot() {
+  MemorySnapshot result;
+  {
+    TrackerState &state = _state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    result.total = state.total;
+    result.byOp = state.byOp;
+    result.byLabel = state.byLabel;
+    result.live.reserve(state.records.size());
+    for (const auto &[token, record] : state.records)
+      result.live.push_back(record);
+  }
+
+  std::sort(result.live.begin(), result.live.end(),
+            [](const LiveAllocation &a, const LiveAllocation &b) {
+              int64_t aBytes = a.dataBytes + a.gradBytes;
+              int64_t bBytes = b.dataBytes + b.gradBytes;
+              return aBytes != bBytes ? aBytes > bBytes : a.id < b.id;
+            });
+  return result;
+}
+
+void MemoryTracker::printReport(std::ostream &out, size_t top) {
+  MemorySnapshot snap = snapshot();
+
+  out << "Tracked memory: live " << _megabytes(snap.total.liveBytes)
+      << " MB (data " << _megabytes(snap.total.liveDataBytes) << " MB, grad "
+      << _megabytes(snap.total.liveGradBytes) << " MB), peak "
+      << _megabytes(snap.total.peakBytes) << " MB, allocated "
+      << _megabytes(snap.total.cumulativeBytes) << " MB in "
+      << snap.total.allocations << " buffers\n\n";
+
+  _printUsage(out, "op", snap.byOp);
+  out << "\n";
+  _printUsage(out, "label", snap.byLabel);
+
+  out << "\nLargest live buffers:\n";
+  char line[160];
+  std::snprintf(line, sizeof(line), "%8s %-12s %-20s %-20s %10s %10s\n", "id",
+                "op", "label", "shape", "data MB", "grad MB");
+  out << line;
+  for (size_t i = 0; i < std::min(top, snap.live.size()); ++i) {
+    const LiveAllocation &record = snap.live[i];
+    std::string shape;
+    for (size_t d = 0; d < record.shape.size(); ++d)
+      shape += (d > 0 ? "x" : "") + std::to_string(record.shape[d]);
+    std::snprintf(line, sizeof(line), "%8llu %-12s %-20s %-20s %10s %10s\n",
+                  static_cast<unsigned long long>(record.id),
+                  _opKey(record.op).c_str(), _labelKey(record.label).c_str(),
+                  shape.c_str(), _megabytes(record.dataBytes).c_str(),
+                  _megabytes(record.gradBytes).c_str());
+    out << line;
+  }
+}
@@ -1,16 +1,1599 @@
 #include "../include/NDArray.h"
 #include "./utils.h"
+#include "./vecmath.h"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
-#include <random>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
-NDArray::NDArray(std::vector<int> inputShape, std::string inputLabel,
-                 std::string inputOp,
-                 std::vector<std::reference_wrapper<NDArray>> inputPrev) {
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+// Strided GEMM: C (+)= A * B with A (m x k), B (k x n), C (m x n), each
+// addressed as ptr[i * rowStride + j * colStride]. Row-major, column-major
+// (i.e. transposed), padded and sliced operands are consumed in place; only
+// small cache blocks are packed, with the read order picked from whichever
+// stride is unit so each variant streams memory sequentially. Sizes and
+// strides are 64-bit; indices inside a cache block stay 32-bit.
+//
+// `epilogue(row, col0, dst, count)` runs on every finished segment of a C
+// row (dst[0..count) = C[row, col0..col0+count)) right after its last
+// update, while the segment is still in cache. Epilogues need row-major C
+// (csC == 1).
+struct NoEpilogue {
+  template <typename T>
+  void operator()(int64_t, int64_t, T *, int64_t) const {}
+};
+
+template <typename T, typename Epilogue = NoEpilogue>
+void _gemm(int64_t m, int64_t n, int64_t k, const T *a, int64_t rsA,
+           int64_t csA, const T *b, int64_t rsB, int64_t csB, T *c,
+           int64_t rsC, int64_t csC, bool accumulate,
+           Epilogue epilogue = Epilogue()) {
+  const int blockK = 256;
+  const int blockN = 256;
+  const int rowsPerPass = 4;
+
+  if (k == 0) {
+    for (int64_t i = 0; i < m; ++i) {
+      if (!accumulate) {
+        for (int64_t j = 0; j < n; ++j)
+          c[i * rsC + j * csC] = T(0);
+      }
+      epilogue(i, 0, c + i * rsC, n);
+    }
+    return;
+  }
+
+  // A rows are used directly when row-major, otherwise packed per block
+  // Buffers are sized to the problem so that small (e.g. batched) GEMMs do
+  // not pay for full blocks
+  bool packA = csA != 1;
+  size_t panelK = static_cast<size_t>(std::min<int64_t>(blockK, k));
+  size_t panelN = static_cast<size_t>(std::min<int64_t>(blockN, n));
+  std::vector<T> panelB(panelK * panelN);
+  std::vector<T> panelA(packA ? rowsPerPass * panelK : 0);
+  std::vector<T> acc(rowsPerPass * panelN);
+
+  for (int64_t j0 = 0; j0 < n; j0 += blockN) {
+    int nb = static_cast<int>(std::min<int64_t>(blockN, n - j0));
+    for (int64_t p0 = 0; p0 < k; p0 += blockK) {
+      int kb = static_cast<int>(std::min<int64_t>(blockK, k - p0));
+      bool firstK = p0 == 0;
+      bool lastK = p0 + kb == k;
+
+      // Pack B[p0:p0+kb, j0:j0+nb] row-major; column-major B (a transposed
+      // operand) is read down its contiguous columns instead
+      if (csB == 1 || rsB != 1) {
+        for (int p = 0; p < kb; ++p) {
+          const T *src = b + (p0 + p) * rsB + j0 * csB;
+          T *dst = panelB.data() + static_cast<size_t>(p) * nb;
+          for (int j = 0; j < nb; ++j)
+            dst[j] = src[j * csB];
+        }
+      } else {
+        for (int j = 0; j < nb; ++j) {
+          const T *src = b + p0 + (j0 + j) * csB;
+          for (int p = 0; p < kb; ++p)
+            panelB[static_cast<size_t>(p) * nb + j] = src[p];
+        }
+      }
+
+      for (int64_t i0 = 0; i0 < m; i0 += rowsPerPass) {
+        int mb = static_cast<int>(std::min<int64_t>(rowsPerPass, m - i0));
+
+        const T *rowsA[rowsPerPass];
+        if (packA) {
+          for (int r = 0; r < mb; ++r) {
+            const T *src = a + (i0 + r) * rsA + p0 * csA;
+            T *dst = panelA.data() + static_cast<size_t>(r) * kb;
+            for (int p = 0; p < kb; ++p)
+              dst[p] = src[p * csA];
+            rowsA[r] = dst;
+          }
+        } else {
+          for (int r = 0; r < mb; ++r)
+            rowsA[r] = a + (i0 + r) * rsA + p0;
+        }
+        for (int r = mb; r < rowsPerPass; ++r)
+          rowsA[r] = rowsA[0];
+
+        std::fill(acc.begin(), acc.begin() + rowsPerPass * nb, T(0));
+        T *acc0 = acc.data();
+        T *acc1 = acc0 + nb;
+        T *acc2 = acc1 + nb;
+        T *acc3 = acc2 + nb;
+
+        // Four rows share every load of the B panel
+        for (int p = 0; p < kb; ++p) {
+          const T *bRow = panelB.data() + static_cast<size_t>(p) * nb;
+          T a0 = rowsA[0][p];
+          T a1 = rowsA[1][p];
+          T a2 = rowsA[2][p];
+          T a3 = rowsA[3][p];
+          for (int j = 0; j < nb; ++j) {
+            T bv = bRow[j];
+            acc0[j] += a0 * bv;
+            acc1[j] += a1 * bv;
+            acc2[j] += a2 * bv;
+            acc3[j] += a3 * bv;
+          }
+        }
+
+        for (int r = 0; r < mb; ++r) {
+          const T *src = acc.data() + static_cast<size_t>(r) * nb;
+          T *dst = c + (i0 + r) * rsC + j0 * csC;
+          if (firstK && !accumulate) {
+            for (int j = 0; j < nb; ++j)
+              dst[j * csC] = src[j];
+          } else {
+            for (int j = 0; j < nb; ++j)
+              dst[j * csC] += src[j];
+          }
+          if (lastK)
+            epilogue(i0 + r, j0, dst, nb);
+        }
+      }
+    }
+  }
+}
+
+// Elements per independently generated chunk of a random fill. Each chunk
+// owns a fixed range of generator counters, so chunks can be produced by any
+// thread in any order with identical results.
+constexpr int kRandomChunk = 4096;
+
+// 32-bit random words consumed per value of T
+template <typename T> constexpr int _wordsPerValue = sizeof(T) > 4 ? 2 : 1;
+
+// Fill `count` values, each consuming `words` random words: generates the
+// words of every chunk and lets `transform(bits, out, n)` convert them.
+// Chunks are filled in parallel when OpenMP is available; a chunk always
+// fits a 32-bit count, so transforms index with int.
+template <typename T, typename Transform>
+void _fillRandom(T *out, int64_t count, int words, Generator &generator,
+                 Transform transform) {
+  int64_t chunks = (count + kRandomChunk - 1) / kRandomChunk;
+  uint64_t blocksPerChunk = static_cast<uint64_t>(kRandomChunk) * words / 4;
+  uint64_t first = generator.reserve(chunks * blocksPerChunk);
+
+#pragma omp parallel if (chunks > 1)
+  {
+    std::vector<uint32_t> bits(static_cast<size_t>(kRandomChunk) * words);
+
+#pragma omp for schedule(static)
+    for (int64_t c = 0; c < chunks; ++c) {
+      int64_t begin = c * kRandomChunk;
+      int n = static_cast<int>(std::min<int64_t>(kRandomChunk, count - begin));
+      // Rounded up to an even count for transforms working on pairs
+      size_t blocks = (static_cast<size_t>(n + 1) / 2 * 2 * words + 3) / 4;
+      generator.generate(first + c * blocksPerChunk, blocks, bits.data());
+      transform(bits.data(), out + begin, n);
+    }
+  }
+}
+
+// Uniform value in [0, 1) with full mantissa precision
+template <typename T> T _uniform01(const uint32_t *bits) {
+  if constexpr (sizeof(T) > 4) {
+    uint64_t word = (static_cast<uint64_t>(bits[0]) << 32) | bits[1];
+    return static_cast<T>(word >> 11) * T(0x1p-53);
+  } else {
+    return static_cast<T>(bits[0] >> 8) * T(0x1p-24);
+  }
+}
+
+inline uint64_t _word64(const uint32_t *bits) {
+  return (static_cast<uint64_t>(bits[0]) << 32) | bits[1];
+}
+
+// Map a 32-bit word to [0, range) by multiply-shift (range <= 2^32)
+inline uint64_t _boundedWord(uint32_t word, uint64_t range) {
+  return (static_cast<uint64_t>(word) * range) >> 32;
+}
+
+// Words below the returned threshold occur with probability p
+inline uint64_t _wordThreshold(double p) {
+  return static_cast<uint64_t>(p * 4294967296.0);
+}
+
+// Deleter of a `new T[]` buffer that reports its release to the memory
+// tracker (token 0: untracked)
+template <typename T> auto _trackedDeleter(uint64_t token) {
+  return [token](void *ptr) {
+    delete[] static_cast<T *>(ptr);
+    MemoryTracker::release(token);
+  };
+}
+
+// Profiler start time of an op, or -1 while the profiler is disabled
+inline int64_t _profileStart() {
+  return Profiler::enabled() ? Profiler::now() : -1;
+}
+
+// Nominal cost from FLOPs and element counts read and written
+template <typename T>
+OpCost _cost(int64_t flops, int64_t readElements, int64_t writtenElements) {
+  OpCost cost;
+  cost.flops = static_cast<uint64_t>(flops);
+  cost.bytesRead = static_cast<uint64_t>(readElements) * sizeof(T);
+  cost.bytesWritten = static_cast<uint64_t>(writtenElements) * sizeof(T);
+  return cost;
+}
+
+std::string _shapeText(const Shape &shape) {
+  std::string text;
+  for (size_t i = 0; i < shape.size(); ++i)
+    text += (i > 0 ? "x" : "") + std::to_string(shape[i]);
+  return text;
+}
+
+// Records `node` with the profiler: its forward op (just computed) or its
+// backward closure (just run), timed from `start`. No-op when start < 0.
+template <typename T>
+void _profileOp(const BasicNDArray<T> &node, int64_t start, OpCost cost,
+                ProfilePhase phase) {
+  if (start < 0)
+    return;
+
+  ProfileEvent event;
+  event.op = node.op;
+  event.label = node.label;
+  event.phase = phase;
+  event.startNs = start;
+  event.durationNs = Profiler::now() - start;
+  event.cost = cost;
+  for (size_t i = 0; i < node.prev.size(); ++i) {
+    const BasicNDArray<T> &input = node.prev[i].get();
+    event.shapes += (i > 0 ? ", " : "") + _shapeText(input.shape);
+    if (node.label.empty() && !input.label.empty())
+      event.label += (event.label.empty() ? "" : ", ") + input.label;
+  }
+  event.shapes += " -> " + _shapeText(node.shape);
+  Profiler::record(std::move(event));
+}
+
+// Copies the elements of a strided array into contiguous row-major `out`
+template <typename T>
+void _gatherStrided(const T *src, const Shape &shape, const Shape &strides,
+                    int64_t count, T *out) {
+  Shape index(shape.size(), 0);
+  for (int64_t i = 0; i < count; ++i) {
+    out[i] = src[detail::_computeOffset(index, strides)];
+
+    for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+}
+
+// Adds contiguous row-major `values` into a strided array (repeated
+// positions of expanded axes accumulate)
+template <typename T>
+void _scatterAddStrided(const T *values, const Shape &shape,
+                        const Shape &strides, int64_t count, T *dst) {
+  Shape index(shape.size(), 0);
+  for (int64_t i = 0; i < count; ++i) {
+    dst[detail::_computeOffset(index, strides)] += values[i];
+
+    for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+}
+
+// Forward kernel of a unary op: applies `function` to n contiguous elements.
+// Instantiated per call site so the loop inlines and auto-vectorizes.
+template <typename T, typename Function> auto _mapKernel(Function function) {
+  return [function](const T *in, T *out, int64_t n) {
+    for (int64_t i = 0; i < n; ++i)
+      out[i] = function(in[i]);
+  };
+}
+
+// Element functions of the transcendental unary ops: the vectorizable
+// approximations of vecmath.h for float, the standard library otherwise
+template <typename T, bool Fast> T _exp(T x) {
+  if constexpr (std::is_same_v<T, float>)
+    return Fast ? detail::_vexpFast(x) : detail::_vexp(x);
+  else
+    return std::exp(x);
+}
+
+template <typename T, bool Fast> T _log(T x) {
+  if constexpr (std::is_same_v<T, float>)
+    return Fast ? detail::_vlogFast(x) : detail::_vlog(x);
+  else
+    return std::log(x);
+}
+
+template <typename T, bool Fast> T _tanh(T x) {
+  if constexpr (std::is_same_v<T, float>)
+    return Fast ? detail::_vtanhFast(x) : detail::_vtanh(x);
+  else
+    return std::tanh(x);
+}
+
+template <typename T, bool Fast> T _sigmoid(T x) {
+  if constexpr (std::is_same_v<T, float>)
+    return Fast ? detail::_vsigmoidFast(x) : detail::_vsigmoid(x);
+  else
+    return T(1) / (T(1) + std::exp(-x));
+}
+
+// GELU and its derivative: exact form (via erfc, which keeps precision in
+// the negative tail), or the tanh approximation
+constexpr double kSqrt1_2 = 0.70710678118654752440;
+constexpr double kInvSqrt2Pi = 0.39894228040143267794;
+constexpr double kSqrt2OverPi = 0.79788456080286535588;
+constexpr double kGeluCubic = 0.044715;
+
+template <typename T> T _geluErf(T x) {
+  // In the tail erfc magnifies the rounding error of its argument about
+  // x^2 times, so float arrays form -x / sqrt(2) and erfc in double
+  if constexpr (std::is_same_v<T, float>)
+    return static_cast<float>(0.5 * x * std::erfc(-x * kSqrt1_2));
+  else
+    return T(0.5) * x * std::erfc(-x * T(kSqrt1_2));
+}
+
+template <typename T> T _geluErfGrad(T x) {
+  T cdf = T(0.5) * std::erfc(-x * T(kSqrt1_2));
+  return cdf + x * T(kInvSqrt2Pi) * std::exp(T(-0.5) * x * x);
+}
+
+template <typename T> T _geluTanh(T x) {
+  T inner = T(kSqrt2OverPi) * (x + T(kGeluCubic) * x * x * x);
+  return T(0.5) * x * (T(1) + _tanh<T, true>(inner));
+}
+
+template <typename T> T _geluTanhGrad(T x) {
+  T inner = T(kSqrt2OverPi) * (x + T(kGeluCubic) * x * x * x);
+  T t = _tanh<T, true>(inner);
+  T dInner = T(kSqrt2OverPi) * (T(1) + T(3 * kGeluCubic) * x * x);
+  return T(0.5) * (T(1) + t) + T(0.5) * x * (T(1) - t * t) * dInner;
+}
+
+// Activation of linear() from the pre-activation z, and its derivative from
+// z and the output y
+template <typename T, Activation A> T _activation(T z) {
+  if constexpr (A == Activation::ReLU)
+    return z < T(0) ? T(0) : z;
+  else if constexpr (A == Activation::GELU)
+    return _geluErf(z);
+  else if constexpr (A == Activation::Tanh)
+    return _tanh<T, false>(z);
+  else if constexpr (A == Activation::Sigmoid)
+    return _sigmoid<T, false>(z);
+  else
+    return z;
+}
+
+template <typename T, Activation A> T _activationGrad(T z, T y) {
+  if constexpr (A == Activation::ReLU)
+    return y > T(0) ? T(1) : T(0);
+  else if constexpr (A == Activation::GELU)
+    return _geluErfGrad(z);
+  else if constexpr (A == Activation::Tanh)
+    return T(1) - y * y;
+  else if constexpr (A == Activation::Sigmoid)
+    return y * (T(1) - y);
+  else
+    return T(1);
+}
+
+// Rows of a contiguous array along one axis: `rows` rows of `length`
+// elements, consecutive elements `step` apart (the product of the dimensions
+// after the axis)
+struct AxisRows {
+  int64_t rows = 1;
+  int64_t length = 1;
+  int64_t step = 1;
+
+  int64_t start(int64_t row) const {
+    return row / step * length * step + row % step;
+  }
+};
+
+AxisRows _axisRows(const Shape &shape, int axis) {
+  AxisRows layout;
+  layout.length = shape[axis];
+  for (int d = 0; d < static_cast<int>(shape.size()); ++d) {
+    if (d < axis)
+      layout.rows *= shape[d];
+    else if (d > axis)
+      layout.step *= shape[d];
+  }
+  layout.rows *= layout.step;
+  return layout;
+}
+
+// Row loops run on one thread below this many elements
+constexpr int64_t kParallelElements = 1 << 15;
+
+// Threads a parallel region may use (1 without OpenMP)
+int _maxThreads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+template <typename T>
+void _gatherRow(const T *src, int64_t step, int64_t n, T *row) {
+  for (int64_t j = 0; j < n; ++j)
+    row[j] = src[j * step];
+}
+
+template <typename T>
+void _scatterRow(const T *row, int64_t step, int64_t n, T *dst) {
+  for (int64_t j = 0; j < n; ++j)
+    dst[j * step] = row[j];
+}
+
+// Max of a contiguous row and sum of exp(x - max) in a single pass. Blocks
+// of kLanes elements add to per-lane partial sums (vectorized exp); a block
+// raising the running max first rescales the partial sums. With `expOut`,
+// also stores exp(x - shift) for every element, where the shift of each
+// block (its running max) is saved in `blockShift`.
+constexpr int kLanes = 16;
+
+template <typename T>
+void _rowMaxSum(const T *x, int64_t n, T &maxOut, T &sumOut,
+                T *expOut = nullptr, T *blockShift = nullptr) {
+  const T negInf = -std::numeric_limits<T>::infinity();
+  T runMax = negInf;
+  T partial[kLanes] = {};
+  for (int64_t i = 0, block = 0; i < n; i += kLanes, ++block) {
+    int64_t count = std::min<int64_t>(kLanes, n - i);
+    T blockMax = x[i];
+    for (int64_t l = 1; l < count; ++l)
+      blockMax = x[i + l] > blockMax ? x[i + l] : blockMax;
+    if (blockMax > runMax) {
+      T scale = _exp<T, false>(runMax - blockMax);
+      for (int l = 0; l < kLanes; ++l)
+        partial[l] *= scale;
+      runMax = blockMax;
+    }
+
+    // Leading -inf elements contribute exp(-inf) = 0 instead of NaN
+    T shift = runMax == negInf ? T(0) : runMax;
+    if (count == kLanes && expOut) {
+      for (int l = 0; l < kLanes; ++l) {
+        T e = _exp<T, false>(x[i + l] - shift);
+        partial[l] += e;
+        expOut[i + l] = e;
+      }
+    } else if (count == kLanes) {
+      for (int l = 0; l < kLanes; ++l)
+        partial[l] += _exp<T, false>(x[i + l] - shift);
+    } else {
+      for (int64_t l = 0; l < count; ++l) {
+        T e = _exp<T, false>(x[i + l] - shift);
+        partial[l] += e;
+        if (expOut)
+          expOut[i + l] = e;
+      }
+    }
+    if (blockShift)
+      blockShift[block] = shift;
+  }
+
+  T sum = T(0);
+  for (int l = 0; l < kLanes; ++l)
+    sum += partial[l];
+  maxOut = runMax;
+  sumOut = sum;
+}
+
+// Softmax (or log-softmax) of every row of contiguous `x` into `out` (which
+// may equal `x`). One pass finds max and sum; softmax stores the shifted
+// exponentials on the way and a second pass only rescales them per block,
+// log-softmax subtracts max + log(sum).
+template <typename T>
+void _softmaxRows(const T *x, T *out, const AxisRows &layout,
+                  bool logarithm) {
+  int64_t n = layout.length;
+  int64_t blocks = (n + kLanes - 1) / kLanes;
+#pragma omp parallel if (layout.rows > 1 &&                                   \
+                             layout.rows * n >= kParallelElements)
+  {
+    std::vector<T> scratch(layout.step > 1 ? 2 * n : 0);
+    std::vector<T> blockShift(blocks);
+
+#pragma omp for schedule(static)
+    for (int64_t r = 0; r < layout.rows; ++r) {
+      int64_t start = layout.start(r);
+      const T *row = x + start;
+      T *outRow = out + start;
+      if (layout.step > 1) {
+        _gatherRow(row, layout.step, n, scratch.data());
+        row = scratch.data();
+        outRow = scratch.data() + n;
+      }
+
+      T max, sum;
+      if (logarithm) {
+        _rowMaxSum(row, n, max, sum);
+        T shift = max + std::log(sum);
+        for (int64_t j = 0; j < n; ++j)
+          outRow[j] = row[j] - shift;
+      } else {
+        _rowMaxSum(row, n, max, sum, outRow, blockShift.data());
+        T inverse = T(1) / sum;
+        for (int64_t b = 0; b < blocks; ++b) {
+          T scale = _exp<T, false>(blockShift[b] - max) * inverse;
+          int64_t end = std::min(n, (b + 1) * kLanes);
+          for (int64_t j = b * kLanes; j < end; ++j)
+            outRow[j] *= scale;
+        }
+      }
+
+      if (layout.step > 1)
+        _scatterRow(outRow, layout.step, n, out + start);
+    }
+  }
+}
+
+// Backward of _softmaxRows from outputs y and dOut into contiguous dA:
+// softmax: dA += y * (dOut - sum(dOut * y)); log-softmax: dA += dOut -
+// exp(y) * sum(dOut)
+template <typename T>
+void _softmaxBackwardRows(const T *y, const T *dOut, T *dA,
+                          const AxisRows &layout, bool logarithm) {
+  int64_t n = layout.length;
+#pragma omp parallel if (layout.rows > 1 &&                                   \
+                             layout.rows * n >= kParallelElements)
+  {
+    std::vector<T> scratch(layout.step > 1 ? 3 * n : 0);
+
+#pragma omp for schedule(static)
+    for (int64_t r = 0; r < layout.rows; ++r) {
+      int64_t start = layout.start(r);
+      const T *yRow = y + start;
+      const T *gRow = dOut + start;
+      T *dRow = dA + start;
+      if (layout.step > 1) {
+        _gatherRow(yRow, layout.step, n, scratch.data());
+        _gatherRow(gRow, layout.step, n, scratch.data() + n);
+        _gatherRow(dRow, layout.step, n, scratch.data() + 2 * n);
+        yRow = scratch.data();
+        gRow = scratch.data() + n;
+        dRow = scratch.data() + 2 * n;
+      }
+
+      T dot = T(0);
+      if (logarithm) {
+        for (int64_t j = 0; j < n; ++j)
+          dot += gRow[j];
+        for (int64_t j = 0; j < n; ++j)
+          dRow[j] += gRow[j] - _exp<T, false>(yRow[j]) * dot;
+      } else {
+        for (int64_t j = 0; j < n; ++j)
+          dot += gRow[j] * yRow[j];
+        for (int64_t j = 0; j < n; ++j)
+          dRow[j] += yRow[j] * (gRow[j] - dot);
+      }
+
+      if (layout.step > 1)
+        _scatterRow(dRow, layout.step, n, dA + start);
+    }
+  }
+}
+
+// Geometry of a grouped 2D convolution of NCHW input with OIHW weights
+// (conv1d runs with height 1); `s*` are the strides of the input array
+struct ConvGeometry {
+  int64_t batch, channels, height, width;
+  int64_t outChannels, kernelH, kernelW, outH, outW;
+  int64_t strideH, strideW, padH, padW, dilationH, dilationW, groups;
+  int64_t sN, sC, sH, sW;
+
+  int64_t groupChannels() const { return channels / groups; }
+  int64_t groupOutChannels() const { return outChannels / groups; }
+  int64_t kernelSize() const { return kernelH * kernelW; }
+  // Rows of the im2col matrix (the reduction length of the GEMM)
+  int64_t columnRows() const { return groupChannels() * kernelSize(); }
+  int64_t pixels() const { return outH * outW; }
+};
+
+// Output indices o in [lo, hi) whose input index o * stride + offset lies in
+// [0, size), so kernel loops run without bounds checks
+void _validRange(int64_t outSize, int64_t size, int64_t stride,
+                 int64_t offset, int64_t &lo, int64_t &hi) {
+  lo = offset >= 0 ? 0 : (stride - 1 - offset) / stride;
+  hi = offset >= size ? 0 : (size - 1 - offset) / stride + 1;
+  hi = std::min(hi, outSize);
+  lo = std::min(lo, hi);
+}
+
+// Rows [r0, r1) of the im2col matrix of one image and group: row
+// (c, i, j) holds x[c, oh * strideH + i * dilationH - padH, ow * strideW +
+// j * dilationW - padW] for every output pixel, 0 in the padding. `x`
+// points at the group's first input channel.
+template <typename T>
+void _im2col(const T *x, const ConvGeometry &g, int64_t r0, int64_t r1,
+             T *cols) {
+  int64_t kernel = g.kernelSize();
+  int64_t pixels = g.pixels();
+  for (int64_t r = r0; r < r1; ++r) {
+    int64_t c = r / kernel;
+    int64_t i = r % kernel / g.kernelW;
+    int64_t j = r % g.kernelW;
+    int64_t rowOffset = i * g.dilationH - g.padH;
+    int64_t colOffset = j * g.dilationW - g.padW;
+    int64_t ohLo, ohHi, owLo, owHi;
+    _validRange(g.outH, g.height, g.strideH, rowOffset, ohLo, ohHi);
+    _validRange(g.outW, g.width, g.strideW, colOffset, owLo, owHi);
+
+    const T *xc = x + c * g.sC;
+    T *row = cols + r * pixels;
+    std::fill(row, row + ohLo * g.outW, T(0));
+    for (int64_t oh = ohLo; oh < ohHi; ++oh) {
+      const T *xr = xc + (oh * g.strideH + rowOffset) * g.sH;
+      T *dst = row + oh * g.outW;
+      std::fill(dst, dst + owLo, T(0));
+      for (int64_t ow = owLo; ow < owHi; ++ow)
+        dst[ow] = xr[(ow * g.strideW + colOffset) * g.sW];
+      std::fill(dst + owHi, dst + g.outW, T(0));
+    }
+    std::fill(row + ohHi * g.outW, row + pixels, T(0));
+  }
+}
+
+// Adjoint of _im2col: adds every column entry back into its input element
+template <typename T>
+void _col2imAdd(const T *cols, const ConvGeometry &g, T *dx) {
+  int64_t kernel = g.kernelSize();
+  int64_t pixels = g.pixels();
+  for (int64_t r = 0; r < g.columnRows(); ++r) {
+    int64_t c = r / kernel;
+    int64_t i = r % kernel / g.kernelW;
+    int64_t j = r % g.kernelW;
+    int64_t rowOffset = i * g.dilationH - g.padH;
+    int64_t colOffset = j * g.dilationW - g.padW;
+    int64_t ohLo, ohHi, owLo, owHi;
+    _validRange(g.outH, g.height, g.strideH, rowOffset, ohLo, ohHi);
+    _validRange(g.outW, g.width, g.strideW, colOffset, owLo, owHi);
+
+    T *dxc = dx + c * g.sC;
+    const T *row = cols + r * pixels;
+    for (int64_t oh = ohLo; oh < ohHi; ++oh) {
+      T *dxr = dxc + (oh * g.strideH + rowOffset) * g.sH;
+      const T *src = row + oh * g.outW;
+      for (int64_t ow = owLo; ow < owHi; ++ow)
+        dxr[(ow * g.strideW + colOffset) * g.sW] += src[ow];
+    }
+  }
+}
+
+// Direct convolution when every group has one input channel (depthwise):
+// each output channel is a sum of kernelSize shifted, scaled input rows,
+// which needs no im2col matrix. Parallel across images and channels.
+template <typename T>
+void _depthwiseConv(const T *x, const ConvGeometry &g, const T *w,
+                    const T *bias, T *out) {
+  int64_t groupOut = g.groupOutChannels();
+  int64_t kernel = g.kernelSize();
+  int64_t pixels = g.pixels();
+  int64_t items = g.batch * g.outChannels;
+#pragma omp parallel for schedule(static)                                      \
+    if (items > 1 && items * pixels * kernel >= kParallelElements)
+  for (int64_t item = 0; item < items; ++item) {
+    int64_t n = item / g.outChannels;
+    int64_t o = item % g.outChannels;
+    const T *xc = x + n * g.sN + o / groupOut * g.sC;
+    T *y = out + item * pixels;
+    std::fill(y, y + pixels, bias[o]);
+    for (int64_t i = 0; i < g.kernelH; ++i) {
+      int64_t rowOffset = i * g.dilationH - g.padH;
+      int64_t ohLo, ohHi;
+      _validRange(g.outH, g.height, g.strideH, rowOffset, ohLo, ohHi);
+      for (int64_t j = 0; j < g.kernelW; ++j) {
+        int64_t colOffset = j * g.dilationW - g.padW;
+        int64_t owLo, owHi;
+        _validRange(g.outW, g.width, g.strideW, colOffset, owLo, owHi);
+        T weight = w[o * kernel + i * g.kernelW + j];
+        for (int64_t oh = ohLo; oh < ohHi; ++oh) {
+          const T *xr = xc + (oh * g.strideH + rowOffset) * g.sH;
+          T *yr = y + oh * g.outW;
+          for (int64_t ow = owLo; ow < owHi; ++ow)
+            yr[ow] += weight * xr[(ow * g.strideW + colOffset) * g.sW];
+        }
+      }
+    }
+  }
+}
+
+// Backward of _depthwiseConv into dx (input strides) and the packed dw and
+// dBias. Parallel across groups: a group owns its input channel and its
+// output channels, so no two threads write the same element.
+template <typename T>
+void _depthwiseConvBackward(const T *x, T *dx, const ConvGeometry &g,
+                            const T *w, const T *dOut, T *dw, T *dBias,
+                            bool parallel) {
+  int64_t groupOut = g.groupOutChannels();
+  int64_t kernel = g.kernelSize();
+  int64_t pixels = g.pixels();
+#pragma omp parallel for schedule(static)                                      \
+    if (parallel && g.groups > 1 &&                                            \
+            g.batch * g.outChannels * pixels * kernel >= kParallelElements)
+  for (int64_t group = 0; group < g.groups; ++group) {
+    for (int64_t n = 0; n < g.batch; ++n) {
+      const T *xc = x + n * g.sN + group * g.sC;
+      T *dxc = dx + n * g.sN + group * g.sC;
+      for (int64_t o = group * groupOut; o < (group + 1) * groupOut; ++o) {
+        const T *gy = dOut + (n * g.outChannels + o) * pixels;
+        T biasSum = T(0);
+        for (int64_t p = 0; p < pixels; ++p)
+          biasSum += gy[p];
+        dBias[o] += biasSum;
+
+        for (int64_t i = 0; i < g.kernelH; ++i) {
+          int64_t rowOffset = i * g.dilationH - g.padH;
+          int64_t ohLo, ohHi;
+          _validRange(g.outH, g.height, g.strideH, rowOffset, ohLo, ohHi);
+          for (int64_t j = 0; j < g.kernelW; ++j) {
+            int64_t colOffset = j * g.dilationW - g.padW;
+            int64_t owLo, owHi;
+            _validRange(g.outW, g.width, g.strideW, colOffset, owLo, owHi);
+            int64_t tap = o * kernel + i * g.kernelW + j;
+            T weight = w[tap];
+            T weightSum = T(0);
+            for (int64_t oh = ohLo; oh < ohHi; ++oh) {
+              int64_t base = (oh * g.strideH + rowOffset) * g.sH;
+              const T *xr = xc + base;
+              T *dxr = dxc + base;
+              const T *gr = gy + oh * g.outW;
+              for (int64_t ow = owLo; ow < owHi; ++ow) {
+                int64_t at = (ow * g.strideW + colOffset) * g.sW;
+                weightSum += gr[ow] * xr[at];
+                dxr[at] += weight * gr[ow];
+              }
+            }
+            dw[tap] += weightSum;
+          }
+        }
+      }
+    }
+  }
+}
+
+// One image plane of max pooling: y[p] is the largest input in the window of
+// output pixel p and arg[p] its offset from `x` (the array's data pointer),
+// cached for backward. `base` is the plane's offset.
+template <typename T>
+void _maxPoolPlane(const T *x, int64_t base, const ConvGeometry &g, T *y,
+                   int64_t *arg) {
+  std::fill(y, y + g.pixels(), T(0));
+  std::fill(arg, arg + g.pixels(), int64_t(-1));
+  for (int64_t oh = 0; oh < g.outH; ++oh) {
+    T *yr = y + oh * g.outW;
+    int64_t *ar = arg + oh * g.outW;
+    for (int64_t i = 0; i < g.kernelH; ++i) {
+      int64_t ih = oh * g.strideH - g.padH + i;
+      if (ih < 0 || ih >= g.height)
+        continue;
+      for (int64_t j = 0; j < g.kernelW; ++j) {
+        int64_t owLo, owHi;
+        _validRange(g.outW, g.width, g.strideW, j - g.padW, owLo, owHi);
+        int64_t rowBase = base + ih * g.sH + (j - g.padW) * g.sW;
+        for (int64_t ow = owLo; ow < owHi; ++ow) {
+          int64_t at = rowBase + ow * g.strideW * g.sW;
+          T v = x[at];
+          bool better = ar[ow] < 0 || v > yr[ow];
+          yr[ow] = better ? v : yr[ow];
+          ar[ow] = better ? at : ar[ow];
+        }
+      }
+    }
+  }
+}
+
+// One image plane of average pooling (padding counts as zeros) or, with
+// `backward`, its adjoint: adds scale * dy to every element of each window
+template <typename T>
+void _avgPoolPlane(const T *x, T *dx, const ConvGeometry &g, T scale, T *y,
+                   const T *dy) {
+  if (!dy)
+    std::fill(y, y + g.pixels(), T(0));
+  for (int64_t oh = 0; oh < g.outH; ++oh) {
+    for (int64_t i = 0; i < g.kernelH; ++i) {
+      int64_t ih = oh * g.strideH - g.padH + i;
+      if (ih < 0 || ih >= g.height)
+        continue;
+      for (int64_t j = 0; j < g.kernelW; ++j) {
+        int64_t owLo, owHi;
+        _validRange(g.outW, g.width, g.strideW, j - g.padW, owLo, owHi);
+        int64_t rowBase = ih * g.sH + (j - g.padW) * g.sW;
+        if (dy) {
+          const T *gr = dy + oh * g.outW;
+          for (int64_t ow = owLo; ow < owHi; ++ow)
+            dx[rowBase + ow * g.strideW * g.sW] += scale * gr[ow];
+        } else {
+          T *yr = y + oh * g.outW;
+          for (int64_t ow = owLo; ow < owHi; ++ow)
+            yr[ow] += x[rowBase + ow * g.strideW * g.sW];
+        }
+      }
+    }
+  }
+  if (!dy) {
+    for (int64_t p = 0; p < g.pixels(); ++p)
+      y[p] *= scale;
+  }
+}
+
+// Count, mean and sum of squared deviations of a set of values. merge()
+// joins two sets (Chan et al.), so partial results of lanes, rows or slices
+// combine in any grouping.
+template <typename T> struct Moments {
+  int64_t count = 0;
+  T mean = T(0);
+  T m2 = T(0);
+
+  void merge(const Moments &other) {
+    if (other.count == 0)
+      return;
+    int64_t total = count + other.count;
+    T delta = other.mean - mean;
+    T weight = T(other.count) / T(total);
+    mean += delta * weight;
+    m2 += other.m2 + delta * delta * T(count) * weight;
+    count = total;
+  }
+
+  // Biased (population) variance
+  T variance() const { return count > 0 ? m2 / T(count) : T(0); }
+};
+
+// `values` (n elements `step` apart) as a contiguous pointer: itself when
+// the elements are adjacent, else a copy made in `copy`
+template <typename T>
+const T *_unitStride(const T *values, int64_t n, int64_t step,
+                     std::vector<T> &copy) {
+  if (step == 1)
+    return values;
+  copy.resize(n);
+  _gatherRow(values, step, n, copy.data());
+  return copy.data();
+}
+
+// Sum of kLanes values by pairwise halving (short dependency chains; `v`
+// is overwritten)
+template <typename T> T _laneSum(T *v) {
+  for (int width = kLanes / 2; width > 0; width /= 2)
+    for (int l = 0; l < width; ++l)
+      v[l] += v[l + width];
+  return v[0];
+}
+
+// Welford moments of a contiguous row in one pass. kLanes interleaved
+// accumulators share the reciprocal count of each block, so the update
+// vectorizes. Lanes hold equal counts and combine directly; the tail (fewer
+// than kLanes values, still in cache) is merged once.
+template <typename T> Moments<T> _moments(const T *x, int64_t n) {
+  Moments<T> result;
+  int64_t blocks = n / kLanes;
+  if (blocks > 0) {
+    T mean[kLanes] = {};
+    T m2[kLanes] = {};
+    for (int64_t b = 0; b < blocks; ++b) {
+      T inverse = T(1) / T(b + 1);
+      const T *block = x + b * kLanes;
+      for (int l = 0; l < kLanes; ++l) {
+        T delta = block[l] - mean[l];
+        mean[l] += delta * inverse;
+        m2[l] += delta * (block[l] - mean[l]);
+      }
+    }
+
+    T spread[kLanes];
+    std::copy(mean, mean + kLanes, spread);
+    T laneMean = _laneSum(spread) * (T(1) / T(kLanes));
+    for (int l = 0; l < kLanes; ++l) {
+      T delta = mean[l] - laneMean;
+      spread[l] = m2[l] + T(blocks) * delta * delta;
+    }
+    result = Moments<T>{blocks * kLanes, laneMean, _laneSum(spread)};
+  }
+
+  int64_t tail = n - blocks * kLanes;
+  if (tail > 0) {
+    const T *rest = x + blocks * kLanes;
+    T sum = T(0);
+    for (int64_t i = 0; i < tail; ++i)
+      sum += rest[i];
+    T tailMean = sum / T(tail);
+    T tailM2 = T(0);
+    for (int64_t i = 0; i < tail; ++i)
+      tailM2 += (rest[i] - tailMean) * (rest[i] - tailMean);
+    result.merge(Moments<T>{tail, tailMean, tailM2});
+  }
+  return result;
+}
+// Validated copy of an index array in row-major order
+std::vector<int64_t> _indexList(const BasicNDArray<int64_t> &indices,
+                                int64_t limit, const std::string &opName) {
+  std::vector<int64_t> result(indices.size);
+  if (indices.isContiguous())
+    std::copy(indices.data, indices.data + indices.size, result.begin());
+  else
+    _gatherStrided(indices.data, indices.shape, indices.strides, indices.size,
+                   result.data());
+  for (int64_t index : result) {
+    if (index < 0 || index >= limit)
+      throw std::out_of_range("Index " + std::to_string(index) +
+                              " out of range in " + opName + "().");
+  }
+  return result;
+}
+
+// Positions of `indices` grouped by value: value unique[u] occurs at
+// positions order[segments[u]] .. order[segments[u + 1] - 1], increasing
+struct IndexSegments {
+  std::vector<int64_t> unique;
+  std::vector<int64_t> segments;
+  std::vector<int64_t> order;
+};
+
+IndexSegments _segmentIndices(const std::vector<int64_t> &indices) {
+  IndexSegments result;
+  result.order.resize(indices.size());
+  std::iota(result.order.begin(), result.order.end(), int64_t(0));
+  std::stable_sort(result.order.begin(), result.order.end(),
+                   [&](int64_t a, int64_t b) {
+                     return indices[a] < indices[b];
+                   });
+  for (size_t s = 0; s < result.order.size(); ++s) {
+    int64_t index = indices[result.order[s]];
+    if (result.unique.empty() || result.unique.back() != index) {
+      result.unique.push_back(index);
+      result.segments.push_back(static_cast<int64_t>(s));
+    }
+  }
+  result.segments.push_back(static_cast<int64_t>(result.order.size()));
+  return result;
+}
+
+// Offset under `strides` of the first element of a fiber: `fiber` counts
+// row-major over every axis of `shape` except `axis`
+int64_t _fiberOffset(int64_t fiber, const Shape &shape, int axis,
+                     const Shape &strides) {
+  int64_t offset = 0;
+  for (int d = static_cast<int>(shape.size()) - 1; d >= 0; --d) {
+    if (d == axis)
+      continue;
+    offset += fiber % shape[d] * strides[d];
+    fiber /= shape[d];
+  }
+  return offset;
+}
+
+// Einsum labels are letters, numbered 'A'-'Z' then 'a'-'z' (ASCII order)
+constexpr int kEinsumLabels = 52;
+// Up to this many terms the contraction order is searched exhaustively
+constexpr int kEinsumOptimalTerms = 10;
+// Contractions with fewer multiply-adds per batch skip the blocked GEMM
+constexpr int64_t kEinsumSmallGemm = 1 << 12;
+
+using EinsumSizes = std::array<int64_t, kEinsumLabels>;
+using EinsumStrides = std::array<int64_t, kEinsumLabels>;
+
+int _einsumLabel(char c) {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return 26 + (c - 'a');
+  return -1;
+}
+
+std::string _einsumChar(int label) {
+  char c = label < 26 ? char('A' + label) : char('a' + label - 26);
+  return std::string(1, c);
+}
+
+uint64_t _labelSet(const std::vector<int> &labels) {
+  uint64_t set = 0;
+  for (int label : labels)
+    set |= uint64_t(1) << label;
+  return set;
+}
+
+// Product of the extents of a set of labels (as a double: only compared)
+double _volume(uint64_t set, const EinsumSizes &sizes) {
+  double volume = 1.0;
+  for (int label = 0; label < kEinsumLabels; ++label) {
+    if (set >> label & 1)
+      volume *= static_cast<double>(sizes[label]);
+  }
+  return volume;
+}
+
+// A parsed equation: the labels of every operand axis (repeats allowed) and
+// output axis, and the extent of every label
+struct EinsumEquation {
+  std::vector<std::vector<int>> inputs;
+  std::vector<int> output;
+  EinsumSizes sizes{};
+};
+
+EinsumEquation _parseEinsum(const std::string &equation,
+                            const std::vector<Shape> &shapes) {
+  std::string text;
+  for (char c : equation) {
+    if (c != ' ')
+      text += c;
+  }
+  size_t arrow = text.find("->");
+  std::string inputs = text.substr(0, arrow);
+  std::vector<std::string> terms;
+  for (size_t start = 0;;) {
+    size_t comma = inputs.find(',', start);
+    terms.push_back(inputs.substr(start, comma - start));
+    if (comma == std::string::npos)
+      break;
+    start = comma + 1;
+  }
+  if (terms.size() != shapes.size()) {
+    throw std::invalid_argument(
+        "einsum() equation '" + equation + "' has " +
+        std::to_string(terms.size()) + " input terms for " +
+        std::to_string(shapes.size()) + " operands.");
+  }
+
+  auto labelsOf = [&equation](const std::string &term) {
+    std::vector<int> labels;
+    for (char c : term) {
+      int label = _einsumLabel(c);
+      if (label < 0) {
+        throw std::invalid_argument("Invalid character '" +
+                                    std::string(1, c) +
+                                    "' in einsum() equation '" + equation +
+                                    "'.");
+      }
+      labels.push_back(label);
+    }
+    return labels;
+  };
+
+  EinsumEquation result;
+  result.sizes.fill(-1);
+  std::array<int, kEinsumLabels> counts{};
+  for (size_t t = 0; t < terms.size(); ++t) {
+    std::vector<int> labels = labelsOf(terms[t]);
+    if (labels.size() != shapes[t].size()) {
+      throw std::invalid_argument(
+          "einsum() term '" + terms[t] + "' has " +
+          std::to_string(labels.size()) + " labels for an operand with " +
+          std::to_string(shapes[t].size()) + " axes.");
+    }
+    for (size_t d = 0; d < labels.size(); ++d) {
+      int64_t &size = result.sizes[labels[d]];
+      if (size >= 0 && size != shapes[t][d]) {
+        throw std::invalid_argument(
+            "einsum() label '" + _einsumChar(labels[d]) + "' has extents " +
+            std::to_string(size) + " and " + std::to_string(shapes[t][d]) +
+            ".");
+      }
+      size = shapes[t][d];
+      counts[labels[d]]++;
+    }
+    result.inputs.push_back(labels);
+  }
+
+  // Without "->" the output holds the labels used once, in ASCII order
+  if (arrow == std::string::npos) {
+    for (int label = 0; label < kEinsumLabels; ++label) {
+      if (counts[label] == 1)
+        result.output.push_back(label);
+    }
+    return result;
+  }
+  result.output = labelsOf(text.substr(arrow + 2));
+  uint64_t seen = 0;
+  for (int label : result.output) {
+    if (counts[label] == 0) {
+      throw std::invalid_argument("einsum() output label '" +
+                                  _einsumChar(label) +
+                                  "' does not appear in the inputs.");
+    }
+    if (seen >> label & 1) {
+      throw std::invalid_argument("einsum() output label '" +
+                                  _einsumChar(label) + "' is repeated.");
+    }
+    seen |= uint64_t(1) << label;
+  }
+  return result;
+}
+
+// An operand or intermediate of an einsum: a strided array with one
+// distinct label per axis
+template <typename T> struct EinsumTerm {
+  const T *data = nullptr;
+  std::vector<int> labels;
+  EinsumStrides strides{}; // By label; 0 for labels not in the term
+  std::shared_ptr<std::vector<T>> buffer; // Owns the data of intermediates
+};
+
+// Where the result of an einsum goes: a strided array with one distinct
+// label per axis, overwritten or accumulated into
+template <typename T> struct EinsumTarget {
+  T *data = nullptr;
+  std::vector<int> labels;
+  EinsumStrides strides{};
+  bool accumulate = false;
+};
+
+// Labels and strides of an array addressed by `labels`; a repeated label is
+// one diagonal axis whose stride is the sum of the repeated axes' strides
+std::vector<int> _einsumAxes(const std::vector<int> &labels,
+                             const Shape &strides, EinsumStrides &merged) {
+  std::vector<int> unique;
+  for (size_t d = 0; d < labels.size(); ++d) {
+    if (std::find(unique.begin(), unique.end(), labels[d]) == unique.end())
+      unique.push_back(labels[d]);
+    merged[labels[d]] += strides[d];
+  }
+  return unique;
+}
+
+template <typename T>
+EinsumTerm<T> _einsumTerm(const T *data, const std::vector<int> &labels,
+                          const Shape &strides) {
+  EinsumTerm<T> term;
+  term.data = data;
+  term.labels = _einsumAxes(labels, strides, term.strides);
+  return term;
+}
+
+// New contiguous term with axes `labels`
+template <typename T>
+EinsumTerm<T> _einsumBuffer(const std::vector<int> &labels,
+                            const EinsumSizes &sizes) {
+  EinsumTerm<T> term;
+  term.labels = labels;
+  int64_t count = 1;
+  for (size_t d = labels.size(); d-- > 0;) {
+    term.strides[labels[d]] = count;
+    count *= sizes[labels[d]];
+  }
+  term.buffer = std::make_shared<std::vector<T>>(count);
+  term.data = term.buffer->data();
+  return term;
+}
+
+// Orders `group` by decreasing stride, the order in which it can merge
+void _sortByStride(std::vector<int> &group, const EinsumStrides &strides) {
+  std::stable_sort(group.begin(), group.end(), [&](int a, int b) {
+    return strides[a] > strides[b];
+  });
+}
+
+// Extent and stride of the labels of `group` read as a single axis; false
+// when they are not laid out as one strided axis. Size-1 labels are skipped.
+bool _mergeAxes(const std::vector<int> &group, const EinsumStrides &strides,
+                const EinsumSizes &sizes, int64_t &extent, int64_t &stride) {
+  extent = 1;
+  stride = 0;
+  int previous = -1;
+  for (int label : group) {
+    if (sizes[label] == 1)
+      continue;
+    if (previous >= 0 && strides[previous] != strides[label] * sizes[label])
+      return false;
+    extent *= sizes[label];
+    stride = strides[label];
+    previous = label;
+  }
+  return true;
+}
+
+// Contiguous copy of `term` with its axes in `order`
+template <typename T>
+EinsumTerm<T> _einsumPack(const EinsumTerm<T> &term,
+                          const std::vector<int> &order,
+                          const EinsumSizes &sizes) {
+  EinsumTerm<T> packed = _einsumBuffer<T>(order, sizes);
+  T *out = packed.buffer->data();
+  int64_t count = static_cast<int64_t>(packed.buffer->size());
+  int rank = static_cast<int>(order.size());
+  std::vector<int64_t> index(rank, 0);
+  int64_t offset = 0;
+  for (int64_t i = 0; i < count; ++i) {
+    out[i] = term.data[offset];
+
+    for (int d = rank - 1; d >= 0; --d) {
+      int label = order[d];
+      index[d]++;
+      offset += term.strides[label];
+      if (index[d] < sizes[label])
+        break;
+      offset -= index[d] * term.strides[label];
+      index[d] = 0;
+    }
+  }
+  return packed;
+}
+
+// target (+)= term; target labels missing from the term are broadcast
+template <typename T>
+void _einsumWrite(const EinsumTerm<T> &term, const EinsumTarget<T> &target,
+                  const EinsumSizes &sizes) {
+  int rank = static_cast<int>(target.labels.size());
+  int64_t count = 1;
+  for (int label : target.labels)
+    count *= sizes[label];
+  std::vector<int64_t> index(rank, 0);
+  int64_t src = 0;
+  int64_t dst = 0;
+  for (int64_t i = 0; i < count; ++i) {
+    if (target.accumulate)
+      target.data[dst] += term.data[src];
+    else
+      target.data[dst] = term.data[src];
+
+    for (int d = rank - 1; d >= 0; --d) {
+      int label = target.labels[d];
+      index[d]++;
+      src += term.strides[label];
+      dst += target.strides[label];
+      if (index[d] < sizes[label])
+        break;
+      src -= index[d] * term.strides[label];
+      dst -= index[d] * target.strides[label];
+      index[d] = 0;
+    }
+  }
+}
+
+// Unblocked C (+)= A * B, for products too small to amortize packing
+template <typename T>
+void _smallGemm(int64_t m, int64_t n, int64_t k, const T *a, int64_t rsA,
+                int64_t csA, const T *b, int64_t rsB, int64_t csB, T *c,
+                int64_t rsC, int64_t csC, bool accumulate) {
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      T sum = T(0);
+      for (int64_t p = 0; p < k; ++p)
+        sum += a[i * rsA + p * csA] * b[p * rsB + j * csB];
+      T &out = c[i * rsC + j * csC];
+      out = accumulate ? out + sum : sum;
+    }
+  }
+}
+
+// Contracts a and b, keeping the labels in `keep`, as one GEMM per batch
+// index: C[batch, m, n] = sum_k A[batch, m, k] * B[batch, k, n], where m, k
+// and n each merge any number of labels. An operand whose labels cannot be
+// merged in place is packed first. C goes straight to `target` when its
+// layout allows (the returned term then has no data); otherwise it is
+// returned as a new contiguous term.
+template <typename T>
+EinsumTerm<T> _einsumPair(EinsumTerm<T> a, EinsumTerm<T> b, uint64_t keep,
+                          const EinsumSizes &sizes,
+                          const EinsumTarget<T> *target) {
+  uint64_t inB = _labelSet(b.labels);
+  uint64_t inA = _labelSet(a.labels);
+  std::vector<int> batch, m, k, n;
+  for (int label : a.labels) {
+    if (!(inB >> label & 1))
+      m.push_back(label);
+    else if (keep >> label & 1)
+      batch.push_back(label);
+    else
+      k.push_back(label);
+  }
+  for (int label : b.labels) {
+    if (!(inA >> label & 1))
+      n.push_back(label);
+  }
+
+  int64_t rows, depth, cols, rsA, csA, rsB, csB, rsC, csC;
+  _sortByStride(m, a.strides);
+  _sortByStride(n, b.strides);
+  _sortByStride(k, a.strides);
+  if (!_mergeAxes(k, a.strides, sizes, depth, csA))
+    _sortByStride(k, b.strides);
+  if (!_mergeAxes(m, a.strides, sizes, rows, rsA) ||
+      !_mergeAxes(k, a.strides, sizes, depth, csA)) {
+    std::vector<int> order = batch;
+    order.insert(order.end(), m.begin(), m.end());
+    order.insert(order.end(), k.begin(), k.end());
+    a = _einsumPack(a, order, sizes);
+    _mergeAxes(m, a.strides, sizes, rows, rsA);
+    _mergeAxes(k, a.strides, sizes, depth, csA);
+  }
+  if (!_mergeAxes(k, b.strides, sizes, depth, rsB) ||
+      !_mergeAxes(n, b.strides, sizes, cols, csB)) {
+    std::vector<int> order = batch;
+    order.insert(order.end(), k.begin(), k.end());
+    order.insert(order.end(), n.begin(), n.end());
+    b = _einsumPack(b, order, sizes);
+    _mergeAxes(k, b.strides, sizes, depth, rsB);
+    _mergeAxes(n, b.strides, sizes, cols, csB);
+  }
+
+  // The target is written in place when it holds exactly the kept labels,
+  // merges like C and has no broadcast (stride 0) axis
+  bool direct = target != nullptr && _labelSet(target->labels) == keep &&
+                _mergeAxes(m, target->strides, sizes, rows, rsC) &&
+                _mergeAxes(n, target->strides, sizes, cols, csC);
+  for (size_t d = 0; direct && d < target->labels.size(); ++d) {
+    int label = target->labels[d];
+    direct = sizes[label] == 1 || target->strides[label] != 0;
+  }
+  EinsumTerm<T> c;
+  T *out;
+  const EinsumStrides *outStrides;
+  bool accumulate = false;
+  if (direct) {
+    out = target->data;
+    outStrides = &target->strides;
+    accumulate = target->accumulate;
+  } else {
+    std::vector<int> order = batch;
+    order.insert(order.end(), m.begin(), m.end());
+    order.insert(order.end(), n.begin(), n.end());
+    c = _einsumBuffer<T>(order, sizes);
+    out = c.buffer->data();
+    outStrides = &c.strides;
+    _mergeAxes(m, c.strides, sizes, rows, rsC);
+    _mergeAxes(n, c.strides, sizes, cols, csC);
+  }
+
+  std::vector<int> batchAxes;
+  int64_t batches = 1;
+  for (int label : batch) {
+    if (sizes[label] != 1) {
+      batchAxes.push_back(label);
+      batches *= sizes[label];
+    }
+  }
+
+  // Work items are (batch index, block of C rows or, when C is wider than
+  // tall, of columns); elements of C are computed independently, so results
+  // do not depend on the blocking
+  int64_t flops = 2 * batches * rows * cols * depth;
+  bool small = rows * cols * depth < kEinsumSmallGemm;
+  int threads = flops >= kParallelElements ? _maxThreads() : 1;
+  bool byColumns = cols > rows;
+  int64_t extent = byColumns ? cols : rows;
+  int64_t block = extent;
+  if (batches < threads && extent > 0) {
+    int64_t split = (threads + batches - 1) / batches;
+    block = ((extent + split - 1) / split + 3) / 4 * 4;
+  }
+  int64_t blocks = block > 0 ? (extent + block - 1) / block : 0;
+  int64_t items = batches * blocks;
+  const T *aData = a.data;
+  const T *bData = b.data;
+#pragma omp parallel for schedule(static)                                      \
+    if (threads > 1 && items > 1)
+  for (int64_t item = 0; item < items; ++item) {
+    int64_t start = item % blocks * block;
+    int64_t count = std::min(block, extent - start);
+    int64_t rest = item / blocks;
+    int64_t offA = byColumns ? 0 : start * rsA;
+    int64_t offB = byColumns ? start * csB : 0;
+    int64_t offC = start * (byColumns ? csC : rsC);
+    for (size_t d = batchAxes.size(); d-- > 0;) {
+      int label = batchAxes[d];
+      int64_t index = rest % sizes[label];
+      rest /= sizes[label];
+      offA += index * a.strides[label];
+      offB += index * b.strides[label];
+      offC += index * (*outStrides)[label];
+    }
+    int64_t itemRows = byColumns ? rows : count;
+    int64_t itemCols = byColumns ? count : cols;
+    if (small)
+      _smallGemm(itemRows, itemCols, depth, aData + offA, rsA, csA,
+                 bData + offB, rsB, csB, out + offC, rsC, csC, accumulate);
+    else
+      _gemm(itemRows, itemCols, depth, aData + offA, rsA, csA, bData + offB,
+            rsB, csB, out + offC, rsC, csC, accumulate);
+  }
+  return c;
+}
+
+// Appends the steps contracting the terms in `mask` along the splits found
+// by _einsumPath; `term` receives the id of the resulting term
+void _emitPath(int mask, const std::vector<int> &split, int &next,
+               std::vector<std::pair<int, int>> &path, int &term) {
+  if ((mask & (mask - 1)) == 0) {
+    term = 0;
+    while (!(mask >> term & 1))
+      ++term;
+    return;
+  }
+  int left, right;
+  _emitPath(split[mask], split, next, path, left);
+  _emitPath(mask ^ split[mask], split, next, path, right);
+  path.emplace_back(left, right);
+  term = next++;
+}
+
+// Pairwise contraction order of terms with label sets `sets` that minimizes
+// the total multiply-adds (the product of the extents of all labels of each
+// pair): exhaustive over subsets for up to kEinsumOptimalTerms terms, greedy
+// beyond. Step s contracts terms i and j into term sets.size() + s.
+std::vector<std::pair<int, int>> _einsumPath(const std::vector<uint64_t> &sets,
+                                             uint64_t output,
+                                             const EinsumSizes &sizes) {
+  int count = static_cast<int>(sets.size());
+  std::vector<std::pair<int, int>> path;
+  if (count <= kEinsumOptimalTerms) {
+    int full = (1 << count) - 1;
+    // Labels of each subset of terms, and those its contraction keeps
+    std::vector<uint64_t> labels(full + 1, 0);
+    for (int mask = 1; mask <= full; ++mask) {
+      int low = 0;
+      while (!(mask >> low & 1))
+        ++low;
+      labels[mask] = labels[mask ^ (1 << low)] | sets[low];
+    }
+    std::vector<uint64_t> kept(full + 1);
+    for (int mask = 1; mask <= full; ++mask)
+      kept[mask] = labels[mask] & (labels[full ^ mask] | output);
+
+    std::vector<double> cost(full + 1, 0.0);
+    std::vector<int> split(full + 1, 0);
+    for (int mask = 1; mask <= full; ++mask) {
+      if ((mask & (mask - 1)) == 0)
+        continue;
+      int low = mask & -mask;
+      cost[mask] = std::numeric_limits<double>::infinity();
+      // Each split once: the first part holds the lowest term
+      for (int part = (mask - 1) & mask; part > 0; part = (part - 1) & mask) {
+        if (!(part & low))
+          continue;
+        int rest = mask ^ part;
+        double total = cost[part] + cost[rest] +
+                       _volume(kept[part] | kept[rest], sizes);
+        if (total < cost[mask]) {
+          cost[mask] = total;
+          split[mask] = part;
+        }
+      }
+    }
+    int next = count;
+    int root;
+    _emitPath(full, split, next, path, root);
+    return path;
+  }
+
+  // Greedy: contract the pair whose result grows the least over its inputs,
+  // then the one with fewer multiply-adds
+  std::vector<uint64_t> alive = sets;
+  std::vector<int> ids(count);
+  std::iota(ids.begin(), ids.end(), 0);
+  int next = count;
+  while (alive.size() > 1) {
+    int bestI = 0, bestJ = 1;
+    uint64_t bestKept = 0;
+    double bestGrowth = std::numeric_limits<double>::infinity();
+    double bestCost = bestGrowth;
+    for (size_t i = 0; i < alive.size(); ++i) {
+      for (size_t j = i + 1; j < alive.size(); ++j) {
+        uint64_t others = output;
+        for (size_t t = 0; t < alive.size(); ++t) {
+          if (t != i && t != j)
+            others |= alive[t];
+        }
+        uint64_t keep = (alive[i] | alive[j]) & others;
+        double growth = _volume(keep, sizes) - _volume(alive[i], sizes) -
+                        _volume(alive[j], sizes);
+        double cost = _volume(alive[i] | alive[j], sizes);
+        if (growth < bestGrowth || (growth == bestGrowth && cost < bestCost)) {
+          bestI = static_cast<int>(i);
+          bestJ = static_cast<int>(j);
+          bestKept = keep;
+          bestGrowth = growth;
+          bestCost = cost;
+        }
+      }
+    }
+    path.emplace_back(ids[bestI], ids[bestJ]);
+    alive.erase(alive.begin() + bestJ);
+    alive.erase(alive.begin() + bestI);
+    ids.erase(ids.begin() + bestJ);
+    ids.erase(ids.begin() + bestI);
+    alive.push_back(bestKept);
+    ids.push_back(next++);
+  }
+  return path;
+}
+
+// Evaluates an einsum of `terms` into `target`: first sums out labels used
+// by a single term and not by the target, then contracts the terms pairwise
+// in the order from _einsumPath. Returns the multiply-adds performed.
+template <typename T>
+double _einsumRun(std::vector<EinsumTerm<T>> terms,
+                  const EinsumTarget<T> &target, const EinsumSizes &sizes) {
+  uint64_t output = _labelSet(target.labels);
+  std::array<int, kEinsumLabels> counts{};
+  for (const EinsumTerm<T> &term : terms) {
+    for (int label : term.labels)
+      counts[label]++;
+  }
+
+  // A reduction is a contraction with a term of ones (all strides 0)
+  const T one = T(1);
+  double work = 0.0;
+  bool single = terms.size() == 1;
+  for (EinsumTerm<T> &term : terms) {
+    EinsumTerm<T> ones;
+    ones.data = &one;
+    for (int label : term.labels) {
+      if (counts[label] == 1 && !(output >> label & 1))
+        ones.labels.push_back(label);
+    }
+    if (ones.labels.empty())
+      continue;
+    uint64_t keep = _labelSet(term.labels) & ~_labelSet(ones.labels);
+    work += _volume(_labelSet(term.labels), sizes);
+    term = _einsumPair(term, ones, keep, sizes, single ? &target : nullptr);
+    if (term.data == nullptr)
+      return work;
+  }
+  if (single) {
+    _einsumWrite(terms[0], target, sizes);
+    return work;
+  }
+
+  std::vector<uint64_t> sets;
+  for (const EinsumTerm<T> &term : terms)
+    sets.push_back(_labelSet(term.labels));
+  std::vector<std::pair<int, int>> path = _einsumPath(sets, output, sizes);
+  std::vector<bool> alive(terms.size(), true);
+  for (size_t s = 0; s < path.size(); ++s) {
+    int i = path[s].first;
+    int j = path[s].second;
+    uint64_t others = output;
+    for (size_t t = 0; t < terms.size(); ++t) {
+      if (alive[t] && static_cast<int>(t) != i && static_cast<int>(t) != j)
+        others |= sets[t];
+    }
+    uint64_t keep = (sets[i] | sets[j]) & others;
+    bool last = s + 1 == path.size();
+    work += _volume(sets[i] | sets[j], sizes);
+    EinsumTerm<T> c = _einsumPair(terms[i], terms[j], keep, sizes,
+                                  last ? &target : nullptr);
+    // Intermediates are freed as soon as they are consumed
+    terms[i] = EinsumTerm<T>();
+    terms[j] = EinsumTerm<T>();
+    alive[i] = alive[j] = false;
+    if (last && c.data != nullptr)
+      _einsumWrite(c, target, sizes);
+    terms.push_back(std::move(c));
+    sets.push_back(keep);
+    alive.push_back(true);
+  }
+  return work;
+}
+} // namespace
+
+template <typename T>
+BasicNDArray<T>::BasicNDArray(
+    Shape inputShape, std::string inputLabel, std::string inputOp,
+    std::vector<std::reference_wrapper<BasicNDArray>> inputPrev) {
   // Initializing the shape
   shape = inputShape;
 
@@ -21,11 +1604,15 @@ NDArray::NDArray(std::vector<int> inputShape, std::string inputLabel,
     size *= shape[i];
   }
 
-  // Initializing the data
-  data = new float[size]();
-
-  // Initializing the grad
-  grad = new float[size]();
+  // Initializing the data and grad: one allocation holding both, released
+  // with the last array or view sharing it
+  data = new T[2 * static_cast<size_t>(size)]();
+  grad = data + size;
+  int64_t bytes = size * static_cast<int64_t>(sizeof(T));
+  uint64_t token =
+      MemoryTracker::allocate(inputOp, inputLabel, shape, bytes, bytes);
+  dataOwner = std::shared_ptr<void>(data, _trackedDeleter<T>(token));
+  gradOwner = dataOwner;
 
   // Initializing the strides
   strides = detail::_computeStrides(shape);
@@ -45,10 +1632,12 @@ NDArray::NDArray(std::vector<int> inputShape, std::string inputLabel,
   _backward = []() {};
 }
 
-NDArray::NDArray(std::vector<int> inputShape, std::vector<int> inputStrides,
-                 float *inputData, bool inputOwnsData, std::string inputLabel,
-                 std::string inputOp,
-                 std::vector<std::reference_wrapper<NDArray>> inputPrev) {
+template <typename T>
+BasicNDArray<T>::BasicNDArray(
+    Shape inputShape, Shape inputStrides, T *inputData,
+    bool inputOwnsData, std::string inputLabel, std::string inputOp,
+    std::vector<std::reference_wrapper<BasicNDArray>> inputPrev,
+    T *inputGrad) {
   shape = inputShape;
   strides = inputStrides;
   data = inputData;
@@ -57,20 +1646,99 @@ NDArray::NDArray(std::vector<int> inputShape, std::vector<int> inputStrides,
   op = inputOp;
   prev = inputPrev;
 
-  size = 1;
-  for (int i = 0; i < shape.size(); i++) {
-    size *= shape[i];
+  size = 1;
+  for (int i = 0; i < shape.size(); i++) {
+    size *= shape[i];
+  }
+
+  ndim = shape.size();
+
+  // Default backward; views bring their base's grad (and its owner)
+  _backward = []() {};
+  if (inputGrad != nullptr) {
+    grad = inputGrad;
+    return;
+  }
+
+  // Grad mirrors the data layout, so it spans every offset the strides reach
+  int64_t minOffset = 0;
+  int64_t maxOffset = 0;
+  for (int i = 0; i < ndim && size > 0; i++) {
+    int64_t extent = (shape[i] - 1) * strides[i];
+    if (extent < 0)
+      minOffset += extent;
+    else
+      maxOffset += extent;
+  }
+
+  int64_t gradSize = size > 0 ? maxOffset - minOffset + 1 : 0;
+  T *gradBuffer = new T[gradSize]();
+  uint64_t token = MemoryTracker::allocate(inputOp, inputLabel, shape, 0,
+                                           gradSize * sizeof(T));
+  gradOwner = std::shared_ptr<void>(gradBuffer, _trackedDeleter<T>(token));
+  grad = gradBuffer - minOffset;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::makeView(Shape newShape, Shape newStrides,
+                                          int64_t offset,
+                                          std::string viewOp) {
+  // Writes through a view would bypass copy-on-write
+  ensureUnique();
+
+  BasicNDArray result(newShape, newStrides, data + offset, false, "", viewOp,
+                      {std::ref(*this)}, grad + offset);
+  result.dataOwner = dataOwner;
+  result.gradOwner = gradOwner;
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::fromBuffer(T *inputData, Shape inputShape,
+                                            std::function<void(T *)> deleter) {
+  return fromBuffer(inputData, inputShape,
+                    detail::_computeStrides(inputShape), deleter);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::fromBuffer(T *inputData, Shape inputShape,
+                                            Shape inputStrides,
+                                            std::function<void(T *)> deleter) {
+  if (inputShape.size() != inputStrides.size()) {
+    throw std::invalid_argument("Expected " +
+                                std::to_string(inputShape.size()) +
+                                " strides, got " +
+                                std::to_string(inputStrides.size()));
+  }
+
+  int64_t elements = 1;
+  for (int i = 0; i < inputShape.size(); i++) {
+    if (inputShape[i] < 0) {
+      throw std::invalid_argument("Shape dimensions must be non-negative.");
+    }
+    elements *= inputShape[i];
+  }
+
+  if (inputData == nullptr && elements > 0) {
+    throw std::invalid_argument("Cannot wrap a null buffer.");
   }
 
-  ndim = shape.size();
+  BasicNDArray result(inputShape, inputStrides, inputData, false);
 
-  // Initialize grad and default backward
-  grad = new float[size]();
-  _backward = []() {};
+  if (deleter) {
+    // Adopted: released through the producer's deleter with the last user
+    result.dataOwner = std::shared_ptr<void>(
+        inputData, [deleter](void *ptr) { deleter(static_cast<T *>(ptr)); });
+    result.ownsData = result.isContiguous();
+  }
+
+  return result;
 }
 
-void NDArray::metadata(bool shapeInfo, bool stridesInfo, bool ndimInfo,
-                       bool sizeInfo, bool ownsDataInfo) {
+template <typename T>
+void BasicNDArray<T>::metadata(bool shapeInfo, bool stridesInfo,
+                               bool ndimInfo, bool sizeInfo,
+                               bool ownsDataInfo) {
   // Printing the shape
   if (shapeInfo) {
     std::cout << "Shape of the array: (";
@@ -105,7 +1773,8 @@ void NDArray::metadata(bool shapeInfo, bool stridesInfo, bool ndimInfo,
   }
 }
 
-float NDArray::get(std::vector<int> indices, NDArray::PrintType type) const {
+template <typename T>
+T BasicNDArray<T>::get(const Shape &indices, PrintType type) const {
   // Check for size of input indices == ndim
   if (indices.size() != ndim) {
     throw std::invalid_argument("Expected " + std::to_string(ndim) +
@@ -113,15 +1782,16 @@ float NDArray::get(std::vector<int> indices, NDArray::PrintType type) const {
                                 std::to_string(indices.size()));
   }
 
-  int offset = 0;
+  int64_t offset = 0;
   for (int i = 0; i < ndim; i++) {
     offset += indices[i] * strides[i];
   }
 
-  return type == NDArray::PrintType::Data ? data[offset] : grad[offset];
+  return type == PrintType::Data ? data[offset] : grad[offset];
 }
 
-float NDArray::get(int index, NDArray::PrintType type) const {
+template <typename T>
+T BasicNDArray<T>::get(int64_t index, PrintType type) const {
   // Check for out of bound index
   if (index < 0 || index >= size) {
     throw std::out_of_range("Flat index out of bounds.");
@@ -132,10 +1802,11 @@ float NDArray::get(int index, NDArray::PrintType type) const {
     throw std::runtime_error("Flat indexing only valid on base arrays.");
   }
 
-  return type == NDArray::PrintType::Data ? data[index] : grad[index];
+  return type == PrintType::Data ? data[index] : grad[index];
 }
 
-void NDArray::set(std::vector<int> indices, float value) {
+template <typename T>
+void BasicNDArray<T>::set(const Shape &indices, T value) {
   // Check for size of input indices == ndim
   if (indices.size() != ndim) {
     throw std::invalid_argument("Expected " + std::to_string(ndim) +
@@ -143,15 +1814,17 @@ void NDArray::set(std::vector<int> indices, float value) {
                                 std::to_string(indices.size()));
   }
 
-  int offset = 0;
+  int64_t offset = 0;
   for (int i = 0; i < ndim; i++) {
     offset += indices[i] * strides[i];
   }
 
+  ensureUnique();
   data[offset] = value;
 }
 
-void NDArray::set(int index, float value) {
+template <typename T>
+void BasicNDArray<T>::set(int64_t index, T value) {
   // Check for out of bound index
   if (index < 0 || index >= size) {
     throw std::out_of_range("Flat index out of bounds.");
@@ -162,89 +1835,217 @@ void NDArray::set(int index, float value) {
     throw std::runtime_error("Flat indexing only valid on base arrays.");
   }
 
+  ensureUnique();
   data[index] = value;
 }
 
-NDArray NDArray::slice(std::vector<std::tuple<int, int>> slices) {
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::slice(std::vector<std::tuple<int64_t, int64_t>> slices) {
+  std::vector<std::tuple<int64_t, int64_t, int64_t>> stepped;
+  for (int i = 0; i < slices.size(); i++) {
+    stepped.push_back({std::get<0>(slices[i]), std::get<1>(slices[i]), 1});
+  }
+  return slice(stepped);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::slice(
+    std::vector<std::tuple<int64_t, int64_t, int64_t>> slices) {
   if (slices.size() != ndim) {
     throw std::invalid_argument("Expected " + std::to_string(ndim) +
                                 " slices, got " +
                                 std::to_string(slices.size()));
   }
 
-  int offset = 0;
+  int64_t offset = 0;
+  Shape newShape;
+  Shape newStrides;
+  for (int i = 0; i < ndim; i++) {
+    auto [start, stop, step] = slices[i];
+    if (step == 0) {
+      throw std::invalid_argument("Slice step cannot be zero.");
+    }
+
+    int64_t length = step > 0 ? (stop - start + step - 1) / step
+                              : (start - stop - step - 1) / -step;
+    length = std::max<int64_t>(length, 0);
+
+    if (length > 0) {
+      int64_t last = start + (length - 1) * step;
+      if (start < 0 || start >= shape[i] || last < 0 || last >= shape[i]) {
+        throw std::invalid_argument("Slice out of bounds on axis " +
+                                    std::to_string(i) + ".");
+      }
+      offset += start * strides[i];
+    }
+
+    newShape.push_back(length);
+    newStrides.push_back(strides[i] * step);
+  }
+
+  return makeView(newShape, newStrides, offset, "slice");
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::transpose(int axis0, int axis1) {
+  if (ndim < 2) {
+    throw std::invalid_argument("transpose needs at least 2 dimensions.");
+  }
+
+  Shape axes;
   for (int i = 0; i < ndim; i++) {
-    offset += std::get<0>(slices[i]) * strides[i];
+    axes.push_back(i);
   }
 
-  std::vector<int> newShape;
-  for (int i = 0; i < slices.size(); i++) {
-    newShape.push_back(std::get<1>(slices[i]) - std::get<0>(slices[i]));
+  int a = axis0 < 0 ? axis0 + ndim : axis0;
+  int b = axis1 < 0 ? axis1 + ndim : axis1;
+  if (a < 0 || a >= ndim || b < 0 || b >= ndim) {
+    throw std::invalid_argument("Axis out of range in transpose");
   }
 
-  // Detached non-owning view: no autograd graph capture
-  NDArray result(newShape, strides, data + offset, false);
+  std::swap(axes[a], axes[b]);
+  BasicNDArray result = permute(axes);
+  result.op = "transpose";
   return result;
 }
 
-bool NDArray::isContiguous() const {
-  std::vector<int> computedStrides = detail::_computeStrides(shape);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::permute(Shape axes) {
+  if (axes.size() != ndim) {
+    throw std::invalid_argument("Expected " + std::to_string(ndim) +
+                                " axes, got " + std::to_string(axes.size()));
+  }
 
-  if (computedStrides == strides)
-    return true;
-  else
-    return false;
+  SmallVector<bool, kMaxDims> seen(ndim, false);
+  Shape newShape;
+  Shape newStrides;
+  for (int i = 0; i < ndim; i++) {
+    int axis = axes[i] < 0 ? axes[i] + ndim : axes[i];
+    if (axis < 0 || axis >= ndim || seen[axis]) {
+      throw std::invalid_argument("permute expects a permutation of the axes.");
+    }
+    seen[axis] = true;
+    newShape.push_back(shape[axis]);
+    newStrides.push_back(strides[axis]);
+  }
+
+  return makeView(newShape, newStrides, 0, "permute");
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::expand(Shape newShape) {
+  if (newShape.size() < ndim ||
+      detail::_broadcastShape(shape, newShape) != newShape) {
+    throw std::invalid_argument("Cannot expand array to the requested shape.");
+  }
+
+  Shape newStrides =
+      detail::_broadcastStrides(shape, strides, newShape);
+  return makeView(newShape, newStrides, 0, "expand");
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::squeeze() {
+  Shape newShape;
+  Shape newStrides;
+  for (int i = 0; i < ndim; i++) {
+    if (shape[i] != 1) {
+      newShape.push_back(shape[i]);
+      newStrides.push_back(strides[i]);
+    }
+  }
+
+  // Arrays are at least 1D
+  if (newShape.empty()) {
+    newShape.push_back(1);
+    newStrides.push_back(1);
+  }
+
+  return makeView(newShape, newStrides, 0, "squeeze");
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::squeeze(int axis) {
+  int ax = axis < 0 ? axis + ndim : axis;
+  if (ax < 0 || ax >= ndim || shape[ax] != 1) {
+    throw std::invalid_argument("squeeze expects an axis of size 1.");
+  }
+
+  Shape newShape = shape;
+  Shape newStrides = strides;
+  if (ndim > 1) {
+    newShape.erase(newShape.begin() + ax);
+    newStrides.erase(newStrides.begin() + ax);
+  }
+
+  return makeView(newShape, newStrides, 0, "squeeze");
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::unsqueeze(int axis) {
+  int ax = axis < 0 ? axis + ndim + 1 : axis;
+  if (ax < 0 || ax > ndim) {
+    throw std::invalid_argument("Axis out of range in unsqueeze");
+  }
+
+  // Any stride works for a size-1 axis; keep the layout contiguous-looking
+  int64_t stride = ax < ndim ? shape[ax] * strides[ax] : 1;
+  Shape newShape = shape;
+  Shape newStrides = strides;
+  newShape.insert(newShape.begin() + ax, 1);
+  newStrides.insert(newStrides.begin() + ax, stride);
+
+  return makeView(newShape, newStrides, 0, "unsqueeze");
 }
 
-void NDArray::print(NDArray::PrintType type) {
+template <typename T>
+bool BasicNDArray<T>::isContiguous() const {
+  return detail::_isRowMajor(shape, strides);
+}
+
+template <typename T>
+void BasicNDArray<T>::print(PrintType type) {
   if (ndim == 1) {
     std::cout << "[";
-    for (int i = 0; i < size - 1; i++) {
-      if (type == NDArray::PrintType::Data) {
-        std::cout << data[i] << ", ";
-      } else {
-        std::cout << grad[i] << ", ";
-      }
+    for (int64_t i = 0; i < size - 1; i++) {
+      std::cout << get(Shape{i}, type) << ", ";
     }
-    if (type == NDArray::PrintType::Data)
-      std::cout << data[size - 1] << "]" << std::endl;
-    else
-      std::cout << grad[size - 1] << "]" << std::endl;
+    std::cout << get(Shape{size - 1}, type) << "]" << std::endl;
   } else if (ndim == 2) {
-    for (int i = 0; i < shape[0]; i++) {
+    for (int64_t i = 0; i < shape[0]; i++) {
       std::cout << "[";
-      for (int j = 0; j < shape[1] - 1; j++) {
+      for (int64_t j = 0; j < shape[1] - 1; j++) {
         std::cout << get({i, j}, type) << ", ";
       }
       std::cout << get({i, shape[1] - 1}, type) << "]" << std::endl;
     }
   } else {
+    // Flattened in logical (row-major) order, also for views
     std::cout << "[";
-    for (int i = 0; i < size - 1; i++) {
-      if (type == NDArray::PrintType::Data)
-        std::cout << data[i] << ", ";
-      else
-        std::cout << grad[i] << ", ";
-    }
-    if (type == NDArray::PrintType::Data)
-      std::cout << data[size - 1] << "]" << std::endl;
-    else
-      std::cout << grad[size - 1] << "]" << std::endl;
-  }
-}
+    Shape index(shape.size(), 0);
+    for (int64_t i = 0; i < size; i++) {
+      std::cout << get(index, type) << (i < size - 1 ? ", " : "]");
 
-void NDArray::reshape(std::vector<int> newShape) {
-  if (!isContiguous() || !ownsData) {
-    throw std::runtime_error(
-        "Reshaping is only allowed on contiguous and self-owned data.");
+      for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
+        index[dim]++;
+        if (index[dim] < shape[dim])
+          break;
+        index[dim] = 0;
+      }
+    }
+    std::cout << std::endl;
   }
+}
 
+template <typename T>
+void BasicNDArray<T>::reshape(Shape newShape) {
   if (newShape.size() == 0) {
     throw std::invalid_argument(
         "The new shape should have al least one dimension, got 0.");
   }
 
-  int newSize = 1;
+  int64_t newSize = 1;
   for (int i = 0; i < newShape.size(); i++) {
     newSize *= newShape[i];
   }
@@ -253,71 +2054,100 @@ void NDArray::reshape(std::vector<int> newShape) {
     throw std::invalid_argument("New shape not compatible with the old shape.");
   }
 
-  strides = detail::_computeStrides(newShape);
+  Shape newStrides;
+  if (isContiguous()) {
+    newStrides = detail::_computeStrides(newShape);
+  } else if (!detail::_reshapeStrides(shape, strides, newShape, newStrides)) {
+    throw std::runtime_error("Cannot reshape this view without copying; "
+                             "clone() it first.");
+  }
+
+  strides = newStrides;
   shape = newShape;
+  ndim = shape.size();
 }
 
-void NDArray::fillSequential() {
+template <typename T>
+void BasicNDArray<T>::fillSequential() {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
 
-  for (int i = 0; i < size; i++) {
-    data[i] = i;
+  ensureUnique();
+  for (int64_t i = 0; i < size; i++) {
+    data[i] = static_cast<T>(i);
   }
 }
 
-void NDArray::fill(float value) {
+template <typename T>
+void BasicNDArray<T>::fill(T value) {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
 
-  for (int i = 0; i < size; i++) {
+  ensureUnique();
+  for (int64_t i = 0; i < size; i++) {
     data[i] = value;
   }
 }
 
-void NDArray::zeros() {
+template <typename T>
+void BasicNDArray<T>::zeros() {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
-  fill(0.0);
+  fill(T(0));
 }
 
-void NDArray::ones() {
+template <typename T>
+void BasicNDArray<T>::ones() {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
-  fill(1.0);
+  fill(T(1));
 }
 
-void NDArray::randint(int low, int high) {
+template <typename T>
+void BasicNDArray<T>::randint(int low, int high, Generator &generator) {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
-
-  std::mt19937 engine(std::random_device{}());
-  std::uniform_int_distribution<int> dist(low, high - 1);
-
-  for (int i = 0; i < size; i++) {
-    data[i] = static_cast<float>(dist(engine));
+  if (!(low < high)) {
+    throw std::invalid_argument(
+        "Invalid range: low >= high for randint(low, high)");
   }
+
+  ensureUnique();
+  uint64_t range = static_cast<uint64_t>(int64_t(high) - low);
+  _fillRandom(data, size, 1, generator,
+              [low, range](const uint32_t *bits, T *out, int count) {
+                for (int i = 0; i < count; ++i)
+                  out[i] = static_cast<T>(low + _boundedWord(bits[i], range));
+              });
 }
 
-void NDArray::rand() {
+template <typename T>
+void BasicNDArray<T>::rand(Generator &generator) {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
 
-  std::mt19937 engine(std::random_device{}());
-  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-  for (int i = 0; i < size; i++) {
-    data[i] = dist(engine);
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "rand() requires a floating point element type; use randint().");
+  } else {
+    ensureUnique();
+    constexpr int words = _wordsPerValue<T>;
+    _fillRandom(data, size, words, generator,
+                [](const uint32_t *bits, T *out, int count) {
+                  for (int i = 0; i < count; ++i)
+                    out[i] = _uniform01<T>(bits + i * words);
+                });
   }
 }
 
-void NDArray::rand(float low, float high) {
+template <typename T>
+void BasicNDArray<T>::rand(T low, T high, Generator &generator) {
   if (!ownsData) {
     throw std::runtime_error("Cannot fill a view or non-owning array.");
   }
@@ -326,23 +2156,132 @@ void NDArray::rand(float low, float high) {
         "Invalid range: low >= high for rand(low, high)");
   }
 
-  std::mt19937 engine(std::random_device{}());
-  std::uniform_real_distribution<float> dist(low, high);
+  ensureUnique();
+  constexpr int words = _wordsPerValue<T>;
+  if constexpr (std::is_floating_point_v<T>) {
+    // Rounding of low + u * (high - low) may reach high; keep it exclusive
+    T span = high - low;
+    T below = std::nextafter(high, low);
+    _fillRandom(data, size, words, generator,
+                [low, span, below](const uint32_t *bits, T *out, int count) {
+                  for (int i = 0; i < count; ++i) {
+                    T value = low + _uniform01<T>(bits + i * words) * span;
+                    out[i] = std::min(value, below);
+                  }
+                });
+  } else {
+    uint64_t range = static_cast<uint64_t>(high) - static_cast<uint64_t>(low);
+    _fillRandom(data, size, words, generator,
+                [low, range](const uint32_t *bits, T *out, int count) {
+                  for (int i = 0; i < count; ++i) {
+                    uint64_t offset;
+                    if constexpr (words == 1)
+                      offset = _boundedWord(bits[i], range);
+                    else
+                      offset = _word64(bits + i * words) % range;
+                    out[i] = static_cast<T>(static_cast<uint64_t>(low) +
+                                            offset);
+                  }
+                });
+  }
+}
+
+template <typename T>
+void BasicNDArray<T>::randn(T mean, T stddev, Generator &generator) {
+  if (!ownsData) {
+    throw std::runtime_error("Cannot fill a view or non-owning array.");
+  }
+
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "randn() requires a floating point element type.");
+  } else {
+    if (!(stddev >= T(0))) {
+      throw std::invalid_argument("randn expects a non-negative stddev.");
+    }
+
+    ensureUnique();
+    constexpr int words = _wordsPerValue<T>;
+    _fillRandom(data, size, words, generator,
+                [mean, stddev](const uint32_t *bits, T *out, int count) {
+                  // Box-Muller: each pair of uniforms gives two normals
+                  const T twoPi = T(6.283185307179586);
+                  for (int i = 0; i < count; i += 2) {
+                    T u1 = T(1) - _uniform01<T>(bits + i * words);
+                    T u2 = _uniform01<T>(bits + (i + 1) * words);
+                    T radius = std::sqrt(T(-2) * std::log(u1));
+                    out[i] = mean + stddev * radius * std::cos(twoPi * u2);
+                    if (i + 1 < count)
+                      out[i + 1] =
+                          mean + stddev * radius * std::sin(twoPi * u2);
+                  }
+                });
+  }
+}
+
+template <typename T>
+void BasicNDArray<T>::bernoulli(double p, Generator &generator) {
+  if (!ownsData) {
+    throw std::runtime_error("Cannot fill a view or non-owning array.");
+  }
+  if (!(p >= 0.0 && p <= 1.0)) {
+    throw std::invalid_argument("bernoulli expects p in [0, 1].");
+  }
+
+  ensureUnique();
+  uint64_t threshold = _wordThreshold(p);
+  _fillRandom(data, size, 1, generator,
+              [threshold](const uint32_t *bits, T *out, int count) {
+                for (int i = 0; i < count; ++i)
+                  out[i] = bits[i] < threshold ? T(1) : T(0);
+              });
+}
+
+template <typename T>
+void BasicNDArray<T>::dropoutMask(double p, Generator &generator) {
+  if (!ownsData) {
+    throw std::runtime_error("Cannot fill a view or non-owning array.");
+  }
+
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "dropoutMask() requires a floating point element type.");
+  } else {
+    if (!(p >= 0.0 && p < 1.0)) {
+      throw std::invalid_argument("dropoutMask expects p in [0, 1).");
+    }
 
-  for (int i = 0; i < size; i++) {
-    data[i] = dist(engine);
+    ensureUnique();
+    uint64_t threshold = _wordThreshold(p);
+    T scale = static_cast<T>(1.0 / (1.0 - p));
+    _fillRandom(data, size, 1, generator,
+                [threshold, scale](const uint32_t *bits, T *out, int count) {
+                  for (int i = 0; i < count; ++i)
+                    out[i] = bits[i] < threshold ? T(0) : scale;
+                });
   }
 }
 
-NDArray NDArray::clone() {
-  NDArray result(shape);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::clone() {
+  // Share the buffer when every other holder is a copy-on-write clone (no
+  // views could observe or bypass a lazy copy)
+  if (isContiguous() && dataOwner && (copyOnWrite || dataUnshared())) {
+    BasicNDArray result(shape, strides, data, true);
+    result.dataOwner = dataOwner;
+    result.copyOnWrite = true;
+    copyOnWrite = true;
+    return result;
+  }
+
+  BasicNDArray result(shape);
 
   if (isContiguous()) {
     std::copy(data, data + size, result.data);
   } else {
-    std::vector<int> index(shape.size(), 0);
-    for (int i = 0; i < result.size; ++i) {
-      int offset = detail::_computeOffset(index, strides);
+    Shape index(shape.size(), 0);
+    for (int64_t i = 0; i < result.size; ++i) {
+      int64_t offset = detail::_computeOffset(index, strides);
       result.data[i] = data[offset];
 
       for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
@@ -357,19 +2296,45 @@ NDArray NDArray::clone() {
   return result;
 }
 
-NDArray NDArray::operator+(NDArray &other) {
-  std::vector<int> outShape = detail::_broadcastShape(shape, other.shape);
-  std::vector<int> stridesA =
+template <typename T>
+bool BasicNDArray<T>::dataUnshared() const {
+  return dataOwner.use_count() == (gradOwner == dataOwner ? 2 : 1);
+}
+
+template <typename T>
+void BasicNDArray<T>::ensureUnique() {
+  if (!copyOnWrite)
+    return;
+
+  copyOnWrite = false;
+  if (dataUnshared())
+    return;
+
+  // Still shared: copy (copy-on-write arrays are contiguous)
+  T *copy = new T[size];
+  std::copy(data, data + size, copy);
+  retiredData.push_back(dataOwner);
+  uint64_t token = MemoryTracker::allocate(
+      op, label, shape, size * static_cast<int64_t>(sizeof(T)), 0);
+  dataOwner = std::shared_ptr<void>(copy, _trackedDeleter<T>(token));
+  data = copy;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator+(BasicNDArray &other) {
+  int64_t profileStart = _profileStart();
+  Shape outShape = detail::_broadcastShape(shape, other.shape);
+  Shape stridesA =
       detail::_broadcastStrides(shape, strides, outShape);
-  std::vector<int> stridesB =
+  Shape stridesB =
       detail::_broadcastStrides(other.shape, other.strides, outShape);
 
-  NDArray result(outShape, "", "+", {std::ref(*this), std::ref(other)});
-  std::vector<int> index(outShape.size(), 0);
+  BasicNDArray result(outShape, "", "+", {std::ref(*this), std::ref(other)});
+  Shape index(outShape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offsetA = detail::_computeOffset(index, stridesA);
-    int offsetB = detail::_computeOffset(index, stridesB);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offsetA = detail::_computeOffset(index, stridesA);
+    int64_t offsetB = detail::_computeOffset(index, stridesB);
     result.data[i] = this->data[offsetA] + other.data[offsetB];
 
     // Increment multi-dimensional index
@@ -383,21 +2348,21 @@ NDArray NDArray::operator+(NDArray &other) {
 
   // Backward pass: dL/dA += 1 * dL/dOut (with broadcasting reduction)
   //                dL/dB += 1 * dL/dOut
-  float *aGradPtr = this->grad;
-  float *bGradPtr = other.grad;
-  float *outGradPtr = result.grad;
-  int outSize = result.size;
-  std::vector<int> outShapeCopy = outShape;
-  std::vector<int> stridesACopy = stridesA;
-  std::vector<int> stridesBCopy = stridesB;
+  T *aGradPtr = this->grad;
+  T *bGradPtr = other.grad;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  Shape outShapeCopy = outShape;
+  Shape stridesACopy = stridesA;
+  Shape stridesBCopy = stridesB;
 
   result._backward = [aGradPtr, bGradPtr, outGradPtr, outSize, outShapeCopy,
                       stridesACopy, stridesBCopy]() mutable {
-    std::vector<int> idx(outShapeCopy.size(), 0);
-    for (int i = 0; i < outSize; ++i) {
-      int offA = detail::_computeOffset(idx, stridesACopy);
-      int offB = detail::_computeOffset(idx, stridesBCopy);
-      float upstream = outGradPtr[i];
+    Shape idx(outShapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t offA = detail::_computeOffset(idx, stridesACopy);
+      int64_t offB = detail::_computeOffset(idx, stridesBCopy);
+      T upstream = outGradPtr[i];
       aGradPtr[offA] += upstream;
       bGradPtr[offB] += upstream;
 
@@ -410,15 +2375,24 @@ NDArray NDArray::operator+(NDArray &other) {
     }
   };
 
+  result.backwardCost = _cost<T>(2 * result.size,
+                                 result.size + size + other.size,
+                                 size + other.size);
+  _profileOp(result, profileStart,
+             _cost<T>(result.size, size + other.size, result.size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::operator+(float value) {
-  NDArray result(shape, "", "+", {std::ref(*this)});
-  std::vector<int> index(shape.size(), 0);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator+(T value) {
+  int64_t profileStart = _profileStart();
+  BasicNDArray result(shape, "", "+", {std::ref(*this)});
+  Shape index(shape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offset = detail::_computeOffset(index, strides);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offset = detail::_computeOffset(index, strides);
     result.data[i] = data[offset] + value;
 
     for (int dim = shape.size() - 1; dim >= 0; --dim) {
@@ -430,31 +2404,49 @@ NDArray NDArray::operator+(float value) {
   }
 
   // Backward: dA += 1 * dOut
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  int outSize = result.size;
-  result._backward = [aGradPtr, outGradPtr, outSize]() mutable {
-    for (int i = 0; i < outSize; ++i) {
-      aGradPtr[i] += outGradPtr[i];
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  result._backward = [aGradPtr, outGradPtr, outSize, shapeCopy,
+                      stridesCopy]() mutable {
+    Shape idx(shapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t off = detail::_computeOffset(idx, stridesCopy);
+      aGradPtr[off] += outGradPtr[i];
+
+      for (int d = static_cast<int>(shapeCopy.size()) - 1; d >= 0; --d) {
+        idx[d]++;
+        if (idx[d] < shapeCopy[d])
+          break;
+        idx[d] = 0;
+      }
     }
   };
 
+  result.backwardCost = _cost<T>(size, 2 * size, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::operator-(NDArray &other) {
-  std::vector<int> outShape = detail::_broadcastShape(shape, other.shape);
-  std::vector<int> stridesA =
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator-(BasicNDArray &other) {
+  int64_t profileStart = _profileStart();
+  Shape outShape = detail::_broadcastShape(shape, other.shape);
+  Shape stridesA =
       detail::_broadcastStrides(shape, strides, outShape);
-  std::vector<int> stridesB =
+  Shape stridesB =
       detail::_broadcastStrides(other.shape, other.strides, outShape);
 
-  NDArray result(outShape, "", "-", {std::ref(*this), std::ref(other)});
-  std::vector<int> index(outShape.size(), 0);
+  BasicNDArray result(outShape, "", "-", {std::ref(*this), std::ref(other)});
+  Shape index(outShape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offsetA = detail::_computeOffset(index, stridesA);
-    int offsetB = detail::_computeOffset(index, stridesB);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offsetA = detail::_computeOffset(index, stridesA);
+    int64_t offsetB = detail::_computeOffset(index, stridesB);
     result.data[i] = this->data[offsetA] - other.data[offsetB];
 
     for (int dim = outShape.size() - 1; dim >= 0; --dim) {
@@ -467,21 +2459,21 @@ NDArray NDArray::operator-(NDArray &other) {
 
   // Backward pass: dL/dA += 1 * dL/dOut (with broadcasting reduction)
   //                dL/dB += -1 * dL/dOut
-  float *aGradPtr = this->grad;
-  float *bGradPtr = other.grad;
-  float *outGradPtr = result.grad;
-  int outSize = result.size;
-  std::vector<int> outShapeCopy = outShape;
-  std::vector<int> stridesACopy = stridesA;
-  std::vector<int> stridesBCopy = stridesB;
+  T *aGradPtr = this->grad;
+  T *bGradPtr = other.grad;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  Shape outShapeCopy = outShape;
+  Shape stridesACopy = stridesA;
+  Shape stridesBCopy = stridesB;
 
   result._backward = [aGradPtr, bGradPtr, outGradPtr, outSize, outShapeCopy,
                       stridesACopy, stridesBCopy]() mutable {
-    std::vector<int> idx(outShapeCopy.size(), 0);
-    for (int i = 0; i < outSize; ++i) {
-      int offA = detail::_computeOffset(idx, stridesACopy);
-      int offB = detail::_computeOffset(idx, stridesBCopy);
-      float upstream = outGradPtr[i];
+    Shape idx(outShapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t offA = detail::_computeOffset(idx, stridesACopy);
+      int64_t offB = detail::_computeOffset(idx, stridesBCopy);
+      T upstream = outGradPtr[i];
       aGradPtr[offA] += upstream;
       bGradPtr[offB] -= upstream;
 
@@ -494,15 +2486,24 @@ NDArray NDArray::operator-(NDArray &other) {
     }
   };
 
+  result.backwardCost = _cost<T>(2 * result.size,
+                                 result.size + size + other.size,
+                                 size + other.size);
+  _profileOp(result, profileStart,
+             _cost<T>(result.size, size + other.size, result.size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::operator-(float value) {
-  NDArray result(shape, "", "-", {std::ref(*this)});
-  std::vector<int> index(shape.size(), 0);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator-(T value) {
+  int64_t profileStart = _profileStart();
+  BasicNDArray result(shape, "", "-", {std::ref(*this)});
+  Shape index(shape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offset = detail::_computeOffset(index, strides);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offset = detail::_computeOffset(index, strides);
     result.data[i] = data[offset] - value;
 
     for (int dim = shape.size() - 1; dim >= 0; --dim) {
@@ -514,19 +2515,37 @@ NDArray NDArray::operator-(float value) {
   }
 
   // Backward: dA += 1 * dOut (constant has no grad)
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  int outSize = result.size;
-  result._backward = [aGradPtr, outGradPtr, outSize]() mutable {
-    for (int i = 0; i < outSize; ++i) {
-      aGradPtr[i] += outGradPtr[i];
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  result._backward = [aGradPtr, outGradPtr, outSize, shapeCopy,
+                      stridesCopy]() mutable {
+    Shape idx(shapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t off = detail::_computeOffset(idx, stridesCopy);
+      aGradPtr[off] += outGradPtr[i];
+
+      for (int d = static_cast<int>(shapeCopy.size()) - 1; d >= 0; --d) {
+        idx[d]++;
+        if (idx[d] < shapeCopy[d])
+          break;
+        idx[d] = 0;
+      }
     }
   };
 
+  result.backwardCost = _cost<T>(size, 2 * size, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::operator*(NDArray &other) {
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator*(BasicNDArray &other) {
+  int64_t profileStart = _profileStart();
   if (this->ndim != 2 || other.ndim != 2) {
     throw std::invalid_argument(
         "Matrix multiplication is only supported for 2d arrays! Exiting.");
@@ -542,90 +2561,1063 @@ NDArray NDArray::operator*(NDArray &other) {
         std::to_string(other.shape[0]) + " for second matrix. Exiting.");
   }
 
-  NDArray result({this->shape[0], other.shape[1]}, "", "*",
-                 {std::ref(*this), std::ref(other)});
+  BasicNDArray result({this->shape[0], other.shape[1]}, "", "*",
+                      {std::ref(*this), std::ref(other)});
+
+  int64_t m = this->shape[0];
+  int64_t k = this->shape[1];
+  int64_t n = other.shape[1];
+
+  // Operands are read through their strides: transposed or sliced inputs
+  // need no contiguous copy
+  _gemm(m, n, k, this->data, this->strides[0], this->strides[1], other.data,
+        other.strides[0], other.strides[1], result.data, n, 1, false);
+
+  // Backward pass for matrix multiplication:
+  // If C = A * B, then
+  // dA += dC * B^T and dB += A^T * dC
+  // The transposes are expressed by swapping strides; the gradients are
+  // written with the operands' own strides (grad mirrors the data layout).
+  T *aGradPtr = this->grad;
+  T *bGradPtr = other.grad;
+  T *outGradPtr = result.grad;
+  T *aDataPtr = this->data;
+  T *bDataPtr = other.data;
+  int64_t aRs = this->strides[0];
+  int64_t aCs = this->strides[1];
+  int64_t bRs = other.strides[0];
+  int64_t bCs = other.strides[1];
+
+  result._backward = [m, k, n, aGradPtr, bGradPtr, outGradPtr, aDataPtr,
+                      bDataPtr, aRs, aCs, bRs, bCs]() mutable {
+    // dA (m x k) += dC (m x n) * B^T (n x k)
+    _gemm(m, k, n, outGradPtr, n, 1, bDataPtr, bCs, bRs, aGradPtr, aRs, aCs,
+          true);
+
+    // dB (k x n) += A^T (k x m) * dC (m x n)
+    _gemm(k, n, m, aDataPtr, aCs, aRs, outGradPtr, n, 1, bGradPtr, bRs, bCs,
+          true);
+  };
+
+  result.backwardCost = _cost<T>(4 * m * n * k, 2 * (m * n + k * n + m * k),
+                                 m * k + k * n);
+  _profileOp(result, profileStart,
+             _cost<T>(2 * m * n * k, m * k + k * n, m * n),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::linear(BasicNDArray &weight,
+                                        BasicNDArray &bias,
+                                        Activation activation) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    if (activation == Activation::None)
+      return fusedLinear<Activation::None>(weight, bias);
+    if (activation == Activation::ReLU)
+      return fusedLinear<Activation::ReLU>(weight, bias);
+    throw std::runtime_error(
+        "linear() supports only None and ReLU on integer arrays.");
+  } else {
+    switch (activation) {
+    case Activation::ReLU:
+      return fusedLinear<Activation::ReLU>(weight, bias);
+    case Activation::GELU:
+      return fusedLinear<Activation::GELU>(weight, bias);
+    case Activation::Tanh:
+      return fusedLinear<Activation::Tanh>(weight, bias);
+    case Activation::Sigmoid:
+      return fusedLinear<Activation::Sigmoid>(weight, bias);
+    default:
+      return fusedLinear<Activation::None>(weight, bias);
+    }
+  }
+}
+
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::einsum(const std::string &equation,
+                        std::vector<std::reference_wrapper<BasicNDArray>>
+                            operands) {
+  int64_t profileStart = _profileStart();
+  if (operands.empty()) {
+    throw std::invalid_argument("einsum() requires at least one operand.");
+  }
+  std::vector<Shape> shapes;
+  for (const BasicNDArray &operand : operands)
+    shapes.push_back(operand.shape);
+  EinsumEquation parsed = _parseEinsum(equation, shapes);
+
+  Shape outShape;
+  for (int label : parsed.output)
+    outShape.push_back(parsed.sizes[label]);
+  if (outShape.empty())
+    outShape.push_back(1);
+  BasicNDArray result(outShape, "", "einsum", operands);
+
+  std::vector<const T *> dataPtrs;
+  std::vector<T *> gradPtrs;
+  std::vector<Shape> operandStrides;
+  int64_t readElements = 0;
+  std::vector<EinsumTerm<T>> terms;
+  for (size_t t = 0; t < operands.size(); ++t) {
+    BasicNDArray &operand = operands[t];
+    dataPtrs.push_back(operand.data);
+    gradPtrs.push_back(operand.grad);
+    operandStrides.push_back(operand.strides);
+    readElements += operand.size;
+    terms.push_back(
+        _einsumTerm<T>(operand.data, parsed.inputs[t], operand.strides));
+  }
+
+  EinsumTarget<T> target;
+  target.data = result.data;
+  target.labels = _einsumAxes(parsed.output, result.strides, target.strides);
+  double work = _einsumRun(std::move(terms), target, parsed.sizes);
+
+  // dOperand (+)= einsum of dOut with every other operand, written into the
+  // operand's grad through its strides (diagonals included)
+  T *outGradPtr = result.grad;
+  Shape outStrides = result.strides;
+  result._backward = [parsed, dataPtrs, gradPtrs, operandStrides, outGradPtr,
+                      outStrides]() {
+    for (size_t i = 0; i < dataPtrs.size(); ++i) {
+      std::vector<EinsumTerm<T>> terms;
+      terms.push_back(_einsumTerm<T>(outGradPtr, parsed.output, outStrides));
+      for (size_t j = 0; j < dataPtrs.size(); ++j) {
+        if (j != i)
+          terms.push_back(
+              _einsumTerm<T>(dataPtrs[j], parsed.inputs[j], operandStrides[j]));
+      }
+      EinsumTarget<T> target;
+      target.data = gradPtrs[i];
+      target.labels =
+          _einsumAxes(parsed.inputs[i], operandStrides[i], target.strides);
+      target.accumulate = true;
+      _einsumRun(std::move(terms), target, parsed.sizes);
+    }
+  };
+
+  int64_t flops = static_cast<int64_t>(2 * work);
+  result.backwardCost =
+      _cost<T>(flops * static_cast<int64_t>(operands.size()),
+               readElements + result.size, readElements);
+  _profileOp(result, profileStart, _cost<T>(flops, readElements, result.size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+template <Activation A>
+BasicNDArray<T> BasicNDArray<T>::fusedLinear(BasicNDArray &weight,
+                                             BasicNDArray &bias) {
+  int64_t profileStart = _profileStart();
+  if (ndim != 2 || weight.ndim != 2) {
+    throw std::invalid_argument("linear() requires 2d input and weight.");
+  }
+  if (shape[1] != weight.shape[0]) {
+    throw std::invalid_argument(
+        "linear() requires input columns (" + std::to_string(shape[1]) +
+        ") to match weight rows (" + std::to_string(weight.shape[0]) + ").");
+  }
+
+  int64_t m = shape[0];
+  int64_t k = shape[1];
+  int64_t n = weight.shape[1];
+  bool biasRow = bias.ndim == 1 || (bias.ndim == 2 && bias.shape[0] == 1);
+  if (!biasRow || bias.size != n) {
+    throw std::invalid_argument(
+        "linear() requires a bias of shape {n} or {1, n} with n = " +
+        std::to_string(n) + ".");
+  }
+
+  BasicNDArray result({m, n}, "", "linear",
+                      {std::ref(*this), std::ref(weight), std::ref(bias)});
+
+  // Bias row made contiguous once; GELU also keeps its pre-activation
+  int64_t biasStride = bias.strides[bias.ndim - 1];
+  std::vector<T> biasValues(n);
+  for (int64_t j = 0; j < n; ++j)
+    biasValues[j] = bias.data[j * biasStride];
+  std::shared_ptr<std::vector<T>> preActivation;
+  if constexpr (A == Activation::GELU)
+    preActivation = std::make_shared<std::vector<T>>(m * n);
+
+  const T *biasPtr = biasValues.data();
+  T *zPtr = preActivation ? preActivation->data() : nullptr;
+  _gemm(m, n, k, data, strides[0], strides[1], weight.data,
+        weight.strides[0], weight.strides[1], result.data, n, 1, false,
+        [biasPtr, zPtr, n](int64_t row, int64_t col0, T *dst, int64_t count) {
+          const T *b = biasPtr + col0;
+          if constexpr (A == Activation::GELU) {
+            T *z = zPtr + row * n + col0;
+            for (int64_t j = 0; j < count; ++j) {
+              z[j] = dst[j] + b[j];
+              dst[j] = _activation<T, A>(z[j]);
+            }
+          } else {
+            for (int64_t j = 0; j < count; ++j)
+              dst[j] = _activation<T, A>(dst[j] + b[j]);
+          }
+        });
+
+  // Backward: dZ = dOut * act'(Z) and dBias += column sums of dZ in one
+  // pass, then dX += dZ * W^T and dW += X^T * dZ (strides as in matmul)
+  T *xDataPtr = this->data;
+  T *xGradPtr = this->grad;
+  T *wDataPtr = weight.data;
+  T *wGradPtr = weight.grad;
+  T *bGradPtr = bias.grad;
+  T *outDataPtr = result.data;
+  T *outGradPtr = result.grad;
+  int64_t xRs = strides[0];
+  int64_t xCs = strides[1];
+  int64_t wRs = weight.strides[0];
+  int64_t wCs = weight.strides[1];
+
+  result._backward = [m, k, n, xDataPtr, xGradPtr, wDataPtr, wGradPtr,
+                      bGradPtr, biasStride, outDataPtr, outGradPtr, xRs, xCs,
+                      wRs, wCs, preActivation]() {
+    std::vector<T> columnSums(n, T(0));
+    std::vector<T> dZBuffer;
+    const T *dZ = outGradPtr;
+    if constexpr (A == Activation::None) {
+      for (int64_t i = 0; i < m; ++i) {
+        const T *g = outGradPtr + i * n;
+        for (int64_t j = 0; j < n; ++j)
+          columnSums[j] += g[j];
+      }
+    } else {
+      dZBuffer.resize(m * n);
+      for (int64_t i = 0; i < m; ++i) {
+        const T *g = outGradPtr + i * n;
+        const T *y = outDataPtr + i * n;
+        const T *z = preActivation ? preActivation->data() + i * n : y;
+        T *dz = dZBuffer.data() + i * n;
+        for (int64_t j = 0; j < n; ++j) {
+          dz[j] = g[j] * _activationGrad<T, A>(z[j], y[j]);
+          columnSums[j] += dz[j];
+        }
+      }
+      dZ = dZBuffer.data();
+    }
+    for (int64_t j = 0; j < n; ++j)
+      bGradPtr[j * biasStride] += columnSums[j];
+
+    // dX (m x k) += dZ (m x n) * W^T (n x k)
+    _gemm(m, k, n, dZ, n, 1, wDataPtr, wCs, wRs, xGradPtr, xRs, xCs, true);
+
+    // dW (k x n) += X^T (k x m) * dZ (m x n)
+    _gemm(k, n, m, xDataPtr, xCs, xRs, dZ, n, 1, wGradPtr, wRs, wCs, true);
+  };
+
+  result.backwardCost =
+      _cost<T>(4 * m * n * k + 3 * m * n, 2 * (m * n + k * n + m * k),
+               m * k + k * n + n);
+  _profileOp(result, profileStart,
+             _cost<T>(2 * m * n * k + 2 * m * n, m * k + k * n + n, m * n),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::conv2d(BasicNDArray &weight,
+                                        BasicNDArray &bias, int64_t stride,
+                                        int64_t padding, int64_t dilation,
+                                        int64_t groups) {
+  return convolution("conv2d", 2, weight, &bias, stride, padding, dilation,
+                     groups);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::conv2d(BasicNDArray &weight, int64_t stride,
+                                        int64_t padding, int64_t dilation,
+                                        int64_t groups) {
+  return convolution("conv2d", 2, weight, nullptr, stride, padding, dilation,
+                     groups);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::conv1d(BasicNDArray &weight,
+                                        BasicNDArray &bias, int64_t stride,
+                                        int64_t padding, int64_t dilation,
+                                        int64_t groups) {
+  return convolution("conv1d", 1, weight, &bias, stride, padding, dilation,
+                     groups);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::conv1d(BasicNDArray &weight, int64_t stride,
+                                        int64_t padding, int64_t dilation,
+                                        int64_t groups) {
+  return convolution("conv1d", 1, weight, nullptr, stride, padding, dilation,
+                     groups);
+}
+
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::convolution(const std::string &opName, int spatialDims,
+                             BasicNDArray &weight, BasicNDArray *bias,
+                             int64_t stride, int64_t padding,
+                             int64_t dilation, int64_t groups) {
+  int64_t profileStart = _profileStart();
+  int dims = spatialDims + 2;
+  if (ndim != dims || weight.ndim != dims) {
+    throw std::invalid_argument(
+        opName + "() requires " +
+        (spatialDims == 2 ? "(N, C, H, W) input and (O, C / groups, kH, kW)"
+                          : "(N, C, L) input and (O, C / groups, k)") +
+        " weight.");
+  }
+  if (stride < 1 || dilation < 1 || groups < 1 || padding < 0) {
+    throw std::invalid_argument(
+        opName + "() requires stride, dilation and groups >= 1 and padding "
+                 ">= 0.");
+  }
+
+  // conv1d is a conv2d over a single row
+  bool twoD = spatialDims == 2;
+  ConvGeometry g;
+  g.batch = shape[0];
+  g.channels = shape[1];
+  g.height = twoD ? shape[2] : 1;
+  g.width = shape[dims - 1];
+  g.outChannels = weight.shape[0];
+  g.kernelH = twoD ? weight.shape[2] : 1;
+  g.kernelW = weight.shape[dims - 1];
+  g.strideH = twoD ? stride : 1;
+  g.strideW = stride;
+  g.padH = twoD ? padding : 0;
+  g.padW = padding;
+  g.dilationH = twoD ? dilation : 1;
+  g.dilationW = dilation;
+  g.groups = groups;
+  g.sN = strides[0];
+  g.sC = strides[1];
+  g.sH = twoD ? strides[2] : 0;
+  g.sW = strides[dims - 1];
+
+  if (g.channels % groups != 0 || g.outChannels % groups != 0) {
+    throw std::invalid_argument(
+        opName + "() requires input channels (" + std::to_string(g.channels) +
+        ") and output channels (" + std::to_string(g.outChannels) +
+        ") divisible by groups (" + std::to_string(groups) + ").");
+  }
+  if (weight.shape[1] != g.groupChannels()) {
+    throw std::invalid_argument(
+        opName + "() requires weight.shape[1] == channels / groups (" +
+        std::to_string(g.groupChannels()) + "), got " +
+        std::to_string(weight.shape[1]) + ".");
+  }
+  if (bias && (bias->ndim != 1 || bias->shape[0] != g.outChannels)) {
+    throw std::invalid_argument(opName + "() requires a bias of shape {" +
+                                std::to_string(g.outChannels) + "}.");
+  }
+  // Extent of the dilated kernel against the padded input
+  int64_t spanH = g.dilationH * (g.kernelH - 1) + 1;
+  int64_t spanW = g.dilationW * (g.kernelW - 1) + 1;
+  if (g.height + 2 * g.padH < spanH || g.width + 2 * g.padW < spanW) {
+    throw std::invalid_argument(opName +
+                                "() kernel is larger than the padded input.");
+  }
+  g.outH = (g.height + 2 * g.padH - spanH) / g.strideH + 1;
+  g.outW = (g.width + 2 * g.padW - spanW) / g.strideW + 1;
+
+  std::vector<std::reference_wrapper<BasicNDArray>> parents = {
+      std::ref(*this), std::ref(weight)};
+  if (bias)
+    parents.push_back(std::ref(*bias));
+  Shape outShape = twoD ? Shape{g.batch, g.outChannels, g.outH, g.outW}
+                        : Shape{g.batch, g.outChannels, g.outW};
+  BasicNDArray result(outShape, "", opName, parents);
+
+  // Weights packed to (O, C / groups * kH * kW) rows and the bias to a
+  // contiguous vector; both are small next to the activations
+  int64_t groupChannels = g.groupChannels();
+  int64_t groupOut = g.groupOutChannels();
+  int64_t kernel = g.kernelSize();
+  int64_t columnRows = g.columnRows();
+  int64_t pixels = g.pixels();
+  Shape weightStrides = {weight.strides[0], weight.strides[1],
+                         twoD ? weight.strides[2] : 0,
+                         weight.strides[dims - 1]};
+  auto packed = std::make_shared<std::vector<T>>(g.outChannels * columnRows);
+  for (int64_t o = 0; o < g.outChannels; ++o)
+    for (int64_t c = 0; c < groupChannels; ++c)
+      for (int64_t i = 0; i < g.kernelH; ++i)
+        for (int64_t j = 0; j < g.kernelW; ++j)
+          (*packed)[o * columnRows + c * kernel + i * g.kernelW + j] =
+              weight.data[o * weightStrides[0] + c * weightStrides[1] +
+                          i * weightStrides[2] + j * weightStrides[3]];
+  int64_t biasStride = bias ? bias->strides[0] : 0;
+  std::vector<T> biasValues(g.outChannels, T(0));
+  if (bias) {
+    for (int64_t o = 0; o < g.outChannels; ++o)
+      biasValues[o] = bias->data[o * biasStride];
+  }
+
+  // 1x1 kernels with unit stride and no padding read the input directly as
+  // the (C / groups x H * W) column matrix; depthwise convolutions use the
+  // direct kernel; everything else lowers to im2col + GEMM per image and
+  // group (parallel across them, one column buffer per thread)
+  bool pointwise = kernel == 1 && g.strideH == 1 && g.strideW == 1 &&
+                   g.padH == 0 && g.padW == 0 && g.sW == 1 &&
+                   (g.height == 1 || g.sH == g.width);
+  bool depthwise = !pointwise && groupChannels == 1 && groups > 1;
+  int64_t items = g.batch * groups;
+  int64_t flops = 2 * g.batch * g.outChannels * pixels * columnRows;
+
+  // With fewer images x groups than threads, each image is split across
+  // blocks of output channels instead (rows of C do not depend on the
+  // blocking, so neither do the results)
+  const T *w = packed->data();
+  int threads = flops >= kParallelElements ? _maxThreads() : 1;
+  if (depthwise) {
+    _depthwiseConv(data, g, w, biasValues.data(), result.data);
+  } else {
+    const T *x = data;
+    T *out = result.data;
+    const T *biasPtr = biasValues.data();
+    // out[o0:o0 + count] of one image and group from its column matrix
+    auto channels = [&](int64_t n, int64_t group, int64_t o0, int64_t count,
+                        const T *cols, int64_t colsStride) {
+      const T *channelBias = biasPtr + group * groupOut + o0;
+      _gemm(count, pixels, columnRows,
+            w + (group * groupOut + o0) * columnRows, columnRows, 1, cols,
+            colsStride, 1,
+            out + (n * g.outChannels + group * groupOut + o0) * pixels,
+            pixels, 1, false,
+            [channelBias](int64_t row, int64_t, T *dst, int64_t count) {
+              for (int64_t j = 0; j < count; ++j)
+                dst[j] += channelBias[row];
+            });
+    };
+
+    if (items >= threads) {
+#pragma omp parallel if (threads > 1)
+      {
+        std::vector<T> cols(pointwise ? 0 : columnRows * pixels);
+
+#pragma omp for schedule(static)
+        for (int64_t item = 0; item < items; ++item) {
+          int64_t n = item / groups;
+          int64_t group = item % groups;
+          const T *xg = x + n * g.sN + group * groupChannels * g.sC;
+          if (pointwise) {
+            channels(n, group, 0, groupOut, xg, g.sC);
+          } else {
+            _im2col(xg, g, 0, columnRows, cols.data());
+            channels(n, group, 0, groupOut, cols.data(), pixels);
+          }
+        }
+      }
+    } else {
+      int64_t block = (groupOut + threads - 1) / threads;
+      int64_t blocks = (groupOut + block - 1) / block;
+      std::vector<T> cols(pointwise ? 0 : columnRows * pixels);
+#pragma omp parallel
+      {
+        for (int64_t item = 0; item < items; ++item) {
+          int64_t n = item / groups;
+          int64_t group = item % groups;
+          const T *xg = x + n * g.sN + group * groupChannels * g.sC;
+          if (!pointwise) {
+#pragma omp for schedule(static)
+            for (int64_t r = 0; r < columnRows; ++r)
+              _im2col(xg, g, r, r + 1, cols.data());
+          }
+
+#pragma omp for schedule(static)
+          for (int64_t b = 0; b < blocks; ++b) {
+            int64_t o0 = b * block;
+            int64_t count = std::min(block, groupOut - o0);
+            if (pointwise)
+              channels(n, group, o0, count, xg, g.sC);
+            else
+              channels(n, group, o0, count, cols.data(), pixels);
+          }
+        }
+      }
+    }
+  }
+
+  // Backward: dBias is the sum of dOut per channel, dW += dOut * cols^T and
+  // dX += col2im(W^T * dOut). dX runs in parallel across images and groups
+  // (unless the input is a broadcast view whose elements alias); dW and
+  // dBias across blocks of output channels, so results do not depend on the
+  // thread count.
+  T *xDataPtr = this->data;
+  T *xGradPtr = this->grad;
+  T *wGradPtr = weight.grad;
+  T *bGradPtr = bias ? bias->grad : nullptr;
+  T *outGradPtr = result.grad;
+  bool aliased = false;
+  for (int d = 0; d < ndim; ++d)
+    aliased = aliased || (shape[d] > 1 && strides[d] == 0);
+
+  result._backward = [g, packed, weightStrides, biasStride, xDataPtr,
+                      xGradPtr, wGradPtr, bGradPtr, outGradPtr, pointwise,
+                      depthwise, aliased, items, threads]() {
+    int64_t groupChannels = g.groupChannels();
+    int64_t groupOut = g.groupOutChannels();
+    int64_t kernel = g.kernelSize();
+    int64_t columnRows = g.columnRows();
+    int64_t pixels = g.pixels();
+    const T *w = packed->data();
+    std::vector<T> dw(g.outChannels * columnRows, T(0));
+    std::vector<T> dBias(g.outChannels, T(0));
+
+    if (depthwise) {
+      _depthwiseConvBackward(xDataPtr, xGradPtr, g, w, outGradPtr, dw.data(),
+                             dBias.data(), !aliased);
+    } else {
+#pragma omp parallel if (items > 1 && threads > 1 && !aliased)
+      {
+        std::vector<T> dcols(pointwise ? 0 : columnRows * pixels);
+
+#pragma omp for schedule(static)
+        for (int64_t item = 0; item < items; ++item) {
+          int64_t n = item / g.groups;
+          int64_t group = item % g.groups;
+          const T *wg = w + group * groupOut * columnRows;
+          const T *gy = outGradPtr + (n * g.outChannels + group * groupOut) *
+                                         pixels;
+          T *dx = xGradPtr + n * g.sN + group * groupChannels * g.sC;
+          if (pointwise) {
+            _gemm(columnRows, pixels, groupOut, wg, 1, columnRows, gy, pixels,
+                  1, dx, g.sC, 1, true);
+          } else {
+            _gemm(columnRows, pixels, groupOut, wg, 1, columnRows, gy, pixels,
+                  1, dcols.data(), pixels, 1, false);
+            _col2imAdd(dcols.data(), g, dx);
+          }
+        }
+      }
+
+      int64_t channelBlock = (groupOut + threads - 1) / threads;
+      int64_t blocks = (groupOut + channelBlock - 1) / channelBlock;
+      std::vector<T> cols(pointwise ? 0 : columnRows * pixels);
+#pragma omp parallel if (threads > 1)
+      {
+        for (int64_t n = 0; n < g.batch; ++n) {
+          for (int64_t group = 0; group < g.groups; ++group) {
+            const T *xg = xDataPtr + n * g.sN + group * groupChannels * g.sC;
+            const T *colsPtr = xg;
+            int64_t colsStride = g.sC;
+            if (!pointwise) {
+#pragma omp for schedule(static)
+              for (int64_t r = 0; r < columnRows; ++r)
+                _im2col(xg, g, r, r + 1, cols.data());
+              colsPtr = cols.data();
+              colsStride = pixels;
+            }
+
+#pragma omp for schedule(static)
+            for (int64_t block = 0; block < blocks; ++block) {
+              int64_t o0 = group * groupOut + block * channelBlock;
+              int64_t count = std::min(channelBlock,
+                                       groupOut - block * channelBlock);
+              const T *gy = outGradPtr + (n * g.outChannels + o0) * pixels;
+              _gemm(count, columnRows, pixels, gy, pixels, 1, colsPtr, 1,
+                    colsStride, dw.data() + o0 * columnRows, columnRows, 1,
+                    true);
+              for (int64_t o = 0; o < count; ++o) {
+                T sum = T(0);
+                for (int64_t p = 0; p < pixels; ++p)
+                  sum += gy[o * pixels + p];
+                dBias[o0 + o] += sum;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    for (int64_t o = 0; o < g.outChannels; ++o)
+      for (int64_t c = 0; c < groupChannels; ++c)
+        for (int64_t i = 0; i < g.kernelH; ++i)
+          for (int64_t j = 0; j < g.kernelW; ++j)
+            wGradPtr[o * weightStrides[0] + c * weightStrides[1] +
+                     i * weightStrides[2] + j * weightStrides[3]] +=
+                dw[o * columnRows + c * kernel + i * g.kernelW + j];
+    if (bGradPtr) {
+      for (int64_t o = 0; o < g.outChannels; ++o)
+        bGradPtr[o * biasStride] += dBias[o];
+    }
+  };
+
+  result.backwardCost =
+      _cost<T>(2 * flops, 2 * (result.size + size + weight.size),
+               size + weight.size + (bias ? bias->size : 0));
+  _profileOp(result, profileStart,
+             _cost<T>(flops, size + weight.size + g.outChannels, result.size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::maxPool2d(int64_t kernel, int64_t stride,
+                                           int64_t padding) {
+  return pool2d("maxPool2d", true, kernel, stride, padding);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::avgPool2d(int64_t kernel, int64_t stride,
+                                           int64_t padding) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "avgPool2d() requires a floating point element type.");
+  } else {
+    return pool2d("avgPool2d", false, kernel, stride, padding);
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::pool2d(const std::string &opName,
+                                        bool maximum, int64_t kernel,
+                                        int64_t stride, int64_t padding) {
+  int64_t profileStart = _profileStart();
+  if (stride == 0)
+    stride = kernel;
+  if (ndim != 4) {
+    throw std::invalid_argument(opName + "() requires (N, C, H, W) input.");
+  }
+  if (kernel < 1 || stride < 1 || padding < 0 || padding > kernel / 2) {
+    throw std::invalid_argument(
+        opName + "() requires kernel and stride >= 1 and 0 <= padding <= "
+                 "kernel / 2.");
+  }
+  if (shape[2] + 2 * padding < kernel || shape[3] + 2 * padding < kernel) {
+    throw std::invalid_argument(opName +
+                                "() kernel is larger than the padded input.");
+  }
+
+  // Pooling is a depthwise window over each plane: reuse the conv geometry
+  ConvGeometry g{};
+  g.batch = shape[0];
+  g.channels = g.outChannels = g.groups = shape[1];
+  g.height = shape[2];
+  g.width = shape[3];
+  g.kernelH = g.kernelW = kernel;
+  g.strideH = g.strideW = stride;
+  g.padH = g.padW = padding;
+  g.dilationH = g.dilationW = 1;
+  g.outH = (g.height + 2 * padding - kernel) / stride + 1;
+  g.outW = (g.width + 2 * padding - kernel) / stride + 1;
+  g.sN = strides[0];
+  g.sC = strides[1];
+  g.sH = strides[2];
+  g.sW = strides[3];
+
+  BasicNDArray result({g.batch, g.channels, g.outH, g.outW}, "",
+                      maximum ? "max_pool2d" : "avg_pool2d",
+                      {std::ref(*this)});
+  int64_t planes = g.batch * g.channels;
+  int64_t pixels = g.pixels();
+  int64_t work = result.size * kernel * kernel;
+  T scale = T(1) / static_cast<T>(kernel * kernel);
+  std::shared_ptr<std::vector<int64_t>> argmax;
+  if (maximum)
+    argmax = std::make_shared<std::vector<int64_t>>(result.size);
+
+#pragma omp parallel for schedule(static)                                      \
+    if (planes > 1 && work >= kParallelElements)
+  for (int64_t plane = 0; plane < planes; ++plane) {
+    int64_t base = plane / g.channels * g.sN + plane % g.channels * g.sC;
+    T *y = result.data + plane * pixels;
+    if (maximum)
+      _maxPoolPlane(data, base, g, y, argmax->data() + plane * pixels);
+    else
+      _avgPoolPlane(data + base, static_cast<T *>(nullptr), g, scale, y,
+                    static_cast<const T *>(nullptr));
+  }
+
+  // Backward: max routes dOut to the cached argmax, avg spreads it evenly.
+  // Planes run in parallel unless the input is a broadcast view whose
+  // elements alias.
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  bool aliased = false;
+  for (int d = 0; d < ndim; ++d)
+    aliased = aliased || (shape[d] > 1 && strides[d] == 0);
+  result._backward = [g, argmax, aGradPtr, outGradPtr, planes, pixels, work,
+                      scale, aliased]() {
+#pragma omp parallel for schedule(static)                                      \
+    if (!aliased && planes > 1 && work >= kParallelElements)
+    for (int64_t plane = 0; plane < planes; ++plane) {
+      const T *dy = outGradPtr + plane * pixels;
+      if (argmax) {
+        const int64_t *arg = argmax->data() + plane * pixels;
+        for (int64_t p = 0; p < pixels; ++p)
+          aGradPtr[arg[p]] += dy[p];
+      } else {
+        int64_t base = plane / g.channels * g.sN + plane % g.channels * g.sC;
+        _avgPoolPlane(static_cast<const T *>(nullptr), aGradPtr + base, g,
+                      scale, static_cast<T *>(nullptr), dy);
+      }
+    }
+  };
+
+  result.backwardCost =
+      _cost<T>(maximum ? result.size : work, 2 * result.size, size);
+  _profileOp(result, profileStart, _cost<T>(work, size, result.size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::layerNorm(BasicNDArray &gamma,
+                                           BasicNDArray &beta, T eps) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "layerNorm() requires a floating point element type.");
+  } else {
+    int64_t profileStart = _profileStart();
+    if (ndim == 0) {
+      throw std::invalid_argument(
+          "layerNorm() requires an array with a feature axis.");
+    }
+    int64_t features = shape[ndim - 1];
+    if (gamma.ndim != 1 || beta.ndim != 1 || gamma.size != features ||
+        beta.size != features) {
+      throw std::invalid_argument(
+          "layerNorm() requires gamma and beta of shape {" +
+          std::to_string(features) + "}.");
+    }
+    int64_t rows = features > 0 ? size / features : 0;
+
+    BasicNDArray result(shape, "", "layer_norm",
+                        {std::ref(*this), std::ref(gamma), std::ref(beta)});
+    int64_t gammaStride = gamma.strides[0];
+    int64_t betaStride = beta.strides[0];
+    T *gammaDataPtr = gamma.data;
+    std::vector<T> gammaCopy;
+    std::vector<T> betaCopy;
+    const T *g = _unitStride(gamma.data, features, gammaStride, gammaCopy);
+    const T *b = _unitStride(beta.data, features, betaStride, betaCopy);
+
+    // Strided input is gathered into the result and normalized in place
+    bool contiguous = isContiguous();
+    const T *x = data;
+    if (!contiguous) {
+      _gatherStrided(data, shape, strides, size, result.data);
+      x = result.data;
+    }
 
-  for (int i = 0; i < result.shape[0]; i++) {
-    for (int j = 0; j < result.shape[1]; j++) {
-      float sum = 0.f;
+    // One Welford pass per row, then normalize and apply the affine
+    // transform in a single sweep
+    auto mean = std::make_shared<std::vector<T>>(rows);
+    auto rstd = std::make_shared<std::vector<T>>(rows);
+#pragma omp parallel for schedule(static)                                      \
+    if (rows > 1 && size >= kParallelElements)
+    for (int64_t r = 0; r < rows; ++r) {
+      const T *row = x + r * features;
+      T *out = result.data + r * features;
+      Moments<T> moments = _moments(row, features);
+      T mu = moments.mean;
+      T inverse = T(1) / std::sqrt(moments.variance() + eps);
+      (*mean)[r] = mu;
+      (*rstd)[r] = inverse;
+      for (int64_t j = 0; j < features; ++j)
+        out[j] = (row[j] - mu) * inverse * g[j] + b[j];
+    }
 
-      for (int k = 0; k < this->shape[1]; k++) {
-        sum += get({i, k}) * other.get({k, j});
+    // Backward with xhat = (x - mean) * rstd and dg = dOut * gamma:
+    // dx += rstd * (dg - mean(dg) - xhat * mean(dg * xhat)) per row in
+    // parallel; dGamma = sum(dOut * xhat) and dBeta = sum(dOut) over rows,
+    // in parallel across blocks of features (rows added in order)
+    T *aDataPtr = this->data;
+    T *aGradPtr = this->grad;
+    T *gammaGradPtr = gamma.grad;
+    T *betaGradPtr = beta.grad;
+    T *outGradPtr = result.grad;
+    Shape shapeCopy = shape;
+    Shape stridesCopy = strides;
+    int64_t count = size;
+    result._backward = [aDataPtr, aGradPtr, gammaGradPtr, betaGradPtr,
+                        gammaStride, betaStride, outGradPtr, shapeCopy,
+                        stridesCopy, contiguous, count, rows, features,
+                        gammaDataPtr, mean, rstd]() {
+      const T *x = aDataPtr;
+      T *dx = aGradPtr;
+      std::vector<T> gatheredX;
+      std::vector<T> gatheredGrad;
+      if (!contiguous) {
+        gatheredX.resize(count);
+        _gatherStrided(aDataPtr, shapeCopy, stridesCopy, count,
+                       gatheredX.data());
+        gatheredGrad.assign(count, T(0));
+        x = gatheredX.data();
+        dx = gatheredGrad.data();
       }
 
-      result.set({i, j}, sum);
-    }
+      std::vector<T> gammaCopy;
+      const T *g = _unitStride(gammaDataPtr, features, gammaStride, gammaCopy);
+      T inverseFeatures = T(1) / static_cast<T>(features);
+#pragma omp parallel for schedule(static)                                      \
+    if (rows > 1 && count >= kParallelElements)
+      for (int64_t r = 0; r < rows; ++r) {
+        const T *row = x + r * features;
+        const T *dy = outGradPtr + r * features;
+        T *dxRow = dx + r * features;
+        T mu = (*mean)[r];
+        T inverse = (*rstd)[r];
+        T sumG = T(0);
+        T sumGX = T(0);
+        for (int64_t j = 0; j < features; ++j) {
+          T dg = dy[j] * g[j];
+          sumG += dg;
+          sumGX += dg * (row[j] - mu) * inverse;
+        }
+        T meanG = sumG * inverseFeatures;
+        T meanGX = sumGX * inverseFeatures;
+        for (int64_t j = 0; j < features; ++j) {
+          T xhat = (row[j] - mu) * inverse;
+          dxRow[j] += inverse * (dy[j] * g[j] - meanG - xhat * meanGX);
+        }
+      }
+
+      const int64_t columnBlock = 64;
+      int64_t blocks = (features + columnBlock - 1) / columnBlock;
+#pragma omp parallel if (blocks > 1 && count >= kParallelElements)
+      {
+        std::vector<T> dGamma(columnBlock);
+        std::vector<T> dBeta(columnBlock);
+
+#pragma omp for schedule(static)
+        for (int64_t block = 0; block < blocks; ++block) {
+          int64_t j0 = block * columnBlock;
+          int64_t width = std::min(columnBlock, features - j0);
+          std::fill(dGamma.begin(), dGamma.end(), T(0));
+          std::fill(dBeta.begin(), dBeta.end(), T(0));
+          for (int64_t r = 0; r < rows; ++r) {
+            const T *row = x + r * features + j0;
+            const T *dy = outGradPtr + r * features + j0;
+            T mu = (*mean)[r];
+            T inverse = (*rstd)[r];
+            for (int64_t j = 0; j < width; ++j) {
+              dGamma[j] += dy[j] * (row[j] - mu) * inverse;
+              dBeta[j] += dy[j];
+            }
+          }
+          for (int64_t j = 0; j < width; ++j) {
+            gammaGradPtr[(j0 + j) * gammaStride] += dGamma[j];
+            betaGradPtr[(j0 + j) * betaStride] += dBeta[j];
+          }
+        }
+      }
+
+      if (!contiguous)
+        _scatterAddStrided(dx, shapeCopy, stridesCopy, count, aGradPtr);
+    };
+
+    result.backwardCost = _cost<T>(12 * size, 3 * size, size + 2 * features);
+    _profileOp(result, profileStart,
+               _cost<T>(8 * size, size + 2 * features, size),
+               ProfilePhase::Forward);
+
+    return result;
   }
+}
 
-  // Backward pass for matrix multiplication:
-  // If C = A * B, then
-  // dA += dC * B^T and dB += A^T * dC
-  int m = this->shape[0];
-  int k = this->shape[1];
-  int n = other.shape[1];
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::batchNorm(BasicNDArray &gamma, BasicNDArray &beta,
+                           BasicNDArray &runningMean,
+                           BasicNDArray &runningVar, bool training,
+                           T momentum, T eps) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "batchNorm() requires a floating point element type.");
+  } else {
+    int64_t profileStart = _profileStart();
+    if (ndim < 2) {
+      throw std::invalid_argument("batchNorm() requires (N, C, ...) input.");
+    }
+    int64_t batch = shape[0];
+    int64_t channels = shape[1];
+    int64_t spatial = 1;
+    for (int d = 2; d < ndim; ++d)
+      spatial *= shape[d];
+    for (BasicNDArray *parameter : {&gamma, &beta, &runningMean, &runningVar}) {
+      if (parameter->ndim != 1 || parameter->size != channels) {
+        throw std::invalid_argument(
+            "batchNorm() requires gamma, beta and running statistics of "
+            "shape {" +
+            std::to_string(channels) + "}.");
+      }
+    }
+    int64_t count = batch * spatial;
+    if (training && count < 2) {
+      throw std::invalid_argument(
+          "batchNorm() needs more than one value per channel in training.");
+    }
 
-  float *aGradPtr = this->grad;
-  float *bGradPtr = other.grad;
-  float *outGradPtr = result.grad;
-  float *aDataPtr = this->data;
-  float *bDataPtr = other.data;
+    BasicNDArray result(shape, "", "batch_norm",
+                        {std::ref(*this), std::ref(gamma), std::ref(beta)});
+    if (training) {
+      runningMean.ensureUnique();
+      runningVar.ensureUnique();
+    }
+    int64_t gammaStride = gamma.strides[0];
+    int64_t betaStride = beta.strides[0];
+    int64_t meanStride = runningMean.strides[0];
+    int64_t varStride = runningVar.strides[0];
+    auto gammaValues = std::make_shared<std::vector<T>>(channels);
+    for (int64_t c = 0; c < channels; ++c)
+      (*gammaValues)[c] = gamma.data[c * gammaStride];
+
+    bool contiguous = isContiguous();
+    const T *x = data;
+    if (!contiguous) {
+      _gatherStrided(data, shape, strides, size, result.data);
+      x = result.data;
+    }
 
-  std::vector<int> aStridesCopy = this->strides;
-  std::vector<int> bStridesCopy = other.strides;
-  std::vector<int> outShapeCopy = {m, n};
-  std::vector<int> outStridesCopy = detail::_computeStrides(outShapeCopy);
+    // Per channel, in parallel: merge the Welford moments of its N slices
+    // (training) or take the running statistics, then normalize and apply
+    // the affine transform in one sweep
+    auto mean = std::make_shared<std::vector<T>>(channels);
+    auto rstd = std::make_shared<std::vector<T>>(channels);
+    T unbias =
+        training ? static_cast<T>(count) / static_cast<T>(count - 1) : T(1);
+#pragma omp parallel for schedule(static)                                      \
+    if (channels > 1 && size >= kParallelElements)
+    for (int64_t c = 0; c < channels; ++c) {
+      T mu;
+      T variance;
+      if (training) {
+        Moments<T> moments;
+        for (int64_t n = 0; n < batch; ++n)
+          moments.merge(_moments(x + (n * channels + c) * spatial, spatial));
+        mu = moments.mean;
+        variance = moments.variance();
+        T &meanSlot = runningMean.data[c * meanStride];
+        T &varSlot = runningVar.data[c * varStride];
+        meanSlot = (T(1) - momentum) * meanSlot + momentum * mu;
+        varSlot = (T(1) - momentum) * varSlot + momentum * variance * unbias;
+      } else {
+        mu = runningMean.data[c * meanStride];
+        variance = runningVar.data[c * varStride];
+      }
 
-  result._backward = [m, k, n, aGradPtr, bGradPtr, outGradPtr, aDataPtr,
-                      bDataPtr, aStridesCopy, bStridesCopy,
-                      outStridesCopy]() mutable {
-    // Accumulate into A's gradient: dA(i,k) += sum_j dC(i,j) * B(k,j)
-    for (int i = 0; i < m; ++i) {
-      for (int kk = 0; kk < k; ++kk) {
-        float accum = 0.0f;
-        for (int j = 0; j < n; ++j) {
-          int offOut = detail::_computeOffset({i, j}, outStridesCopy);
-          int offB = detail::_computeOffset({kk, j}, bStridesCopy);
-          accum += outGradPtr[offOut] * bDataPtr[offB];
-        }
-        int offA = detail::_computeOffset({i, kk}, aStridesCopy);
-        aGradPtr[offA] += accum;
+      T inverse = T(1) / std::sqrt(variance + eps);
+      (*mean)[c] = mu;
+      (*rstd)[c] = inverse;
+      T scale = inverse * (*gammaValues)[c];
+      T shift = beta.data[c * betaStride] - mu * scale;
+      for (int64_t n = 0; n < batch; ++n) {
+        const T *in = x + (n * channels + c) * spatial;
+        T *out = result.data + (n * channels + c) * spatial;
+        for (int64_t s = 0; s < spatial; ++s)
+          out[s] = in[s] * scale + shift;
       }
     }
 
-    // Accumulate into B's gradient: dB(k,j) += sum_i A(i,k) * dC(i,j)
-    for (int kk = 0; kk < k; ++kk) {
-      for (int j = 0; j < n; ++j) {
-        float accum = 0.0f;
-        for (int i = 0; i < m; ++i) {
-          int offOut = detail::_computeOffset({i, j}, outStridesCopy);
-          int offAData = detail::_computeOffset({i, kk}, aStridesCopy);
-          accum += aDataPtr[offAData] * outGradPtr[offOut];
+    // Backward per channel, in parallel: dBeta = sum(dOut), dGamma =
+    // sum(dOut * xhat) and, with batch statistics, dx += gamma * rstd *
+    // (dOut - (dBeta + xhat * dGamma) / count); with running statistics
+    // dx += gamma * rstd * dOut
+    T *aDataPtr = this->data;
+    T *aGradPtr = this->grad;
+    T *gammaGradPtr = gamma.grad;
+    T *betaGradPtr = beta.grad;
+    T *outGradPtr = result.grad;
+    Shape shapeCopy = shape;
+    Shape stridesCopy = strides;
+    int64_t total = size;
+    result._backward = [aDataPtr, aGradPtr, gammaGradPtr, betaGradPtr,
+                        gammaStride, betaStride, outGradPtr, shapeCopy,
+                        stridesCopy, contiguous, total, batch, channels,
+                        spatial, count, training, gammaValues, mean, rstd]() {
+      const T *x = aDataPtr;
+      T *dx = aGradPtr;
+      std::vector<T> gatheredX;
+      std::vector<T> gatheredGrad;
+      if (!contiguous) {
+        gatheredX.resize(total);
+        _gatherStrided(aDataPtr, shapeCopy, stridesCopy, total,
+                       gatheredX.data());
+        gatheredGrad.assign(total, T(0));
+        x = gatheredX.data();
+        dx = gatheredGrad.data();
+      }
+
+      T inverseCount = T(1) / static_cast<T>(count);
+#pragma omp parallel for schedule(static)                                      \
+    if (channels > 1 && total >= kParallelElements)
+      for (int64_t c = 0; c < channels; ++c) {
+        T mu = (*mean)[c];
+        T inverse = (*rstd)[c];
+        T sumDy = T(0);
+        T sumDyX = T(0);
+        for (int64_t n = 0; n < batch; ++n) {
+          const T *in = x + (n * channels + c) * spatial;
+          const T *dy = outGradPtr + (n * channels + c) * spatial;
+          for (int64_t s = 0; s < spatial; ++s) {
+            sumDy += dy[s];
+            sumDyX += dy[s] * (in[s] - mu) * inverse;
+          }
+        }
+        gammaGradPtr[c * gammaStride] += sumDyX;
+        betaGradPtr[c * betaStride] += sumDy;
+
+        T scale = (*gammaValues)[c] * inverse;
+        T meanDy = training ? sumDy * inverseCount : T(0);
+        T meanDyX = training ? sumDyX * inverseCount : T(0);
+        for (int64_t n = 0; n < batch; ++n) {
+          const T *in = x + (n * channels + c) * spatial;
+          const T *dy = outGradPtr + (n * channels + c) * spatial;
+          T *dxSlice = dx + (n * channels + c) * spatial;
+          for (int64_t s = 0; s < spatial; ++s) {
+            T xhat = (in[s] - mu) * inverse;
+            dxSlice[s] += scale * (dy[s] - meanDy - xhat * meanDyX);
+          }
         }
-        int offB = detail::_computeOffset({kk, j}, bStridesCopy);
-        bGradPtr[offB] += accum;
       }
-    }
-  };
 
-  return result;
+      if (!contiguous)
+        _scatterAddStrided(dx, shapeCopy, stridesCopy, total, aGradPtr);
+    };
+
+    result.backwardCost = _cost<T>(10 * size, 3 * size, size + 2 * channels);
+    _profileOp(result, profileStart,
+               _cost<T>((training ? 6 : 2) * size, size + 4 * channels, size),
+               ProfilePhase::Forward);
+
+    return result;
+  }
 }
 
-NDArray NDArray::operator*(float value) { return element_wise_multiply(value); }
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator*(T value) {
+  return element_wise_multiply(value);
+}
 
-NDArray NDArray::operator/(NDArray &other) {
-  std::vector<int> outShape = detail::_broadcastShape(shape, other.shape);
-  std::vector<int> stridesA =
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator/(BasicNDArray &other) {
+  int64_t profileStart = _profileStart();
+  Shape outShape = detail::_broadcastShape(shape, other.shape);
+  Shape stridesA =
       detail::_broadcastStrides(shape, strides, outShape);
-  std::vector<int> stridesB =
+  Shape stridesB =
       detail::_broadcastStrides(other.shape, other.strides, outShape);
 
-  NDArray result(outShape, "", "/", {std::ref(*this), std::ref(other)});
-  std::vector<int> index(outShape.size(), 0);
+  BasicNDArray result(outShape, "", "/", {std::ref(*this), std::ref(other)});
+  Shape index(outShape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offsetA = detail::_computeOffset(index, stridesA);
-    int offsetB = detail::_computeOffset(index, stridesB);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offsetA = detail::_computeOffset(index, stridesA);
+    int64_t offsetB = detail::_computeOffset(index, stridesB);
     if (other.data[offsetB] == 0) {
+      if constexpr (std::is_integral_v<T>) {
+        throw std::domain_error("Integer division by zero.");
+      }
       std::cerr << "\nWarning: Division by zero attempted. Result will be "
                    "'inf'."
                 << std::endl;
@@ -642,27 +3634,27 @@ NDArray NDArray::operator/(NDArray &other) {
 
   // Backward pass: y = a / b =>
   // dA += (1/b) * dOut, dB += (-a / b^2) * dOut
-  float *aGradPtr = this->grad;
-  float *bGradPtr = other.grad;
-  float *outGradPtr = result.grad;
-  float *aDataPtr = this->data;
-  float *bDataPtr = other.data;
-  int outSize = result.size;
-  std::vector<int> outShapeCopy = outShape;
-  std::vector<int> stridesACopy = stridesA;
-  std::vector<int> stridesBCopy = stridesB;
+  T *aGradPtr = this->grad;
+  T *bGradPtr = other.grad;
+  T *outGradPtr = result.grad;
+  T *aDataPtr = this->data;
+  T *bDataPtr = other.data;
+  int64_t outSize = result.size;
+  Shape outShapeCopy = outShape;
+  Shape stridesACopy = stridesA;
+  Shape stridesBCopy = stridesB;
 
   result._backward = [aGradPtr, bGradPtr, outGradPtr, aDataPtr, bDataPtr,
                       outSize, outShapeCopy, stridesACopy,
                       stridesBCopy]() mutable {
-    std::vector<int> idx(outShapeCopy.size(), 0);
-    for (int i = 0; i < outSize; ++i) {
-      int offA = detail::_computeOffset(idx, stridesACopy);
-      int offB = detail::_computeOffset(idx, stridesBCopy);
-      float upstream = outGradPtr[i];
-      float aVal = aDataPtr[offA];
-      float bVal = bDataPtr[offB];
-      if (bVal != 0.0f) {
+    Shape idx(outShapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t offA = detail::_computeOffset(idx, stridesACopy);
+      int64_t offB = detail::_computeOffset(idx, stridesBCopy);
+      T upstream = outGradPtr[i];
+      T aVal = aDataPtr[offA];
+      T bVal = bDataPtr[offB];
+      if (bVal != T(0)) {
         aGradPtr[offA] += upstream / bVal;
         bGradPtr[offB] -= upstream * (aVal / (bVal * bVal));
       } else {
@@ -680,16 +3672,28 @@ NDArray NDArray::operator/(NDArray &other) {
     }
   };
 
+  result.backwardCost = _cost<T>(6 * result.size,
+                                 result.size + 2 * (size + other.size),
+                                 size + other.size);
+  _profileOp(result, profileStart,
+             _cost<T>(result.size, size + other.size, result.size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::operator/(float value) {
-  NDArray result(shape, "", "/", {std::ref(*this)});
-  std::vector<int> index(shape.size(), 0);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator/(T value) {
+  int64_t profileStart = _profileStart();
+  BasicNDArray result(shape, "", "/", {std::ref(*this)});
+  Shape index(shape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offset = detail::_computeOffset(index, strides);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offset = detail::_computeOffset(index, strides);
     if (value == 0) {
+      if constexpr (std::is_integral_v<T>) {
+        throw std::domain_error("Integer division by zero.");
+      }
       std::cerr << "\nWarning: Division by zero attempted. Result will be "
                    "'inf'."
                 << std::endl;
@@ -705,28 +3709,46 @@ NDArray NDArray::operator/(float value) {
   }
 
   // Backward: y = a / c => dA += (1/c) * dOut
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  int outSize = result.size;
-  float c = value;
-  result._backward = [aGradPtr, outGradPtr, outSize, c]() mutable {
-    if (c == 0.0f)
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  T c = value;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  result._backward = [aGradPtr, outGradPtr, outSize, c, shapeCopy,
+                      stridesCopy]() mutable {
+    if (c == T(0))
       return; // already warned; skip accumulation to avoid NaNs
-    for (int i = 0; i < outSize; ++i) {
-      aGradPtr[i] += outGradPtr[i] / c;
+    Shape idx(shapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t off = detail::_computeOffset(idx, stridesCopy);
+      aGradPtr[off] += outGradPtr[i] / c;
+
+      for (int d = static_cast<int>(shapeCopy.size()) - 1; d >= 0; --d) {
+        idx[d]++;
+        if (idx[d] < shapeCopy[d])
+          break;
+        idx[d] = 0;
+      }
     }
   };
 
+  result.backwardCost = _cost<T>(2 * size, 2 * size, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::operator^(float value) {
-  NDArray result(shape, "", "^", {std::ref(*this)});
-  std::vector<int> index(shape.size(), 0);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::operator^(float value) {
+  int64_t profileStart = _profileStart();
+  BasicNDArray result(shape, "", "^", {std::ref(*this)});
+  Shape index(shape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offset = detail::_computeOffset(index, strides);
-    result.data[i] = std::pow(data[offset], value);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offset = detail::_computeOffset(index, strides);
+    result.data[i] = static_cast<T>(std::pow(data[offset], value));
 
     for (int dim = shape.size() - 1; dim >= 0; --dim) {
       index[dim]++;
@@ -737,36 +3759,249 @@ NDArray NDArray::operator^(float value) {
   }
 
   // Backward: y = a^c => dA += c * a^(c-1) * dOut
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  float *aDataPtr = this->data;
-  int outSize = result.size;
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  T *aDataPtr = this->data;
+  int64_t outSize = result.size;
   float c = value;
-  result._backward = [aGradPtr, outGradPtr, aDataPtr, outSize, c]() mutable {
-    for (int i = 0; i < outSize; ++i) {
-      float aVal = aDataPtr[i];
-      float localGrad =
-          (c == 0.0f && aVal == 0.0f) ? 0.0f : (c * std::pow(aVal, c - 1.0f));
-      aGradPtr[i] += outGradPtr[i] * localGrad;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  result._backward = [aGradPtr, outGradPtr, aDataPtr, outSize, c, shapeCopy,
+                      stridesCopy]() mutable {
+    Shape idx(shapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t off = detail::_computeOffset(idx, stridesCopy);
+      T aVal = aDataPtr[off];
+      T localGrad = (c == 0.0f && aVal == T(0))
+                        ? T(0)
+                        : static_cast<T>(c * std::pow(aVal, c - 1.0f));
+      aGradPtr[off] += outGradPtr[i] * localGrad;
+
+      for (int d = static_cast<int>(shapeCopy.size()) - 1; d >= 0; --d) {
+        idx[d]++;
+        if (idx[d] < shapeCopy[d])
+          break;
+        idx[d] = 0;
+      }
     }
   };
 
+  result.backwardCost = _cost<T>(3 * size, 3 * size, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+template <typename Forward, typename Backward>
+BasicNDArray<T> BasicNDArray<T>::unaryOp(const std::string &opName,
+                                         int64_t flopsPerElement,
+                                         Forward forward, Backward backward) {
+  int64_t profileStart = _profileStart();
+  BasicNDArray result(shape, "", opName, {std::ref(*this)});
+
+  bool contiguous = isContiguous();
+  if (contiguous) {
+    forward(data, result.data, size);
+  } else {
+    _gatherStrided(data, shape, strides, size, result.data);
+    forward(result.data, result.data, size);
+  }
+
+  // Backward: dA += f'(a) * dOut, over contiguous buffers; strided inputs
+  // are gathered and their contributions scattered back
+  T *aDataPtr = this->data;
+  T *aGradPtr = this->grad;
+  T *outDataPtr = result.data;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  result._backward = [aDataPtr, aGradPtr, outDataPtr, outGradPtr, outSize,
+                      shapeCopy, stridesCopy, contiguous, backward]() {
+    if (contiguous) {
+      backward(aDataPtr, outDataPtr, outGradPtr, aGradPtr, outSize);
+      return;
+    }
+    std::vector<T> a(outSize);
+    std::vector<T> aGrad(outSize, T(0));
+    _gatherStrided(aDataPtr, shapeCopy, stridesCopy, outSize, a.data());
+    backward(a.data(), outDataPtr, outGradPtr, aGrad.data(), outSize);
+    _scatterAddStrided(aGrad.data(), shapeCopy, stridesCopy, outSize,
+                       aGradPtr);
+  };
+
+  result.backwardCost = _cost<T>(3 * size, 3 * size, size);
+  _profileOp(result, profileStart, _cost<T>(flopsPerElement * size, size, size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::element_wise_multiply(NDArray &other) {
-  std::vector<int> outShape = detail::_broadcastShape(shape, other.shape);
-  std::vector<int> stridesA =
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::exp(MathMode mode) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error("exp() requires a floating point element type.");
+  } else {
+    // Backward: y = e^a => dA += y * dOut
+    auto backward = [](const T *, const T *y, const T *dOut, T *dA,
+                       int64_t n) {
+      for (int64_t i = 0; i < n; ++i)
+        dA[i] += y[i] * dOut[i];
+    };
+    if (mode == MathMode::Fast)
+      return unaryOp("exp", 12,
+                     _mapKernel<T>([](T x) { return _exp<T, true>(x); }),
+                     backward);
+    return unaryOp("exp", 16,
+                   _mapKernel<T>([](T x) { return _exp<T, false>(x); }),
+                   backward);
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::log(MathMode mode) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error("log() requires a floating point element type.");
+  } else {
+    // Backward: y = ln(a) => dA += dOut / a (skipped where a == 0)
+    auto backward = [](const T *a, const T *, const T *dOut, T *dA,
+                       int64_t n) {
+      for (int64_t i = 0; i < n; ++i)
+        dA[i] += a[i] != T(0) ? dOut[i] / a[i] : T(0);
+    };
+    if (mode == MathMode::Fast)
+      return unaryOp("log", 14,
+                     _mapKernel<T>([](T x) { return _log<T, true>(x); }),
+                     backward);
+    return unaryOp("log", 20,
+                   _mapKernel<T>([](T x) { return _log<T, false>(x); }),
+                   backward);
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::tanh(MathMode mode) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "tanh() requires a floating point element type.");
+  } else {
+    // Backward: y = tanh(a) => dA += (1 - y^2) * dOut
+    auto backward = [](const T *, const T *y, const T *dOut, T *dA,
+                       int64_t n) {
+      for (int64_t i = 0; i < n; ++i)
+        dA[i] += (T(1) - y[i] * y[i]) * dOut[i];
+    };
+    if (mode == MathMode::Fast)
+      return unaryOp("tanh", 16,
+                     _mapKernel<T>([](T x) { return _tanh<T, true>(x); }),
+                     backward);
+    return unaryOp("tanh", 20,
+                   _mapKernel<T>([](T x) { return _tanh<T, false>(x); }),
+                   backward);
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::sigmoid(MathMode mode) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "sigmoid() requires a floating point element type.");
+  } else {
+    // Backward: y = 1 / (1 + e^-a) => dA += y * (1 - y) * dOut
+    auto backward = [](const T *, const T *y, const T *dOut, T *dA,
+                       int64_t n) {
+      for (int64_t i = 0; i < n; ++i)
+        dA[i] += y[i] * (T(1) - y[i]) * dOut[i];
+    };
+    if (mode == MathMode::Fast)
+      return unaryOp("sigmoid", 14,
+                     _mapKernel<T>([](T x) { return _sigmoid<T, true>(x); }),
+                     backward);
+    return unaryOp("sigmoid", 18,
+                   _mapKernel<T>([](T x) { return _sigmoid<T, false>(x); }),
+                   backward);
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::relu() {
+  // Backward: dA += (a > 0) * dOut
+  return unaryOp(
+      "relu", 1, _mapKernel<T>([](T x) { return x < T(0) ? T(0) : x; }),
+      [](const T *a, const T *, const T *dOut, T *dA, int64_t n) {
+        for (int64_t i = 0; i < n; ++i)
+          dA[i] += a[i] > T(0) ? dOut[i] : T(0);
+      });
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::gelu(MathMode mode) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "gelu() requires a floating point element type.");
+  } else {
+    // Backward: dA += gelu'(a) * dOut, matching the forward formulation
+    if (mode == MathMode::Fast && std::is_same_v<T, float>)
+      return unaryOp(
+          "gelu", 24, _mapKernel<T>([](T x) { return _geluTanh(x); }),
+          [](const T *a, const T *, const T *dOut, T *dA, int64_t n) {
+            for (int64_t i = 0; i < n; ++i)
+              dA[i] += _geluTanhGrad(a[i]) * dOut[i];
+          });
+    return unaryOp(
+        "gelu", 24, _mapKernel<T>([](T x) { return _geluErf(x); }),
+        [](const T *a, const T *, const T *dOut, T *dA, int64_t n) {
+          for (int64_t i = 0; i < n; ++i)
+            dA[i] += _geluErfGrad(a[i]) * dOut[i];
+        });
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::sqrt() {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "sqrt() requires a floating point element type.");
+  } else {
+    // Backward: y = sqrt(a) => dA += dOut / (2y) (skipped where y == 0)
+    return unaryOp(
+        "sqrt", 1, _mapKernel<T>([](T x) { return std::sqrt(x); }),
+        [](const T *, const T *y, const T *dOut, T *dA, int64_t n) {
+          for (int64_t i = 0; i < n; ++i)
+            dA[i] += y[i] != T(0) ? dOut[i] / (T(2) * y[i]) : T(0);
+        });
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::abs() {
+  // Backward: dA += sign(a) * dOut
+  return unaryOp(
+      "abs", 1, _mapKernel<T>([](T x) { return std::abs(x); }),
+      [](const T *a, const T *, const T *dOut, T *dA, int64_t n) {
+        for (int64_t i = 0; i < n; ++i)
+          dA[i] += a[i] > T(0) ? dOut[i] : (a[i] < T(0) ? -dOut[i] : T(0));
+      });
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::element_wise_multiply(BasicNDArray &other) {
+  int64_t profileStart = _profileStart();
+  Shape outShape = detail::_broadcastShape(shape, other.shape);
+  Shape stridesA =
       detail::_broadcastStrides(shape, strides, outShape);
-  std::vector<int> stridesB =
+  Shape stridesB =
       detail::_broadcastStrides(other.shape, other.strides, outShape);
 
-  NDArray result(outShape, "", "elem_mul", {std::ref(*this), std::ref(other)});
-  std::vector<int> index(outShape.size(), 0);
+  BasicNDArray result(outShape, "", "elem_mul",
+                      {std::ref(*this), std::ref(other)});
+  Shape index(outShape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offsetA = detail::_computeOffset(index, stridesA);
-    int offsetB = detail::_computeOffset(index, stridesB);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offsetA = detail::_computeOffset(index, stridesA);
+    int64_t offsetB = detail::_computeOffset(index, stridesB);
     result.data[i] = this->data[offsetA] * other.data[offsetB];
 
     for (int dim = outShape.size() - 1; dim >= 0; --dim) {
@@ -778,24 +4013,24 @@ NDArray NDArray::element_wise_multiply(NDArray &other) {
   }
 
   // Backward pass: y = a * b => dA += b * dOut; dB += a * dOut
-  float *aGradPtr = this->grad;
-  float *bGradPtr = other.grad;
-  float *outGradPtr = result.grad;
-  float *aDataPtr = this->data;
-  float *bDataPtr = other.data;
-  int outSize = result.size;
-  std::vector<int> outShapeCopy = outShape;
-  std::vector<int> stridesACopy = stridesA;
-  std::vector<int> stridesBCopy = stridesB;
+  T *aGradPtr = this->grad;
+  T *bGradPtr = other.grad;
+  T *outGradPtr = result.grad;
+  T *aDataPtr = this->data;
+  T *bDataPtr = other.data;
+  int64_t outSize = result.size;
+  Shape outShapeCopy = outShape;
+  Shape stridesACopy = stridesA;
+  Shape stridesBCopy = stridesB;
 
   result._backward = [aGradPtr, bGradPtr, outGradPtr, aDataPtr, bDataPtr,
                       outSize, outShapeCopy, stridesACopy,
                       stridesBCopy]() mutable {
-    std::vector<int> idx(outShapeCopy.size(), 0);
-    for (int i = 0; i < outSize; ++i) {
-      int offA = detail::_computeOffset(idx, stridesACopy);
-      int offB = detail::_computeOffset(idx, stridesBCopy);
-      float upstream = outGradPtr[i];
+    Shape idx(outShapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t offA = detail::_computeOffset(idx, stridesACopy);
+      int64_t offB = detail::_computeOffset(idx, stridesBCopy);
+      T upstream = outGradPtr[i];
       aGradPtr[offA] += upstream * bDataPtr[offB];
       bGradPtr[offB] += upstream * aDataPtr[offA];
 
@@ -808,15 +4043,24 @@ NDArray NDArray::element_wise_multiply(NDArray &other) {
     }
   };
 
+  result.backwardCost = _cost<T>(4 * result.size,
+                                 result.size + 2 * (size + other.size),
+                                 size + other.size);
+  _profileOp(result, profileStart,
+             _cost<T>(result.size, size + other.size, result.size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::element_wise_multiply(float value) {
-  NDArray result(shape, "", "elem_mul", {std::ref(*this)});
-  std::vector<int> index(shape.size(), 0);
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::element_wise_multiply(T value) {
+  int64_t profileStart = _profileStart();
+  BasicNDArray result(shape, "", "elem_mul", {std::ref(*this)});
+  Shape index(shape.size(), 0);
 
-  for (int i = 0; i < result.size; ++i) {
-    int offset = detail::_computeOffset(index, strides);
+  for (int64_t i = 0; i < result.size; ++i) {
+    int64_t offset = detail::_computeOffset(index, strides);
     result.data[i] = data[offset] * value;
 
     for (int dim = shape.size() - 1; dim >= 0; --dim) {
@@ -828,21 +4072,39 @@ NDArray NDArray::element_wise_multiply(float value) {
   }
 
   // Backward: y = a * c => dA += c * dOut
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  int outSize = result.size;
-  float c = value;
-  result._backward = [aGradPtr, outGradPtr, outSize, c]() mutable {
-    for (int i = 0; i < outSize; ++i) {
-      aGradPtr[i] += outGradPtr[i] * c;
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  int64_t outSize = result.size;
+  T c = value;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  result._backward = [aGradPtr, outGradPtr, outSize, c, shapeCopy,
+                      stridesCopy]() mutable {
+    Shape idx(shapeCopy.size(), 0);
+    for (int64_t i = 0; i < outSize; ++i) {
+      int64_t off = detail::_computeOffset(idx, stridesCopy);
+      aGradPtr[off] += outGradPtr[i] * c;
+
+      for (int d = static_cast<int>(shapeCopy.size()) - 1; d >= 0; --d) {
+        idx[d]++;
+        if (idx[d] < shapeCopy[d])
+          break;
+        idx[d] = 0;
+      }
     }
   };
 
+  result.backwardCost = _cost<T>(2 * size, 2 * size, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, size),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-void NDArray::build_topo(std::unordered_set<NDArray *> &visited, NDArray *arr,
-                         std::vector<std::reference_wrapper<NDArray>> &topo) {
+template <typename T>
+void BasicNDArray<T>::build_topo(
+    std::unordered_set<BasicNDArray *> &visited, BasicNDArray *arr,
+    std::vector<std::reference_wrapper<BasicNDArray>> &topo) {
   if (visited.find(arr) == visited.end()) {
     visited.insert(arr);
     for (auto &p : arr->prev) {
@@ -852,35 +4114,49 @@ void NDArray::build_topo(std::unordered_set<NDArray *> &visited, NDArray *arr,
   }
 }
 
-void NDArray::backward() {
-  std::unordered_set<NDArray *> visited;
-  std::vector<std::reference_wrapper<NDArray>> topo;
+template <typename T>
+void BasicNDArray<T>::backward() {
+  std::unordered_set<BasicNDArray *> visited;
+  std::vector<std::reference_wrapper<BasicNDArray>> topo;
   build_topo(visited, this, topo);
 
   // Initialize gradient of the output w.r.t itself to ones
-  for (int i = 0; i < size; ++i) {
-    grad[i] = 1.0f;
+  Shape index(shape.size(), 0);
+  for (int64_t i = 0; i < size; ++i) {
+    grad[detail::_computeOffset(index, strides)] = T(1);
+
+    for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < shape[dim])
+        break;
+      index[dim] = 0;
+    }
   }
 
   for (int i = static_cast<int>(topo.size()) - 1; i >= 0; --i) {
-    topo[i].get()._backward();
+    BasicNDArray &node = topo[i].get();
+    int64_t profileStart = node.prev.empty() ? -1 : _profileStart();
+    node._backward();
+    _profileOp(node, profileStart, node.backwardCost, ProfilePhase::Backward);
   }
 }
 
-NDArray NDArray::sum() {
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::sum() {
+  int64_t profileStart = _profileStart();
   // Create scalar output (shape {1}) participating in autograd
-  NDArray result({1}, "", "sum", {std::ref(*this)});
+  BasicNDArray result({1}, "", "sum", {std::ref(*this)});
 
   // Accumulate sum respecting strides (works for contiguous and views)
-  float total = 0.0f;
+  T total = T(0);
   if (isContiguous()) {
-    for (int i = 0; i < size; ++i) {
+    for (int64_t i = 0; i < size; ++i) {
       total += data[i];
     }
   } else {
-    std::vector<int> index(shape.size(), 0);
-    for (int i = 0; i < size; ++i) {
-      int offset = detail::_computeOffset(index, strides);
+    Shape index(shape.size(), 0);
+    for (int64_t i = 0; i < size; ++i) {
+      int64_t offset = detail::_computeOffset(index, strides);
       total += data[offset];
 
       for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
@@ -895,17 +4171,17 @@ NDArray NDArray::sum() {
   result.data[0] = total;
 
   // Backward: dA += 1 * dOut broadcasted to every element position
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  float upstreamScalar = 1.0f; // outGrad will be set by caller's backward
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  T upstreamScalar = T(1); // outGrad will be set by caller's backward
 
-  std::vector<int> shapeCopy = shape;
-  std::vector<int> stridesCopy = strides;
-  int sizeCopy = size;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  int64_t sizeCopy = size;
 
   result._backward = [aGradPtr, outGradPtr, upstreamScalar, shapeCopy,
                       stridesCopy, sizeCopy]() mutable {
-    float g = outGradPtr[0] * upstreamScalar;
+    T g = outGradPtr[0] * upstreamScalar;
     if (shapeCopy.empty()) {
       // Scalar input edge case (size == 1)
       aGradPtr[0] += g;
@@ -913,9 +4189,9 @@ NDArray NDArray::sum() {
     }
 
     // Iterate logical indices, accumulate into corresponding gradient slots
-    std::vector<int> index(shapeCopy.size(), 0);
-    for (int i = 0; i < sizeCopy; ++i) {
-      int off = detail::_computeOffset(index, stridesCopy);
+    Shape index(shapeCopy.size(), 0);
+    for (int64_t i = 0; i < sizeCopy; ++i) {
+      int64_t off = detail::_computeOffset(index, stridesCopy);
       aGradPtr[off] += g;
 
       for (int d = static_cast<int>(shapeCopy.size()) - 1; d >= 0; --d) {
@@ -927,16 +4203,22 @@ NDArray NDArray::sum() {
     }
   };
 
+  result.backwardCost = _cost<T>(size, size + 1, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, 1),
+             ProfilePhase::Forward);
+
   return result;
 }
 
-NDArray NDArray::sum(int axis) {
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::sum(int axis) {
+  int64_t profileStart = _profileStart();
   if (ndim == 0) {
     // Treat scalar as shape {1}
-    NDArray result({1}, "", "sum_axis", {std::ref(*this)});
+    BasicNDArray result({1}, "", "sum_axis", {std::ref(*this)});
     result.data[0] = data[0];
-    float *aGradPtr = this->grad;
-    float *outGradPtr = result.grad;
+    T *aGradPtr = this->grad;
+    T *outGradPtr = result.grad;
     result._backward = [aGradPtr, outGradPtr]() mutable {
       aGradPtr[0] += outGradPtr[0];
     };
@@ -951,96 +4233,610 @@ NDArray NDArray::sum(int axis) {
   }
 
   // Output shape: same dims but axis size becomes 1
-  std::vector<int> outShape = shape;
-  int reducedDim = outShape[ax];
+  Shape outShape = shape;
+  int64_t reducedDim = outShape[ax];
   outShape[ax] = 1;
 
-  NDArray result(outShape, "", "sum_axis", {std::ref(*this)});
+  BasicNDArray result(outShape, "", "sum_axis", {std::ref(*this)});
 
   // Compute outer (before axis), axis length, and inner (after axis) sizes
-  int outer = 1;
+  int64_t outer = 1;
   for (int i = 0; i < ax; ++i)
     outer *= shape[i];
-  int inner = 1;
+  int64_t inner = 1;
   for (int i = ax + 1; i < ndim; ++i)
     inner *= shape[i];
 
   // Strides for quick offset computation
-  std::vector<int> stridesCopy = strides;
+  Shape stridesCopy = strides;
 
   // We'll iterate over outer and inner positions; for each, sum along axis
-  for (int o = 0; o < outer; ++o) {
-    for (int in = 0; in < inner; ++in) {
+  for (int64_t o = 0; o < outer; ++o) {
+    for (int64_t in = 0; in < inner; ++in) {
       // Build base multi-index corresponding to this (o, in) position
       // Decode o to indices[0..ax-1], and in to indices[ax+1..]
-      std::vector<int> idx(ndim, 0);
-      int tmp = o;
+      Shape idx(ndim, 0);
+      int64_t tmp = o;
       for (int d = ax - 1; d >= 0; --d) {
-        int dimSize = shape[d];
+        int64_t dimSize = shape[d];
         idx[d] = tmp % dimSize;
         tmp /= dimSize;
       }
       tmp = in;
       for (int d = ndim - 1; d > ax; --d) {
-        int dimSize = shape[d];
+        int64_t dimSize = shape[d];
         idx[d] = tmp % dimSize;
         tmp /= dimSize;
       }
 
       // Sum along axis at this base position
-      float accum = 0.0f;
-      for (int a = 0; a < reducedDim; ++a) {
+      T accum = T(0);
+      for (int64_t a = 0; a < reducedDim; ++a) {
         idx[ax] = a;
-        int off = detail::_computeOffset(idx, stridesCopy);
+        int64_t off = detail::_computeOffset(idx, stridesCopy);
         accum += data[off];
       }
 
       // Write to output at corresponding location (axis index forced to 0)
       idx[ax] = 0;
-      int outOff = detail::_computeOffset(idx, result.strides);
+      int64_t outOff = detail::_computeOffset(idx, result.strides);
       result.data[outOff] = accum;
     }
   }
 
   // Backward: each input position along reduced axis receives upstream grad
-  float *aGradPtr = this->grad;
-  float *outGradPtr = result.grad;
-  std::vector<int> shapeCopy = shape;
-  std::vector<int> outStridesCopy = result.strides;
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  Shape shapeCopy = shape;
+  Shape outStridesCopy = result.strides;
 
   result._backward = [aGradPtr, outGradPtr, stridesCopy, outStridesCopy,
                       shapeCopy, ax, reducedDim, outer, inner]() mutable {
     // For each outer/inner location, distribute output grad to all axis slots
-    std::vector<int> idx(shapeCopy.size(), 0);
-    for (int o = 0; o < outer; ++o) {
-      int tmp = o;
+    Shape idx(shapeCopy.size(), 0);
+    for (int64_t o = 0; o < outer; ++o) {
+      int64_t tmp = o;
       for (int d = ax - 1; d >= 0; --d) {
-        int dimSize = shapeCopy[d];
+        int64_t dimSize = shapeCopy[d];
         idx[d] = tmp % dimSize;
         tmp /= dimSize;
       }
-      for (int in = 0; in < inner; ++in) {
-        int tmp2 = in;
+      for (int64_t in = 0; in < inner; ++in) {
+        int64_t tmp2 = in;
         for (int d = static_cast<int>(shapeCopy.size()) - 1; d > ax; --d) {
-          int dimSize = shapeCopy[d];
+          int64_t dimSize = shapeCopy[d];
           idx[d] = tmp2 % dimSize;
           tmp2 /= dimSize;
         }
 
         // Read upstream grad at output position (axis fixed to 0)
         idx[ax] = 0;
-        int outOff = detail::_computeOffset(idx, outStridesCopy);
-        float g = outGradPtr[outOff];
+        int64_t outOff = detail::_computeOffset(idx, outStridesCopy);
+        T g = outGradPtr[outOff];
 
         // Distribute to all input positions along axis
-        for (int a = 0; a < reducedDim; ++a) {
+        for (int64_t a = 0; a < reducedDim; ++a) {
           idx[ax] = a;
-          int inOff = detail::_computeOffset(idx, stridesCopy);
+          int64_t inOff = detail::_computeOffset(idx, stridesCopy);
           aGradPtr[inOff] += g;
         }
       }
     }
   };
 
+  result.backwardCost = _cost<T>(size, size + result.size, size);
+  _profileOp(result, profileStart, _cost<T>(size, size, result.size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::softmaxAlong(int axis, bool logarithm) {
+  std::string name = logarithm ? "logSoftmax" : "softmax";
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(name +
+                             "() requires a floating point element type.");
+  } else {
+    int64_t profileStart = _profileStart();
+    int ax = axis < 0 ? axis + ndim : axis;
+    if (ndim == 0 || ax < 0 || ax >= ndim) {
+      throw std::invalid_argument("Axis out of range in " + name + "(axis)");
+    }
+
+    BasicNDArray result(shape, "", logarithm ? "log_softmax" : "softmax",
+                        {std::ref(*this)});
+    AxisRows layout = _axisRows(shape, ax);
+    bool contiguous = isContiguous();
+    if (contiguous) {
+      _softmaxRows(data, result.data, layout, logarithm);
+    } else {
+      _gatherStrided(data, shape, strides, size, result.data);
+      _softmaxRows(result.data, result.data, layout, logarithm);
+    }
+
+    // Backward needs only the output and dOut of each row
+    T *aGradPtr = this->grad;
+    T *outDataPtr = result.data;
+    T *outGradPtr = result.grad;
+    int64_t outSize = result.size;
+    Shape shapeCopy = shape;
+    Shape stridesCopy = strides;
+    result._backward = [aGradPtr, outDataPtr, outGradPtr, outSize, shapeCopy,
+                        stridesCopy, layout, contiguous, logarithm]() {
+      if (contiguous) {
+        _softmaxBackwardRows(outDataPtr, outGradPtr, aGradPtr, layout,
+                             logarithm);
+        return;
+      }
+      std::vector<T> aGrad(outSize, T(0));
+      _softmaxBackwardRows(outDataPtr, outGradPtr, aGrad.data(), layout,
+                           logarithm);
+      _scatterAddStrided(aGrad.data(), shapeCopy, stridesCopy, outSize,
+                         aGradPtr);
+    };
+
+    result.backwardCost = _cost<T>(4 * size, 3 * size, size);
+    _profileOp(result, profileStart, _cost<T>(5 * size, 2 * size, size),
+               ProfilePhase::Forward);
+
+    return result;
+  }
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::softmax(int axis) {
+  return softmaxAlong(axis, false);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::logSoftmax(int axis) {
+  return softmaxAlong(axis, true);
+}
+
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::crossEntropy(const BasicNDArray<int64_t> &targets) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    throw std::runtime_error(
+        "crossEntropy() requires a floating point element type.");
+  } else {
+    int64_t profileStart = _profileStart();
+    if (ndim == 0) {
+      throw std::invalid_argument(
+          "crossEntropy() requires logits with a class axis.");
+    }
+    AxisRows layout = _axisRows(shape, ndim - 1);
+    int64_t rows = layout.rows;
+    int64_t classCount = layout.length;
+    if (targets.size != rows) {
+      throw std::invalid_argument(
+          "crossEntropy() requires one target per row of logits.");
+    }
+
+    // Class indices, validated before any work
+    std::vector<int64_t> classes(rows);
+    if (targets.isContiguous())
+      std::copy(targets.data, targets.data + rows, classes.begin());
+    else
+      _gatherStrided(targets.data, targets.shape, targets.strides, rows,
+                     classes.data());
+    for (int64_t c : classes) {
+      if (c < 0 || c >= classCount)
+        throw std::out_of_range("Target class out of range in crossEntropy.");
+    }
+
+    bool contiguous = isContiguous();
+    std::vector<T> gathered;
+    const T *logits = data;
+    if (!contiguous) {
+      gathered.resize(size);
+      _gatherStrided(data, shape, strides, size, gathered.data());
+      logits = gathered.data();
+    }
+
+    // loss(row) = logsumexp(row) - row[target]
+    std::vector<T> logSumExp(rows);
+    std::vector<T> losses(rows);
+#pragma omp parallel for schedule(static)                                      \
+    if (rows > 1 && size >= kParallelElements)
+    for (int64_t r = 0; r < rows; ++r) {
+      const T *row = logits + r * classCount;
+      T max, sum;
+      _rowMaxSum(row, classCount, max, sum);
+      logSumExp[r] = max + std::log(sum);
+      losses[r] = logSumExp[r] - row[classes[r]];
+    }
+
+    // Summed in row order, so the loss does not depend on the thread count
+    double total = 0.0;
+    for (T loss : losses)
+      total += loss;
+
+    BasicNDArray result({1}, "", "cross_entropy", {std::ref(*this)});
+    result.data[0] = static_cast<T>(total / static_cast<double>(rows));
+
+    // Backward: dA += (exp(a - logsumexp) - onehot) * dOut / rows
+    T *aDataPtr = this->data;
+    T *aGradPtr = this->grad;
+    T *outGradPtr = result.grad;
+    Shape shapeCopy = shape;
+    Shape stridesCopy = strides;
+    result._backward = [aDataPtr, aGradPtr, outGradPtr, shapeCopy,
+                        stridesCopy, contiguous, rows, classCount, classes,
+                        logSumExp]() {
+      int64_t count = rows * classCount;
+      const T *x = aDataPtr;
+      T *dA = aGradPtr;
+      std::vector<T> gatheredX;
+      std::vector<T> gatheredGrad;
+      if (!contiguous) {
+        gatheredX.resize(count);
+        _gatherStrided(aDataPtr, shapeCopy, stridesCopy, count,
+                       gatheredX.data());
+        gatheredGrad.assign(count, T(0));
+        x = gatheredX.data();
+        dA = gatheredGrad.data();
+      }
+
+      T scale = outGradPtr[0] / static_cast<T>(rows);
+#pragma omp parallel for schedule(static)                                      \
+    if (rows > 1 && count >= kParallelElements)
+      for (int64_t r = 0; r < rows; ++r) {
+        const T *row = x + r * classCount;
+        T *gradRow = dA + r * classCount;
+        T shift = logSumExp[r];
+        for (int64_t j = 0; j < classCount; ++j)
+          gradRow[j] += scale * _exp<T, false>(row[j] - shift);
+        gradRow[classes[r]] -= scale;
+      }
+
+      if (!contiguous)
+        _scatterAddStrided(dA, shapeCopy, stridesCopy, count, aGradPtr);
+    };
+
+    result.backwardCost = _cost<T>(3 * size, size, size);
+    _profileOp(result, profileStart, _cost<T>(4 * size, size + rows, 1),
+               ProfilePhase::Forward);
+
+    return result;
+  }
+}
+
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::selectAlong(const std::string &opName,
+                             const std::string &opTag, int axis,
+                             const BasicNDArray<int64_t> &indices,
+                             Shape outShape) {
+  int64_t profileStart = _profileStart();
+  std::vector<int64_t> picks = _indexList(indices, shape[axis], opName);
+  int64_t count = static_cast<int64_t>(picks.size());
+  int64_t length = shape[axis];
+  int64_t outer = 1;
+  int64_t inner = 1;
+  for (int d = 0; d < ndim; ++d) {
+    if (d < axis)
+      outer *= shape[d];
+    else if (d > axis)
+      inner *= shape[d];
+  }
+
+  BasicNDArray result(outShape, "", opTag, {std::ref(*this)});
+  bool contiguous = isContiguous();
+  int64_t blocks = outer * count;
+  if (contiguous) {
+    // One contiguous slice of `inner` elements per (outer, position)
+    const T *src = data;
+    T *dst = result.data;
+#pragma omp parallel for schedule(static)                                      \
+    if (blocks > 1 && result.size >= kParallelElements)
+    for (int64_t b = 0; b < blocks; ++b) {
+      int64_t o = b / count;
+      const T *slice = src + (o * length + picks[b % count]) * inner;
+      std::copy(slice, slice + inner, dst + b * inner);
+    }
+  } else {
+    Shape selected = shape;
+    selected[axis] = count;
+    Shape index(ndim, 0);
+    for (int64_t i = 0; i < result.size; ++i) {
+      int64_t offset = 0;
+      for (int d = 0; d < ndim; ++d)
+        offset += (d == axis ? picks[index[d]] : index[d]) * strides[d];
+      result.data[i] = data[offset];
+
+      for (int dim = ndim - 1; dim >= 0; --dim) {
+        index[dim]++;
+        if (index[dim] < selected[dim])
+          break;
+        index[dim] = 0;
+      }
+    }
+  }
+
+  // Backward writes only the selected slices of the grad: each distinct
+  // index sums its positions in order, one index per thread
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  int dims = ndim;
+  result._backward = [aGradPtr, outGradPtr, shapeCopy, stridesCopy, dims,
+                      axis, picks, contiguous, count, length, outer, inner]() {
+    if (!contiguous) {
+      Shape selected = shapeCopy;
+      selected[axis] = count;
+      Shape index(dims, 0);
+      int64_t total = outer * count * inner;
+      for (int64_t i = 0; i < total; ++i) {
+        int64_t offset = 0;
+        for (int d = 0; d < dims; ++d)
+          offset += (d == axis ? picks[index[d]] : index[d]) * stridesCopy[d];
+        aGradPtr[offset] += outGradPtr[i];
+
+        for (int dim = dims - 1; dim >= 0; --dim) {
+          index[dim]++;
+          if (index[dim] < selected[dim])
+            break;
+          index[dim] = 0;
+        }
+      }
+      return;
+    }
+
+    IndexSegments groups = _segmentIndices(picks);
+    int64_t uniqueCount = static_cast<int64_t>(groups.unique.size());
+#pragma omp parallel for schedule(static)                                      \
+    if (uniqueCount > 1 && outer * count * inner >= kParallelElements)
+    for (int64_t u = 0; u < uniqueCount; ++u) {
+      for (int64_t o = 0; o < outer; ++o) {
+        T *dst = aGradPtr + (o * length + groups.unique[u]) * inner;
+        for (int64_t s = groups.segments[u]; s < groups.segments[u + 1]; ++s) {
+          const T *src = outGradPtr + (o * count + groups.order[s]) * inner;
+          for (int64_t i = 0; i < inner; ++i)
+            dst[i] += src[i];
+        }
+      }
+    }
+  };
+
+  result.backwardCost = _cost<T>(result.size, 2 * result.size, result.size);
+  _profileOp(result, profileStart, _cost<T>(0, result.size, result.size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::indexSelect(int axis, const BasicNDArray<int64_t> &indices) {
+  int ax = axis < 0 ? axis + ndim : axis;
+  if (ndim == 0 || ax < 0 || ax >= ndim) {
+    throw std::invalid_argument("Axis out of range in indexSelect(axis)");
+  }
+  Shape outShape = shape;
+  outShape[ax] = indices.size;
+  return selectAlong("indexSelect", "index_select", ax, indices, outShape);
+}
+
+template <typename T>
+BasicNDArray<T>
+BasicNDArray<T>::embedding(const BasicNDArray<int64_t> &indices) {
+  if (ndim == 0) {
+    throw std::invalid_argument("embedding() requires a table with rows.");
+  }
+  Shape outShape = indices.shape;
+  for (int d = 1; d < ndim; ++d)
+    outShape.push_back(shape[d]);
+  return selectAlong("embedding", "embedding", 0, indices, outShape);
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::gather(int axis,
+                                        const BasicNDArray<int64_t> &index) {
+  int64_t profileStart = _profileStart();
+  int ax = axis < 0 ? axis + ndim : axis;
+  if (ndim == 0 || ax < 0 || ax >= ndim) {
+    throw std::invalid_argument("Axis out of range in gather(axis)");
+  }
+  if (index.ndim != ndim) {
+    throw std::invalid_argument(
+        "gather() requires an index with the rank of the input.");
+  }
+  for (int d = 0; d < ndim; ++d) {
+    if (d != ax && index.shape[d] > shape[d])
+      throw std::invalid_argument(
+          "gather() index is larger than the input on axis " +
+          std::to_string(d));
+  }
+  std::vector<int64_t> picks = _indexList(index, shape[ax], "gather");
+
+  // The result and the packed index share the row-major layout of `index`
+  BasicNDArray result(index.shape, "", "gather", {std::ref(*this)});
+  Shape indexStrides = detail::_computeStrides(index.shape);
+  int64_t count = index.shape[ax];
+  int64_t fibers = count > 0 ? index.size / count : 0;
+  const T *src = data;
+  T *dst = result.data;
+  Shape indexShape = index.shape;
+  Shape stridesCopy = strides;
+#pragma omp parallel for schedule(static)                                      \
+    if (fibers > 1 && result.size >= kParallelElements)
+  for (int64_t f = 0; f < fibers; ++f) {
+    int64_t outBase = _fiberOffset(f, indexShape, ax, indexStrides);
+    int64_t srcBase = _fiberOffset(f, indexShape, ax, stridesCopy);
+    for (int64_t j = 0; j < count; ++j) {
+      int64_t pos = outBase + j * indexStrides[ax];
+      dst[pos] = src[srcBase + picks[pos] * stridesCopy[ax]];
+    }
+  }
+
+  // Backward: fibers write disjoint elements unless the input aliases
+  // itself (expanded axes), which runs serially
+  T *aGradPtr = this->grad;
+  T *outGradPtr = result.grad;
+  bool parallel = isContiguous();
+  result._backward = [aGradPtr, outGradPtr, indexShape, indexStrides,
+                      stridesCopy, ax, picks, count, fibers, parallel]() {
+#pragma omp parallel for schedule(static)                                      \
+    if (parallel && fibers > 1 && fibers * count >= kParallelElements)
+    for (int64_t f = 0; f < fibers; ++f) {
+      int64_t outBase = _fiberOffset(f, indexShape, ax, indexStrides);
+      int64_t gradBase = _fiberOffset(f, indexShape, ax, stridesCopy);
+      for (int64_t j = 0; j < count; ++j) {
+        int64_t pos = outBase + j * indexStrides[ax];
+        aGradPtr[gradBase + picks[pos] * stridesCopy[ax]] += outGradPtr[pos];
+      }
+    }
+  };
+
+  result.backwardCost = _cost<T>(result.size, 2 * result.size, result.size);
+  _profileOp(result, profileStart, _cost<T>(0, result.size, result.size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::scatterAdd(int axis,
+                                            const BasicNDArray<int64_t> &index,
+                                            BasicNDArray &src) {
+  int64_t profileStart = _profileStart();
+  int ax = axis < 0 ? axis + ndim : axis;
+  if (ndim == 0 || ax < 0 || ax >= ndim) {
+    throw std::invalid_argument("Axis out of range in scatterAdd(axis)");
+  }
+  if (index.ndim != ndim || src.ndim != ndim) {
+    throw std::invalid_argument(
+        "scatterAdd() requires index and src with the rank of the input.");
+  }
+  for (int d = 0; d < ndim; ++d) {
+    if (index.shape[d] > src.shape[d] ||
+        (d != ax && index.shape[d] > shape[d]))
+      throw std::invalid_argument(
+          "scatterAdd() index is larger than src or the input on axis " +
+          std::to_string(d));
+  }
+  std::vector<int64_t> picks = _indexList(index, shape[ax], "scatterAdd");
+
+  BasicNDArray result(shape, "", "scatter_add",
+                      {std::ref(*this), std::ref(src)});
+  if (isContiguous())
+    std::copy(data, data + size, result.data);
+  else
+    _gatherStrided(data, shape, strides, size, result.data);
+
+  // Each fiber of `index` adds into its own fiber of the result, in index
+  // order, so the sums do not depend on the thread count
+  Shape indexShape = index.shape;
+  Shape indexStrides = detail::_computeStrides(index.shape);
+  Shape outStrides = result.strides;
+  Shape srcStrides = src.strides;
+  int64_t count = index.shape[ax];
+  int64_t fibers = count > 0 ? index.size / count : 0;
+  const T *srcData = src.data;
+  T *dst = result.data;
+#pragma omp parallel for schedule(static)                                      \
+    if (fibers > 1 && index.size >= kParallelElements)
+  for (int64_t f = 0; f < fibers; ++f) {
+    int64_t indexBase = _fiberOffset(f, indexShape, ax, indexStrides);
+    int64_t outBase = _fiberOffset(f, indexShape, ax, outStrides);
+    int64_t srcBase = _fiberOffset(f, indexShape, ax, srcStrides);
+    for (int64_t j = 0; j < count; ++j) {
+      int64_t pos = indexBase + j * indexStrides[ax];
+      dst[outBase + picks[pos] * outStrides[ax]] +=
+          srcData[srcBase + j * srcStrides[ax]];
+    }
+  }
+
+  // Backward: dThis += dOut; dSrc gathers dOut at the scattered positions
+  T *aGradPtr = this->grad;
+  T *srcGradPtr = src.grad;
+  T *outGradPtr = result.grad;
+  Shape shapeCopy = shape;
+  Shape stridesCopy = strides;
+  bool contiguous = isContiguous();
+  bool parallel = src.isContiguous();
+  int64_t total = size;
+  result._backward = [aGradPtr, srcGradPtr, outGradPtr, shapeCopy,
+                      stridesCopy, contiguous, total, indexShape,
+                      indexStrides, outStrides, srcStrides, ax, picks, count,
+                      fibers, parallel]() {
+    if (contiguous) {
+      for (int64_t i = 0; i < total; ++i)
+        aGradPtr[i] += outGradPtr[i];
+    } else {
+      _scatterAddStrided(outGradPtr, shapeCopy, stridesCopy, total, aGradPtr);
+    }
+
+#pragma omp parallel for schedule(static)                                      \
+    if (parallel && fibers > 1 && fibers * count >= kParallelElements)
+    for (int64_t f = 0; f < fibers; ++f) {
+      int64_t indexBase = _fiberOffset(f, indexShape, ax, indexStrides);
+      int64_t outBase = _fiberOffset(f, indexShape, ax, outStrides);
+      int64_t srcBase = _fiberOffset(f, indexShape, ax, srcStrides);
+      for (int64_t j = 0; j < count; ++j) {
+        int64_t pos = indexBase + j * indexStrides[ax];
+        srcGradPtr[srcBase + j * srcStrides[ax]] +=
+            outGradPtr[outBase + picks[pos] * outStrides[ax]];
+      }
+    }
+  };
+
+  int64_t scattered = fibers * count;
+  result.backwardCost =
+      _cost<T>(size + scattered, size + scattered, size + scattered);
+  _profileOp(result, profileStart,
+             _cost<T>(scattered, size + 2 * scattered, size),
+             ProfilePhase::Forward);
+
+  return result;
+}
+
+template <typename T>
+template <typename U>
+BasicNDArray<U> BasicNDArray<T>::astype() const {
+  BasicNDArray<U> result(shape);
+
+  if (isContiguous()) {
+    for (int64_t i = 0; i < size; ++i) {
+      result.data[i] = static_cast<U>(data[i]);
+    }
+  } else {
+    Shape index(shape.size(), 0);
+    for (int64_t i = 0; i < result.size; ++i) {
+      int64_t offset = detail::_computeOffset(index, strides);
+      result.data[i] = static_cast<U>(data[offset]);
+
+      for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
+        index[dim]++;
+        if (index[dim] < shape[dim])
+          break;
+        index[dim] = 0;
+      }
+    }
+  }
+
   return result;
 }
+
+// Explicit instantiations: every kernel above is compiled once per supported
+// element type, and astype() for every (source, target) pair.
+template class BasicNDArray<float>;
+template class BasicNDArray<double>;
+template class BasicNDArray<int32_t>;
+template class BasicNDArray<int64_t>;
+
+#define INCLIARRAY_INSTANTIATE_ASTYPE(T)                                       \
+  template BasicNDArray<float> BasicNDArray<T>::astype<float>() const;         \
+  template BasicNDArray<double> BasicNDArray<T>::astype<double>() const;       \
+  template BasicNDArray<int32_t> BasicNDArray<T>::astype<int32_t>() const;     \
+  template BasicNDArray<int64_t> BasicNDArray<T>::astype<int64_t>() const;
+
+INCLIARRAY_INSTANTIATE_ASTYPE(float)
+INCLIARRAY_INSTANTIATE_ASTYPE(double)
+INCLIARRAY_INSTANTIATE_ASTYPE(int32_t)
+INCLIARRAY_INSTANTIATE_ASTYPE(int64_t)
+
+#undef INCLIARRAY_INSTANTIATE_ASTYPE
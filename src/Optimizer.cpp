@@ -0,0 +1,272 @@
+#include "../include/Optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace {
+// Elements per chunk: large enough to amortize scheduling, small enough that
+// a few chunks of params, grads and state stay in L2
+constexpr int64_t kChunkElements = 1 << 14;
+// Below this many parameter elements the update runs on one thread
+constexpr int64_t kParallelElements = 1 << 15;
+
+// Sum of squares with 8 double lanes combined in a fixed order, so a chunk
+// always reduces to the same value
+double _sumSquares(const float *values, int64_t n) {
+  double lanes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    for (int j = 0; j < 8; ++j) {
+      double v = values[i + j];
+      lanes[j] += v * v;
+    }
+  }
+  for (; i < n; ++i) {
+    double v = values[i];
+    lanes[0] += v * v;
+  }
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+         ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+// Grad multiplier bringing a global norm down to maxNorm
+float _clipScale(float norm, float maxNorm) {
+  float scale = maxNorm / (norm + 1e-6f);
+  return scale < 1.0f ? scale : 1.0f;
+}
+
+void _scale(float *values, int64_t n, float factor) {
+  for (int64_t i = 0; i < n; ++i) {
+    values[i] *= factor;
+  }
+}
+
+// SGD update of n elements; `buf` is null without momentum. Hyperparameters
+// are passed by value so the compiler knows stores to p cannot change them.
+void _sgdUpdate(float *p, const float *g, float *buf, int64_t n, float scale,
+                float lr, float momentum, float weightDecay, bool nesterov) {
+  if (buf == nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      p[i] -= lr * (g[i] * scale + weightDecay * p[i]);
+    }
+  } else if (nesterov) {
+    for (int64_t i = 0; i < n; ++i) {
+      float d = g[i] * scale + weightDecay * p[i];
+      float b = momentum * buf[i] + d;
+      buf[i] = b;
+      p[i] -= lr * (d + momentum * b);
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      float b = momentum * buf[i] + (g[i] * scale + weightDecay * p[i]);
+      buf[i] = b;
+      p[i] -= lr * b;
+    }
+  }
+}
+
+// Adam update of n elements: moments, bias correction and weight decay
+// (l2 added to the gradient, or the parameter shrunk by `decay`)
+void _adamUpdate(float *p, const float *g, float *m, float *v, int64_t n,
+                 float scale, float beta1, float beta2, float eps, float l2,
+                 float decay, float stepSize, float rsqrtCorrection2) {
+  for (int64_t i = 0; i < n; ++i) {
+    float d = g[i] * scale + l2 * p[i];
+    float mi = beta1 * m[i] + (1.0f - beta1) * d;
+    float vi = beta2 * v[i] + (1.0f - beta2) * d * d;
+    m[i] = mi;
+    v[i] = vi;
+    p[i] = p[i] * decay -
+           stepSize * mi / (std::sqrt(vi) * rsqrtCorrection2 + eps);
+  }
+}
+
+void _checkNonNegative(float value, const char *name) {
+  if (!(value >= 0.0f)) {
+    throw std::invalid_argument(std::string(name) +
+                                " must be non-negative, got " +
+                                std::to_string(value));
+  }
+}
+
+void _checkOptions(const SGDOptions &options) {
+  _checkNonNegative(options.lr, "Learning rate");
+  _checkNonNegative(options.momentum, "Momentum");
+  _checkNonNegative(options.weightDecay, "Weight decay");
+  _checkNonNegative(options.maxGradNorm, "Max grad norm");
+  if (options.nesterov && options.momentum == 0.0f) {
+    throw std::invalid_argument("Nesterov momentum requires momentum > 0.");
+  }
+}
+
+void _checkOptions(const AdamOptions &options) {
+  _checkNonNegative(options.lr, "Learning rate");
+  _checkNonNegative(options.eps, "Epsilon");
+  _checkNonNegative(options.weightDecay, "Weight decay");
+  _checkNonNegative(options.maxGradNorm, "Max grad norm");
+  if (!(options.beta1 >= 0.0f && options.beta1 < 1.0f) ||
+      !(options.beta2 >= 0.0f && options.beta2 < 1.0f)) {
+    throw std::invalid_argument("Adam betas must be in [0, 1).");
+  }
+}
+} // namespace
+
+Optimizer::Optimizer(std::vector<std::reference_wrapper<NDArray>> inputParams)
+    : params(std::move(inputParams)) {
+  std::unordered_set<const NDArray *> seen;
+  for (int t = 0; t < static_cast<int>(params.size()); ++t) {
+    const NDArray &param = params[t];
+    if (!param.isContiguous()) {
+      throw std::invalid_argument("Optimizer parameter " + std::to_string(t) +
+                                  " is not contiguous.");
+    }
+    if (!seen.insert(&param).second) {
+      throw std::invalid_argument("Optimizer parameter " + std::to_string(t) +
+                                  " is listed more than once.");
+    }
+
+    for (int64_t begin = 0; begin < param.size; begin += kChunkElements) {
+      int64_t count = std::min(kChunkElements, param.size - begin);
+      chunks.push_back({t, begin, count, totalSize + begin});
+    }
+    totalSize += param.size;
+  }
+}
+
+void Optimizer::prepare() {
+  for (NDArray &param : params) {
+    param.ensureUnique();
+  }
+}
+
+void Optimizer::forEachChunk(
+    const std::function<void(const Chunk &)> &kernel) const {
+  int64_t count = static_cast<int64_t>(chunks.size());
+#pragma omp parallel for schedule(static)                                      \
+    if (count > 1 && totalSize >= kParallelElements)
+  for (int64_t c = 0; c < count; ++c) {
+    kernel(chunks[c]);
+  }
+}
+
+void Optimizer::zeroGrad() {
+  forEachChunk([this](const Chunk &chunk) {
+    float *grad = params[chunk.tensor].get().grad + chunk.begin;
+    std::fill(grad, grad + chunk.count, 0.0f);
+  });
+}
+
+float Optimizer::gradNorm() const {
+  // One partial per chunk, summed in chunk order
+  std::vector<double> partials(chunks.size());
+  forEachChunk([&](const Chunk &chunk) {
+    const float *grad = params[chunk.tensor].get().grad + chunk.begin;
+    partials[&chunk - chunks.data()] = _sumSquares(grad, chunk.count);
+  });
+
+  double total = 0.0;
+  for (double partial : partials) {
+    total += partial;
+  }
+  return static_cast<float>(std::sqrt(total));
+}
+
+float Optimizer::clipScale(float maxNorm) const {
+  return maxNorm > 0.0f ? _clipScale(gradNorm(), maxNorm) : 1.0f;
+}
+
+float Optimizer::clipGradNorm(float maxNorm) {
+  if (!(maxNorm > 0.0f)) {
+    throw std::invalid_argument("Max grad norm must be positive, got " +
+                                std::to_string(maxNorm));
+  }
+
+  float norm = gradNorm();
+  float scale = _clipScale(norm, maxNorm);
+  if (scale < 1.0f) {
+    forEachChunk([&](const Chunk &chunk) {
+      _scale(params[chunk.tensor].get().grad + chunk.begin, chunk.count,
+             scale);
+    });
+  }
+  return norm;
+}
+
+SGD::SGD(std::vector<std::reference_wrapper<NDArray>> inputParams,
+         SGDOptions inputOptions)
+    : Optimizer(std::move(inputParams)), options(inputOptions) {
+  _checkOptions(options);
+}
+
+void SGD::step() {
+  _checkOptions(options);
+  prepare();
+
+  const float scale = clipScale(options.maxGradNorm);
+  const float lr = options.lr;
+  const float momentum = options.momentum;
+  const float weightDecay = options.weightDecay;
+  const bool nesterov = options.nesterov;
+
+  // A zero buffer makes the first step buf = g, as without one
+  if (momentum > 0.0f && momentumBuffer.empty()) {
+    momentumBuffer.assign(totalSize, 0.0f);
+  }
+  float *buffer = momentumBuffer.data();
+
+  forEachChunk([&](const Chunk &chunk) {
+    NDArray &param = params[chunk.tensor];
+    float *buf = momentum > 0.0f ? buffer + chunk.state : nullptr;
+    _sgdUpdate(param.data + chunk.begin, param.grad + chunk.begin, buf,
+               chunk.count, scale, lr, momentum, weightDecay, nesterov);
+  });
+  ++steps;
+}
+
+Adam::Adam(std::vector<std::reference_wrapper<NDArray>> inputParams,
+           AdamOptions inputOptions)
+    : Adam(std::move(inputParams), inputOptions, false) {}
+
+Adam::Adam(std::vector<std::reference_wrapper<NDArray>> inputParams,
+           AdamOptions inputOptions, bool inputDecoupled)
+    : Optimizer(std::move(inputParams)), options(inputOptions),
+      decoupled(inputDecoupled), firstMoment(totalSize, 0.0f),
+      secondMoment(totalSize, 0.0f) {
+  _checkOptions(options);
+}
+
+void Adam::step() {
+  _checkOptions(options);
+  prepare();
+  ++steps;
+
+  const float scale = clipScale(options.maxGradNorm);
+  const float beta1 = options.beta1;
+  const float beta2 = options.beta2;
+  const float eps = options.eps;
+  // Weight decay either joins the gradient (Adam) or shrinks the parameter
+  // directly (AdamW)
+  const float l2 = decoupled ? 0.0f : options.weightDecay;
+  const float decay = decoupled ? 1.0f - options.lr * options.weightDecay
+                                : 1.0f;
+  const double correction1 = 1.0 - std::pow(double(beta1), double(steps));
+  const double correction2 = 1.0 - std::pow(double(beta2), double(steps));
+  const float stepSize = static_cast<float>(options.lr / correction1);
+  const float rsqrtCorrection2 =
+      static_cast<float>(1.0 / std::sqrt(correction2));
+
+  float *mBase = firstMoment.data();
+  float *vBase = secondMoment.data();
+  forEachChunk([&](const Chunk &chunk) {
+    NDArray &param = params[chunk.tensor];
+    _adamUpdate(param.data + chunk.begin, param.grad + chunk.begin,
+                mBase + chunk.state, vBase + chunk.state, chunk.count, scale,
+                beta1, beta2, eps, l2, decay, stepSize, rsqrtCorrection2);
+  });
+}
+
+AdamW::AdamW(std::vector<std::reference_wrapper<NDArray>> inputParams,
+             AdamOptions inputOptions)
+    : Adam(std::move(inputParams), inputOptions, true) {}
@@ -0,0 +1,441 @@
+#include "../include/OutOfCoreNDArray.h"
+#include "./npy.h"
+#include "./utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// Unique file name in the system temp directory for intermediate results
+std::string _temporaryPath() {
+  static std::mt19937_64 engine(std::random_device{}());
+  std::ostringstream name;
+  name << "incliarray-" << std::hex << engine() << ".npy";
+  return (std::filesystem::temp_directory_path() / name.str()).string();
+}
+
+// Rows per tile so that one tile of `rowElements` floats fits `tileBytes`
+int64_t _rowsPerTile(size_t rowElements, size_t tileBytes) {
+  size_t rowBytes = std::max<size_t>(1, rowElements) * sizeof(float);
+  return static_cast<int64_t>(std::max<size_t>(1, tileBytes / rowBytes));
+}
+} // namespace
+
+// Streams consecutive row tiles of an array, reading tile t + 1 on a
+// background thread while tile t is computed on. A tile returned by next()
+// stays valid until the following call.
+class OutOfCoreTileReader {
+public:
+  OutOfCoreTileReader(const OutOfCoreNDArray &array, int64_t rowsPerTile)
+      : array(array), rowsPerTile(rowsPerTile) {
+    size_t capacity = static_cast<size_t>(rowsPerTile) * array.rowElements;
+    buffers[0].resize(capacity);
+    buffers[1].resize(capacity);
+    tiles = (array.shape[0] + rowsPerTile - 1) / rowsPerTile;
+    if (tiles > 0)
+      pending = prefetch(0);
+  }
+
+  ~OutOfCoreTileReader() {
+    if (pending.valid())
+      pending.wait();
+  }
+
+  NDArray next() {
+    if (current >= tiles)
+      throw std::out_of_range("No more tiles to read.");
+
+    pending.get();
+    int64_t tile = current++;
+    if (current < tiles)
+      pending = prefetch(current);
+
+    int64_t row0 = tile * rowsPerTile;
+    int64_t rows = std::min(rowsPerTile, array.shape[0] - row0);
+    return NDArray::fromBuffer(buffers[tile % 2].data(), array.tileShape(rows));
+  }
+
+private:
+  std::future<void> prefetch(int64_t tile) {
+    int64_t row0 = tile * rowsPerTile;
+    int64_t rows = std::min(rowsPerTile, array.shape[0] - row0);
+    float *dst = buffers[tile % 2].data();
+    const OutOfCoreNDArray *source = &array;
+    return std::async(std::launch::async, [source, row0, rows, dst]() {
+      source->readRows(row0, rows, dst);
+    });
+  }
+
+  const OutOfCoreNDArray &array;
+  int64_t rowsPerTile;
+  int64_t tiles = 0;
+  int64_t current = 0;
+  std::vector<float> buffers[2];
+  std::future<void> pending;
+};
+
+OutOfCoreNDArray OutOfCoreNDArray::create(const std::string &inputPath,
+                                          std::vector<int64_t> inputShape,
+                                          size_t tileBytes) {
+  if (inputShape.empty()) {
+    throw std::invalid_argument(
+        "Out-of-core arrays need at least one dimension.");
+  }
+
+  OutOfCoreNDArray result;
+  result.shape = inputShape;
+  result.strides = detail::_computeStrides(inputShape);
+  result.ndim = inputShape.size();
+  result.size = 1;
+  for (int64_t dim : inputShape)
+    result.size *= dim;
+  result.rowElements = inputShape[0] > 0 ? result.size / inputShape[0] : 1;
+  result.tileRows = _rowsPerTile(result.rowElements, tileBytes);
+  result.tileBytes = tileBytes;
+  result.path = inputPath.empty() ? _temporaryPath() : inputPath;
+
+  if (inputPath.empty()) {
+    result.fileOwner = std::shared_ptr<std::string>(
+        new std::string(result.path), [](std::string *file) {
+          std::error_code ignored;
+          std::filesystem::remove(*file, ignored);
+          delete file;
+        });
+  }
+
+  std::string header = detail::_buildNpyHeader("<f4", inputShape);
+  {
+    std::ofstream out(result.path, std::ios::binary | std::ios::trunc);
+    if (!out)
+      throw std::runtime_error("Could not create '" + result.path + "'.");
+    out.write(header.data(), header.size());
+  }
+  result.dataOffset = header.size();
+
+  // Extend to full size without writing: the payload reads back as zeros
+  std::filesystem::resize_file(result.path,
+                               result.dataOffset +
+                                   static_cast<uintmax_t>(result.size) *
+                                       sizeof(float));
+  return result;
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::open(const std::string &inputPath,
+                                        size_t tileBytes) {
+  std::ifstream in(inputPath, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Could not open '" + inputPath + "'.");
+
+  detail::NpyHeader header = detail::_readNpyHeader(in);
+  if (header.descr != "<f4" || header.fortranOrder) {
+    throw std::invalid_argument(
+        "Out-of-core arrays require C-ordered '<f4' files, got '" +
+        header.descr + "'.");
+  }
+
+  OutOfCoreNDArray result;
+  result.shape = header.shape;
+  result.strides = detail::_computeStrides(header.shape);
+  result.ndim = header.shape.size();
+  result.size = 1;
+  for (int64_t dim : header.shape)
+    result.size *= dim;
+  result.rowElements = header.shape[0] > 0 ? result.size / header.shape[0] : 1;
+  result.tileRows = _rowsPerTile(result.rowElements, tileBytes);
+  result.tileBytes = tileBytes;
+  result.path = inputPath;
+  result.dataOffset = header.dataOffset;
+
+  uintmax_t expected =
+      result.dataOffset + static_cast<uintmax_t>(result.size) * sizeof(float);
+  if (std::filesystem::file_size(inputPath) < expected)
+    throw std::runtime_error("Truncated .npy payload in '" + inputPath + "'.");
+
+  return result;
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::fromNDArray(const NDArray &source,
+                                               const std::string &inputPath,
+                                               size_t tileBytes) {
+  OutOfCoreNDArray result = create(inputPath, source.shape, tileBytes);
+
+  if (source.isContiguous()) {
+    result.writeRows(0, source.shape[0], source.data);
+    return result;
+  }
+
+  // Views are materialized one tile at a time
+  for (int64_t tile = 0; tile < result.numTiles(); ++tile) {
+    int64_t row0 = tile * result.tileRows;
+    int64_t rows = result.tileRowCount(tile);
+    std::vector<std::tuple<int64_t, int64_t>> ranges;
+    ranges.push_back({row0, row0 + rows});
+    for (int d = 1; d < source.ndim; ++d)
+      ranges.push_back({0, source.shape[d]});
+
+    NDArray view = const_cast<NDArray &>(source).slice(ranges);
+    NDArray values = view.clone();
+    result.writeRows(row0, rows, values.data);
+  }
+  return result;
+}
+
+NDArray OutOfCoreNDArray::toNDArray() const {
+  NDArray result(shape);
+  readRows(0, shape[0], result.data);
+  return result;
+}
+
+int64_t OutOfCoreNDArray::numTiles() const {
+  return (shape[0] + tileRows - 1) / tileRows;
+}
+
+NDArray OutOfCoreNDArray::readTile(int64_t tile) const {
+  if (tile < 0 || tile >= numTiles())
+    throw std::out_of_range("Tile index out of bounds.");
+
+  int64_t rows = tileRowCount(tile);
+  NDArray result(tileShape(rows));
+  readRows(tile * tileRows, rows, result.data);
+  return result;
+}
+
+void OutOfCoreNDArray::writeTile(int64_t tile, const NDArray &values) {
+  if (tile < 0 || tile >= numTiles())
+    throw std::out_of_range("Tile index out of bounds.");
+
+  int64_t rows = tileRowCount(tile);
+  if (values.shape != tileShape(rows)) {
+    throw std::invalid_argument("Tile shape mismatch in writeTile.");
+  }
+
+  if (values.isContiguous()) {
+    writeRows(tile * tileRows, rows, values.data);
+  } else {
+    NDArray packed = const_cast<NDArray &>(values).clone();
+    writeRows(tile * tileRows, rows, packed.data);
+  }
+}
+
+void OutOfCoreNDArray::readRows(int64_t row0, int64_t rows, float *dst) const {
+  // A stream per call keeps concurrent reads (read-ahead) independent
+  std::ifstream in(path, std::ios::binary);
+  in.seekg(static_cast<std::streamoff>(dataOffset +
+                                       static_cast<size_t>(row0) *
+                                           rowElements * sizeof(float)));
+  std::streamsize bytes = static_cast<std::streamsize>(
+      static_cast<size_t>(rows) * rowElements * sizeof(float));
+  in.read(reinterpret_cast<char *>(dst), bytes);
+  if (!in || in.gcount() != bytes)
+    throw std::runtime_error("Failed reading tile from '" + path + "'.");
+}
+
+void OutOfCoreNDArray::writeRows(int64_t row0, int64_t rows, const float *src) {
+  std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+  out.seekp(static_cast<std::streamoff>(dataOffset +
+                                        static_cast<size_t>(row0) *
+                                            rowElements * sizeof(float)));
+  out.write(reinterpret_cast<const char *>(src),
+            static_cast<std::streamsize>(static_cast<size_t>(rows) *
+                                         rowElements * sizeof(float)));
+  if (!out)
+    throw std::runtime_error("Failed writing tile to '" + path + "'.");
+}
+
+std::vector<int64_t> OutOfCoreNDArray::tileShape(int64_t rows) const {
+  std::vector<int64_t> result = shape;
+  result[0] = rows;
+  return result;
+}
+
+int64_t OutOfCoreNDArray::tileRowCount(int64_t tile) const {
+  return std::min(tileRows, shape[0] - tile * tileRows);
+}
+
+// Rows per step of mapTiles: an input tile, split further when the matching
+// rows of the output (e.g. a matmul with a wider result) would not fit the
+// tile budget
+int64_t OutOfCoreNDArray::mapRows(const std::vector<int64_t> &outShape) const {
+  size_t outRowElements = 1;
+  for (size_t d = 1; d < outShape.size(); ++d)
+    outRowElements *= static_cast<size_t>(outShape[d]);
+  return std::min(tileRows, _rowsPerTile(outRowElements, tileBytes));
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::mapTiles(
+    const std::vector<int64_t> &outShape,
+    const std::function<NDArray(NDArray &, int64_t, int64_t)> &kernel) const {
+  // The result is tiled by its own row width under the same budget
+  OutOfCoreNDArray result = create("", outShape, tileBytes);
+
+  int64_t step = mapRows(outShape);
+  OutOfCoreTileReader reader(*this, step);
+  for (int64_t row0 = 0; row0 < shape[0]; row0 += step) {
+    NDArray input = reader.next();
+    int64_t rows = input.shape[0];
+    NDArray output = kernel(input, row0, rows);
+    result.writeRows(row0, rows, output.data);
+  }
+  return result;
+}
+
+// Element-wise ops between two file-backed arrays stream both inputs
+#define INCLIARRAY_OOC_BINARY(NAME, EXPR)                                      \
+  OutOfCoreNDArray OutOfCoreNDArray::NAME(const OutOfCoreNDArray &other)       \
+      const {                                                                  \
+    if (shape != other.shape) {                                                \
+      throw std::invalid_argument(                                             \
+          "Out-of-core element-wise ops need equal shapes.");                  \
+    }                                                                          \
+    OutOfCoreTileReader otherReader(other, mapRows(shape));                    \
+    return mapTiles(shape, [&otherReader](NDArray &a, int64_t, int64_t) {      \
+      NDArray b = otherReader.next();                                          \
+      return EXPR;                                                             \
+    });                                                                        \
+  }
+
+INCLIARRAY_OOC_BINARY(operator+, a + b)
+INCLIARRAY_OOC_BINARY(operator-, a - b)
+INCLIARRAY_OOC_BINARY(operator/, a / b)
+INCLIARRAY_OOC_BINARY(element_wise_multiply, a.element_wise_multiply(b))
+
+#undef INCLIARRAY_OOC_BINARY
+
+// Broadcasting with an in-memory operand: rows of `other` are sliced to the
+// tile when it spans axis 0, otherwise it is broadcast as-is.
+#define INCLIARRAY_OOC_BROADCAST(NAME, EXPR)                                   \
+  OutOfCoreNDArray OutOfCoreNDArray::NAME(NDArray &other) const {              \
+    std::vector<int64_t> outShape =                                            \
+        detail::_broadcastShape(shape, other.shape);                           \
+    if (outShape != shape) {                                                   \
+      throw std::invalid_argument(                                             \
+          "In-memory operand must broadcast to the out-of-core shape.");       \
+    }                                                                          \
+    bool perRow = other.ndim == ndim && other.shape[0] != 1;                   \
+    return mapTiles(shape, [&other, perRow](NDArray &a, int64_t row0,          \
+                                            int64_t rows) {                    \
+      if (!perRow)                                                             \
+        return EXPR(other);                                                    \
+      std::vector<std::tuple<int64_t, int64_t>> ranges = {                     \
+          {row0, row0 + rows}};                                                \
+      for (int d = 1; d < other.ndim; ++d)                                     \
+        ranges.push_back({0, other.shape[d]});                                 \
+      NDArray rowsOfOther = other.slice(ranges);                               \
+      return EXPR(rowsOfOther);                                                \
+    });                                                                        \
+  }
+
+INCLIARRAY_OOC_BROADCAST(operator+, a +)
+INCLIARRAY_OOC_BROADCAST(operator-, a -)
+INCLIARRAY_OOC_BROADCAST(operator/, a /)
+INCLIARRAY_OOC_BROADCAST(element_wise_multiply, a.element_wise_multiply)
+
+#undef INCLIARRAY_OOC_BROADCAST
+
+OutOfCoreNDArray OutOfCoreNDArray::operator+(float value) const {
+  return mapTiles(shape,
+                  [value](NDArray &a, int64_t, int64_t) { return a + value; });
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::operator-(float value) const {
+  return mapTiles(shape,
+                  [value](NDArray &a, int64_t, int64_t) { return a - value; });
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::operator*(float value) const {
+  return mapTiles(shape,
+                  [value](NDArray &a, int64_t, int64_t) { return a * value; });
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::operator/(float value) const {
+  return mapTiles(shape,
+                  [value](NDArray &a, int64_t, int64_t) { return a / value; });
+}
+
+NDArray OutOfCoreNDArray::sum() const {
+  double total = 0.0;
+  OutOfCoreTileReader reader(*this, tileRows);
+  for (int64_t tile = 0; tile < numTiles(); ++tile) {
+    NDArray input = reader.next();
+    total += input.sum().data[0];
+  }
+
+  NDArray result({1}, "", "sum");
+  result.data[0] = static_cast<float>(total);
+  return result;
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::sum(int axis) const {
+  int ax = axis;
+  if (ax < 0)
+    ax += ndim;
+  if (ax < 0 || ax >= ndim) {
+    throw std::invalid_argument("Axis out of range in sum(axis)");
+  }
+
+  std::vector<int64_t> outShape = shape;
+  outShape[ax] = 1;
+
+  if (ax != 0) {
+    // Rows are independent: reduce each tile on its own
+    return mapTiles(outShape,
+                    [ax](NDArray &a, int64_t, int64_t) { return a.sum(ax); });
+  }
+
+  // Reducing the tiled axis: accumulate tile partials into one row
+  NDArray total(outShape);
+  OutOfCoreTileReader reader(*this, tileRows);
+  for (int64_t tile = 0; tile < numTiles(); ++tile) {
+    NDArray input = reader.next();
+    NDArray partial = input.sum(0);
+    for (int64_t i = 0; i < total.size; ++i)
+      total.data[i] += partial.data[i];
+  }
+
+  OutOfCoreNDArray result = create("", outShape, tileBytes);
+  result.writeRows(0, 1, total.data);
+  return result;
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::operator*(NDArray &other) const {
+  if (ndim != 2 || other.ndim != 2 || shape[1] != other.shape[0]) {
+    throw std::invalid_argument(
+        "Out-of-core matrix multiplication needs 2d operands with matching "
+        "inner dimensions.");
+  }
+
+  return mapTiles({shape[0], other.shape[1]},
+                  [&other](NDArray &a, int64_t, int64_t) { return a * other; });
+}
+
+OutOfCoreNDArray OutOfCoreNDArray::operator*(
+    const OutOfCoreNDArray &other) const {
+  if (ndim != 2 || other.ndim != 2 || shape[1] != other.shape[0]) {
+    throw std::invalid_argument(
+        "Out-of-core matrix multiplication needs 2d operands with matching "
+        "inner dimensions.");
+  }
+
+  int64_t n = other.shape[1];
+  return mapTiles({shape[0], n}, [&other, n](NDArray &a, int64_t,
+                                              int64_t rows) {
+    // Stream the row tiles of `other`; each one meets the matching column
+    // block of these rows: out += a[:, k0:k1] * other[k0:k1, :]
+    NDArray out({rows, n});
+    OutOfCoreTileReader otherReader(other, other.tileRows);
+    for (int64_t tile = 0; tile < other.numTiles(); ++tile) {
+      NDArray b = otherReader.next();
+      int64_t k0 = tile * other.tileRows;
+      int64_t k1 = k0 + b.shape[0];
+      NDArray block = a.slice({{0, rows}, {k0, k1}});
+      NDArray partial = block * b;
+      for (int64_t i = 0; i < out.size; ++i)
+        out.data[i] += partial.data[i];
+    }
+    return out;
+  });
+}
@@ -0,0 +1,147 @@
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+std::mutex eventsMutex;
+std::vector<ProfileEvent> recorded;
+
+const std::chrono::steady_clock::time_point epoch =
+    std::chrono::steady_clock::now();
+
+int _threadId() {
+  static std::atomic<int> nextId{1};
+  thread_local int id = nextId++;
+  return id;
+}
+
+const char *_phaseName(ProfilePhase phase) {
+  return phase == ProfilePhase::Forward ? "forward" : "backward";
+}
+
+std::string _jsonEscape(const std::string &text) {
+  std::string result;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char code[8];
+      std::snprintf(code, sizeof(code), "\\u%04x", c);
+      result += code;
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+} // namespace
+
+void Profiler::enable() { active.store(true, std::memory_order_relaxed); }
+
+void Profiler::disable() { active.store(false, std::memory_order_relaxed); }
+
+void Profiler::reset() {
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  recorded.clear();
+}
+
+int64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+void Profiler::record(ProfileEvent event) {
+  event.threadId = _threadId();
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  recorded.push_back(std::move(event));
+}
+
+std::vector<ProfileEvent> Profiler::events() {
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  return recorded;
+}
+
+void Profiler::printSummary(std::ostream &out) {
+  struct Total {
+    int64_t calls = 0;
+    int64_t durationNs = 0;
+    OpCost cost;
+  };
+
+  std::map<std::tuple<int, std::string>, Total> totals;
+  int64_t allNs = 0;
+  for (const ProfileEvent &event : events()) {
+    Total &total = totals[{static_cast<int>(event.phase), event.op}];
+    total.calls++;
+    total.durationNs += event.durationNs;
+    total.cost.flops += event.cost.flops;
+    total.cost.bytesRead += event.cost.bytesRead;
+    total.cost.bytesWritten += event.cost.bytesWritten;
+    allNs += event.durationNs;
+  }
+
+  std::vector<std::pair<std::tuple<int, std::string>, Total>> rows(
+      totals.begin(), totals.end());
+  std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+    return a.second.durationNs > b.second.durationNs;
+  });
+
+  char line[160];
+  std::snprintf(line, sizeof(line), "%-9s %-12s %8s %11s %7s %11s %9s %9s\n",
+                "phase", "op", "calls", "total ms", "%", "mean us", "GFLOP/s",
+                "GB/s");
+  out << line;
+  for (const auto &[key, total] : rows) {
+    double seconds = total.durationNs * 1e-9;
+    double bytes =
+        static_cast<double>(total.cost.bytesRead + total.cost.bytesWritten);
+    std::snprintf(
+        line, sizeof(line),
+        "%-9s %-12s %8lld %11.3f %6.1f%% %11.2f %9.2f %9.2f\n",
+        _phaseName(static_cast<ProfilePhase>(std::get<0>(key))),
+        std::get<1>(key).c_str(), static_cast<long long>(total.calls),
+        total.durationNs * 1e-6,
+        allNs > 0 ? 100.0 * total.durationNs / allNs : 0.0,
+        total.durationNs * 1e-3 / total.calls,
+        seconds > 0 ? total.cost.flops / seconds * 1e-9 : 0.0,
+        seconds > 0 ? bytes / seconds * 1e-9 : 0.0);
+    out << line;
+  }
+}
+
+void Profiler::exportChromeTrace(const std::string &path) {
+  std::ofstream out(path);
+  if (!out)
+    throw std::runtime_error("Could not open '" + path + "' for writing.");
+
+  // Complete ("X") events with microsecond timestamps
+  std::vector<ProfileEvent> all = events();
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  for (size_t i = 0; i < all.size(); ++i) {
+    const ProfileEvent &event = all[i];
+    char times[96];
+    std::snprintf(times, sizeof(times), "\"ts\": %.3f, \"dur\": %.3f",
+                  event.startNs * 1e-3, event.durationNs * 1e-3);
+    out << "  {\"name\": \"" << _jsonEscape(event.op) << "\", \"cat\": \""
+        << _phaseName(event.phase) << "\", \"ph\": \"X\", " << times
+        << ", \"pid\": 1, \"tid\": " << event.threadId
+        << ", \"args\": {\"label\": \"" << _jsonEscape(event.label)
+        << "\", \"shapes\": \"" << event.shapes
+        << "\", \"flops\": " << event.cost.flops
+        << ", \"bytes_read\": " << event.cost.bytesRead
+        << ", \"bytes_written\": " << event.cost.bytesWritten << "}}"
+        << (i + 1 < all.size() ? ",\n" : "\n");
+  }
+  out << "]}\n";
+
+  if (!out)
+    throw std::runtime_error("Failed writing '" + path + "'.");
+}
@@ -0,0 +1,510 @@
+#include "../include/QuantizedNDArray.h"
+#include "./utils.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define INCLIARRAY_QGEMM_VNNI 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define INCLIARRAY_QGEMM_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define INCLIARRAY_QGEMM_SSE2 1
+#endif
+
+namespace {
+// Clamping range of the int8 codes for a scheme
+int32_t _qmin(QuantScheme scheme) {
+  return scheme == QuantScheme::Symmetric ? -127 : -128;
+}
+
+int32_t _qmax(QuantScheme) { return 127; }
+
+int8_t _quantizeValue(float value, float scale, int32_t zeroPoint,
+                      QuantScheme scheme) {
+  long q = std::lrint(value / scale) + zeroPoint;
+  q = std::max<long>(_qmin(scheme), std::min<long>(_qmax(scheme), q));
+  return static_cast<int8_t>(q);
+}
+
+// Derive (scale, zeroPoint) from the observed range of a channel
+void _chooseParams(float lo, float hi, QuantScheme scheme, float &scale,
+                   int32_t &zeroPoint) {
+  if (scheme == QuantScheme::Symmetric) {
+    float maxAbs = std::max(std::fabs(lo), std::fabs(hi));
+    scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+    zeroPoint = 0;
+    return;
+  }
+
+  // The affine range must contain 0 so that 0.0f is exactly representable
+  lo = std::min(lo, 0.0f);
+  hi = std::max(hi, 0.0f);
+  scale = hi > lo ? (hi - lo) / 255.0f : 1.0f;
+  long zp = -128 - std::lrint(lo / scale);
+  zeroPoint = static_cast<int32_t>(std::max(-128L, std::min(127L, zp)));
+}
+
+// Below this many multiply-adds a quantized matmul runs on one thread
+constexpr int64_t kParallelElements = 1 << 15;
+
+// The GEMM consumes k in pairs: each int32 lane holds two int16-widened
+// codes, and a pair multiply-add (pmaddwd / vpdpwssd) adds a0*b0 + a1*b1
+// into an int32 accumulator, twice the products per instruction of the float
+// kernel. QVec is one register of kQLanes such lanes.
+#if defined(INCLIARRAY_QGEMM_VNNI)
+using QVec = __m512i;
+constexpr int kQLanes = 16;
+inline QVec _qZero() { return _mm512_setzero_si512(); }
+inline QVec _qLoad(const int32_t *p) { return _mm512_loadu_si512(p); }
+inline void _qStore(int32_t *p, QVec v) { _mm512_storeu_si512(p, v); }
+inline QVec _qBroadcast(int32_t v) { return _mm512_set1_epi32(v); }
+inline QVec _qMadd(QVec acc, QVec a, QVec b) {
+  return _mm512_dpwssd_epi32(acc, a, b);
+}
+#elif defined(INCLIARRAY_QGEMM_AVX2)
+using QVec = __m256i;
+constexpr int kQLanes = 8;
+inline QVec _qZero() { return _mm256_setzero_si256(); }
+inline QVec _qLoad(const int32_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+inline void _qStore(int32_t *p, QVec v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+inline QVec _qBroadcast(int32_t v) { return _mm256_set1_epi32(v); }
+inline QVec _qMadd(QVec acc, QVec a, QVec b) {
+  return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+}
+#elif defined(INCLIARRAY_QGEMM_SSE2)
+using QVec = __m128i;
+constexpr int kQLanes = 4;
+inline QVec _qZero() { return _mm_setzero_si128(); }
+inline QVec _qLoad(const int32_t *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+inline void _qStore(int32_t *p, QVec v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+inline QVec _qBroadcast(int32_t v) { return _mm_set1_epi32(v); }
+inline QVec _qMadd(QVec acc, QVec a, QVec b) {
+  return _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+}
+#else
+struct QVec {
+  int32_t lane[4];
+};
+constexpr int kQLanes = 4;
+inline QVec _qZero() { return QVec{{0, 0, 0, 0}}; }
+inline QVec _qLoad(const int32_t *p) { return QVec{{p[0], p[1], p[2], p[3]}}; }
+inline void _qStore(int32_t *p, QVec v) {
+  for (int l = 0; l < kQLanes; ++l)
+    p[l] = v.lane[l];
+}
+inline QVec _qBroadcast(int32_t v) { return QVec{{v, v, v, v}}; }
+inline QVec _qMadd(QVec acc, QVec a, QVec b) {
+  for (int l = 0; l < kQLanes; ++l) {
+    int32_t a0 = static_cast<int16_t>(a.lane[l] & 0xffff);
+    int32_t a1 = static_cast<int16_t>(static_cast<uint32_t>(a.lane[l]) >> 16);
+    int32_t b0 = static_cast<int16_t>(b.lane[l] & 0xffff);
+    int32_t b1 = static_cast<int16_t>(static_cast<uint32_t>(b.lane[l]) >> 16);
+    acc.lane[l] += a0 * b0 + a1 * b1;
+  }
+  return acc;
+}
+#endif
+
+// Micro-kernel tile: kQRows x kQCols of C live in registers
+constexpr int kQRows = 4;
+constexpr int kQCols = 2 * kQLanes;
+// Cache blocks: k pairs per pass, and C rows x columns per work item. A pass
+// adds at most kQBlockK * 2 * 128 * 128 to an int32 lane, far from overflow;
+// longer k is summed across passes in int64.
+constexpr int64_t kQBlockK = 256;
+constexpr int64_t kQBlockM = 32;
+constexpr int64_t kQBlockN = 256;
+
+// Two int8 codes as the int16 halves of one int32 lane
+inline int32_t _qPair(int8_t lo, int8_t hi) {
+  uint32_t l = static_cast<uint16_t>(static_cast<int16_t>(lo));
+  uint32_t h = static_cast<uint16_t>(static_cast<int16_t>(hi));
+  return static_cast<int32_t>(l | (h << 16));
+}
+
+// C[0:kQRows, 0:kQCols] (+)= A * B over kc pairs of k. `a` holds kQRows
+// pairs per step (rows interleaved), `b` kQCols pairs per step.
+void _qKernel(int64_t kc, const int32_t *a, const int32_t *b, int32_t *c,
+              int64_t ldc, bool accumulate) {
+  QVec acc[kQRows][2];
+  for (int r = 0; r < kQRows; ++r) {
+    acc[r][0] = accumulate ? _qLoad(c + r * ldc) : _qZero();
+    acc[r][1] = accumulate ? _qLoad(c + r * ldc + kQLanes) : _qZero();
+  }
+  for (int64_t p = 0; p < kc; ++p) {
+    QVec b0 = _qLoad(b + p * kQCols);
+    QVec b1 = _qLoad(b + p * kQCols + kQLanes);
+    for (int r = 0; r < kQRows; ++r) {
+      QVec av = _qBroadcast(a[p * kQRows + r]);
+      acc[r][0] = _qMadd(acc[r][0], av, b0);
+      acc[r][1] = _qMadd(acc[r][1], av, b1);
+    }
+  }
+  for (int r = 0; r < kQRows; ++r) {
+    _qStore(c + r * ldc, acc[r][0]);
+    _qStore(c + r * ldc + kQLanes, acc[r][1]);
+  }
+}
+
+// Rank, inner dimension and per-channel axes of a quantized matmul; runs
+// before anything reads shape[1]
+void _checkMatmul(const QuantizedNDArray &A, const QuantizedNDArray &B) {
+  if (A.ndim != 2 || B.ndim != 2) {
+    throw std::invalid_argument(
+        "Quantized matrix multiplication is only supported for 2d arrays!");
+  }
+  if (A.shape[1] != B.shape[0]) {
+    throw std::invalid_argument(
+        "The column axis of first matrix and row axis of second matrix should "
+        "be equal for matrix multiplication. Instead got " +
+        std::to_string(A.shape[1]) + " for first matrix and " +
+        std::to_string(B.shape[0]) + " for second matrix.");
+  }
+  if ((A.perChannel() && A.axis != 0) || (B.perChannel() && B.axis != 1)) {
+    throw std::invalid_argument(
+        "Quantized matmul supports per-channel parameters only along rows of "
+        "the first matrix and columns of the second matrix.");
+  }
+}
+
+// Runs the int32 GEMM and hands each corrected accumulator to `epilogue`
+// together with its (row, col) position. Shapes are checked by the caller
+// (_checkMatmul).
+//
+// Both operands are packed once into pair lanes (A in panels of kQRows
+// interleaved rows, B in panels of kQCols columns, zero-padded at the
+// edges). Work items are blocks of kQBlockM x kQBlockN outputs, spread over
+// threads; each accumulates into its own int32 tile, walking k in kQBlockK
+// steps so the B panel stays in L1 (and flushing every step into an int64
+// tile when k spans several), and runs the epilogue on the finished tile.
+// Integer accumulation is exact, so results do not depend on blocking or
+// thread count.
+template <typename Epilogue>
+void _qgemm(const QuantizedNDArray &A, const QuantizedNDArray &B,
+            Epilogue epilogue) {
+  int64_t m = A.shape[0];
+  int64_t k = A.shape[1];
+  int64_t n = B.shape[1];
+  int64_t kp = (k + 1) / 2;
+  int64_t rowPanels = (m + kQRows - 1) / kQRows;
+  int64_t colPanels = (n + kQCols - 1) / kQCols;
+  bool parallel = m * n * k >= kParallelElements;
+
+  // Pack A and take its row sums for the zero-point correction
+  std::vector<int32_t> packedA(static_cast<size_t>(rowPanels) * kp * kQRows);
+  std::vector<int64_t> rowSumA(m, 0);
+#pragma omp parallel for schedule(static) if (parallel && rowPanels > 1)
+  for (int64_t q = 0; q < rowPanels; ++q) {
+    int32_t *dst = packedA.data() + static_cast<size_t>(q) * kp * kQRows;
+    for (int r = 0; r < kQRows; ++r) {
+      int64_t i = q * kQRows + r;
+      if (i >= m) {
+        for (int64_t p = 0; p < kp; ++p)
+          dst[p * kQRows + r] = 0;
+        continue;
+      }
+      const int8_t *aRow = A.values.data() + static_cast<size_t>(i) * k;
+      int64_t sum = 0;
+      for (int64_t p = 0; p < kp; ++p) {
+        int8_t lo = aRow[2 * p];
+        int8_t hi = 2 * p + 1 < k ? aRow[2 * p + 1] : 0;
+        dst[p * kQRows + r] = _qPair(lo, hi);
+        sum += lo + hi;
+      }
+      rowSumA[i] = sum;
+    }
+  }
+
+  // Pack B and take its column sums
+  std::vector<int32_t> packedB(static_cast<size_t>(colPanels) * kp * kQCols);
+  std::vector<int64_t> colSumB(n, 0);
+#pragma omp parallel for schedule(static) if (parallel && colPanels > 1)
+  for (int64_t g = 0; g < colPanels; ++g) {
+    int32_t *dst = packedB.data() + static_cast<size_t>(g) * kp * kQCols;
+    int64_t j0 = g * kQCols;
+    int64_t cols = std::min<int64_t>(kQCols, n - j0);
+    int64_t sums[kQCols] = {};
+    for (int64_t p = 0; p < kp; ++p) {
+      const int8_t *lo = B.values.data() + (2 * p) * n + j0;
+      const int8_t *hi = 2 * p + 1 < k ? lo + n : nullptr;
+      int32_t *out = dst + p * kQCols;
+      for (int64_t c = 0; c < cols; ++c) {
+        int8_t h = hi ? hi[c] : 0;
+        out[c] = _qPair(lo[c], h);
+        sums[c] += lo[c] + h;
+      }
+      for (int64_t c = cols; c < kQCols; ++c)
+        out[c] = 0;
+    }
+    for (int64_t c = 0; c < cols; ++c)
+      colSumB[j0 + c] = sums[c];
+  }
+
+  int64_t rowBlocks = (m + kQBlockM - 1) / kQBlockM;
+  int64_t colBlocks = (n + kQBlockN - 1) / kQBlockN;
+  int64_t items = rowBlocks * colBlocks;
+#pragma omp parallel if (parallel && items > 1)
+  {
+    bool wideK = kp > kQBlockK;
+    std::vector<int32_t> tile(static_cast<size_t>(kQBlockM) * kQBlockN);
+    std::vector<int64_t> wide(wideK ? tile.size() : 0);
+
+#pragma omp for schedule(static)
+    for (int64_t item = 0; item < items; ++item) {
+      int64_t i0 = item / colBlocks * kQBlockM;
+      int64_t j0 = item % colBlocks * kQBlockN;
+      int64_t mb = std::min(kQBlockM, m - i0);
+      int64_t nb = std::min(kQBlockN, n - j0);
+
+      if (kp == 0)
+        std::fill(tile.begin(), tile.end(), 0);
+      for (int64_t p0 = 0; p0 < kp; p0 += kQBlockK) {
+        int64_t kc = std::min(kQBlockK, kp - p0);
+        for (int64_t jj = 0; jj < nb; jj += kQCols) {
+          const int32_t *bPanel = packedB.data() +
+                                  static_cast<size_t>((j0 + jj) / kQCols) *
+                                      kp * kQCols +
+                                  p0 * kQCols;
+          for (int64_t ii = 0; ii < mb; ii += kQRows) {
+            const int32_t *aPanel = packedA.data() +
+                                    static_cast<size_t>((i0 + ii) / kQRows) *
+                                        kp * kQRows +
+                                    p0 * kQRows;
+            _qKernel(kc, aPanel, bPanel, tile.data() + ii * kQBlockN + jj,
+                     kQBlockN, p0 > 0 && !wideK);
+          }
+        }
+
+        if (wideK) {
+          for (int64_t ii = 0; ii < mb; ++ii) {
+            const int32_t *src = tile.data() + ii * kQBlockN;
+            int64_t *dst = wide.data() + ii * kQBlockN;
+            for (int64_t jj = 0; jj < nb; ++jj)
+              dst[jj] = (p0 > 0 ? dst[jj] : 0) + src[jj];
+          }
+        }
+      }
+
+      // sum((a - za) * (b - zb)) expanded with precomputed sums; the
+      // correction terms grow with k * 255 * 255 and need 64 bits
+      for (int64_t ii = 0; ii < mb; ++ii) {
+        int64_t i = i0 + ii;
+        int64_t za = A.zeroPoints[A.perChannel() ? i : 0];
+        const int32_t *row = tile.data() + ii * kQBlockN;
+        const int64_t *wideRow =
+            wideK ? wide.data() + ii * kQBlockN : nullptr;
+        for (int64_t jj = 0; jj < nb; ++jj) {
+          int64_t j = j0 + jj;
+          int64_t zb = B.zeroPoints[B.perChannel() ? j : 0];
+          int64_t acc = wideK ? wideRow[jj] : row[jj];
+          acc += -zb * rowSumA[i] - za * colSumB[j] + k * za * zb;
+          epilogue(i, j, acc);
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+QuantizedNDArray::QuantizedNDArray(std::vector<int64_t> inputShape,
+                                   QuantScheme inputScheme) {
+  shape = inputShape;
+
+  size = 1;
+  for (int i = 0; i < shape.size(); i++) {
+    size *= shape[i];
+  }
+
+  values.assign(size, 0);
+  strides = detail::_computeStrides(shape);
+  ndim = shape.size();
+  scales = {1.0f};
+  zeroPoints = {0};
+  axis = -1;
+  scheme = inputScheme;
+}
+
+QuantizedNDArray QuantizedNDArray::quantize(const NDArray &input,
+                                            QuantScheme scheme) {
+  QuantizedNDArray result(input.shape, scheme);
+
+  // First pass: observe the range respecting strides
+  float lo = 0.0f;
+  float hi = 0.0f;
+  Shape index(input.shape.size(), 0);
+  for (int64_t i = 0; i < input.size; ++i) {
+    float value = input.data[detail::_computeOffset(index, input.strides)];
+    lo = (i == 0) ? value : std::min(lo, value);
+    hi = (i == 0) ? value : std::max(hi, value);
+
+    for (int dim = static_cast<int>(input.shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < input.shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+
+  _chooseParams(lo, hi, scheme, result.scales[0], result.zeroPoints[0]);
+
+  // Second pass: quantize into contiguous storage
+  std::fill(index.begin(), index.end(), 0);
+  for (int64_t i = 0; i < input.size; ++i) {
+    float value = input.data[detail::_computeOffset(index, input.strides)];
+    result.values[i] =
+        _quantizeValue(value, result.scales[0], result.zeroPoints[0], scheme);
+
+    for (int dim = static_cast<int>(input.shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < input.shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+
+  return result;
+}
+
+QuantizedNDArray QuantizedNDArray::quantizePerChannel(const NDArray &input,
+                                                      int axis,
+                                                      QuantScheme scheme) {
+  int ax = axis;
+  if (ax < 0)
+    ax += input.ndim;
+  if (ax < 0 || ax >= input.ndim) {
+    throw std::invalid_argument("Axis out of range in quantizePerChannel");
+  }
+
+  QuantizedNDArray result(input.shape, scheme);
+  int64_t channels = input.shape[ax];
+  result.axis = ax;
+  result.scales.assign(channels, 1.0f);
+  result.zeroPoints.assign(channels, 0);
+
+  // First pass: observe the range of every channel
+  std::vector<float> lo(channels, 0.0f);
+  std::vector<float> hi(channels, 0.0f);
+  std::vector<bool> seen(channels, false);
+  Shape index(input.shape.size(), 0);
+  for (int64_t i = 0; i < input.size; ++i) {
+    float value = input.data[detail::_computeOffset(index, input.strides)];
+    int64_t c = index[ax];
+    lo[c] = seen[c] ? std::min(lo[c], value) : value;
+    hi[c] = seen[c] ? std::max(hi[c], value) : value;
+    seen[c] = true;
+
+    for (int dim = static_cast<int>(input.shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < input.shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+
+  for (int64_t c = 0; c < channels; ++c) {
+    _chooseParams(lo[c], hi[c], scheme, result.scales[c],
+                  result.zeroPoints[c]);
+  }
+
+  // Second pass: quantize every element with its channel's parameters
+  std::fill(index.begin(), index.end(), 0);
+  for (int64_t i = 0; i < input.size; ++i) {
+    float value = input.data[detail::_computeOffset(index, input.strides)];
+    int64_t c = index[ax];
+    result.values[i] = _quantizeValue(value, result.scales[c],
+                                      result.zeroPoints[c], scheme);
+
+    for (int dim = static_cast<int>(input.shape.size()) - 1; dim >= 0; --dim) {
+      index[dim]++;
+      if (index[dim] < input.shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+
+  return result;
+}
+
+NDArray QuantizedNDArray::dequantize() const {
+  NDArray result(shape);
+
+  if (!perChannel()) {
+    float scale = scales[0];
+    int32_t zeroPoint = zeroPoints[0];
+    for (int64_t i = 0; i < size; ++i) {
+      result.data[i] = scale * (static_cast<int32_t>(values[i]) - zeroPoint);
+    }
+    return result;
+  }
+
+  // Contiguous storage: the channel of flat position i is
+  // (i / strides[axis]) % shape[axis]
+  int64_t channelStride = strides[axis];
+  int64_t channels = shape[axis];
+  for (int64_t i = 0; i < size; ++i) {
+    int64_t c = (i / channelStride) % channels;
+    result.data[i] =
+        scales[c] * (static_cast<int32_t>(values[i]) - zeroPoints[c]);
+  }
+
+  return result;
+}
+
+NDArray QuantizedNDArray::operator*(const QuantizedNDArray &other) const {
+  _checkMatmul(*this, other);
+  NDArray result({shape[0], other.shape[1]}, "", "qmatmul");
+  int64_t n = other.shape[1];
+  bool aPerChannel = perChannel();
+  bool bPerChannel = other.perChannel();
+
+  // Fused dequantize epilogue: out(i, j) = sA(i) * sB(j) * acc(i, j)
+  _qgemm(*this, other, [&](int64_t i, int64_t j, int64_t acc) {
+    float sa = scales[aPerChannel ? i : 0];
+    float sb = other.scales[bPerChannel ? j : 0];
+    result.data[i * n + j] = sa * sb * static_cast<float>(acc);
+  });
+
+  return result;
+}
+
+QuantizedNDArray QuantizedNDArray::matmul(const QuantizedNDArray &other,
+                                          float outScale, int32_t outZeroPoint,
+                                          QuantScheme outScheme) const {
+  if (!(outScale > 0.0f)) {
+    throw std::invalid_argument("Output scale must be positive in matmul");
+  }
+  _checkMatmul(*this, other);
+
+  QuantizedNDArray result({shape[0], other.shape[1]}, outScheme);
+  result.scales = {outScale};
+  result.zeroPoints = {outScheme == QuantScheme::Symmetric ? 0 : outZeroPoint};
+  int64_t n = other.shape[1];
+  bool aPerChannel = perChannel();
+  bool bPerChannel = other.perChannel();
+  int32_t zOut = result.zeroPoints[0];
+
+  // Fused requantize epilogue: q = round(sA * sB / sOut * acc) + zOut
+  _qgemm(*this, other, [&](int64_t i, int64_t j, int64_t acc) {
+    float sa = scales[aPerChannel ? i : 0];
+    float sb = other.scales[bPerChannel ? j : 0];
+    float real = sa * sb * static_cast<float>(acc);
+    result.values[i * n + j] = _quantizeValue(real, outScale, zOut, outScheme);
+  });
+
+  return result;
+}
+
+bool QuantizedNDArray::perChannel() const { return axis >= 0; }
@@ -0,0 +1,83 @@
+#include "../include/Random.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+// Philox4x32 multipliers and Weyl key increments (Salmon et al., SC'11)
+constexpr uint32_t kPhiloxM0 = 0xD2511F53u;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57u;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9u;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85u;
+constexpr int kPhiloxRounds = 10;
+
+// Blocks processed together; each round is a loop over the batch in
+// structure-of-arrays form so it vectorizes (32x32->64 bit multiplies)
+constexpr size_t kBatch = 16;
+} // namespace
+
+Generator::Generator() : seed(std::random_device{}()) {
+  seed = (seed << 32) ^ std::random_device{}();
+}
+
+Generator::Generator(uint64_t seed) : seed(seed) {}
+
+Generator &Generator::global() {
+  static Generator generator;
+  return generator;
+}
+
+void Generator::manualSeed(uint64_t newSeed) {
+  seed = newSeed;
+  counter = 0;
+}
+
+uint64_t Generator::initialSeed() const { return seed; }
+
+uint64_t Generator::offset() const { return counter; }
+
+uint64_t Generator::reserve(uint64_t blocks) {
+  uint64_t first = counter;
+  counter += blocks;
+  return first;
+}
+
+void Generator::generate(uint64_t first, size_t blocks, uint32_t *out) const {
+  uint32_t c0[kBatch], c1[kBatch], c2[kBatch], c3[kBatch];
+
+  for (size_t b0 = 0; b0 < blocks; b0 += kBatch) {
+    size_t count = std::min(kBatch, blocks - b0);
+
+    for (size_t j = 0; j < kBatch; ++j) {
+      uint64_t ctr = first + b0 + j;
+      c0[j] = static_cast<uint32_t>(ctr);
+      c1[j] = static_cast<uint32_t>(ctr >> 32);
+      c2[j] = 0;
+      c3[j] = 0;
+    }
+
+    uint32_t k0 = static_cast<uint32_t>(seed);
+    uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    for (int round = 0; round < kPhiloxRounds; ++round) {
+      for (size_t j = 0; j < kBatch; ++j) {
+        uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * c0[j];
+        uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * c2[j];
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[j] ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[j] ^ k1;
+        c1[j] = static_cast<uint32_t>(p1);
+        c3[j] = static_cast<uint32_t>(p0);
+        c0[j] = n0;
+        c2[j] = n2;
+      }
+      k0 += kPhiloxW0;
+      k1 += kPhiloxW1;
+    }
+
+    for (size_t j = 0; j < count; ++j) {
+      uint32_t *dst = out + (b0 + j) * 4;
+      dst[0] = c0[j];
+      dst[1] = c1[j];
+      dst[2] = c2[j];
+      dst[3] = c3[j];
+    }
+  }
+}
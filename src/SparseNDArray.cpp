@@ -0,0 +1,468 @@
+#include "../include/SparseNDArray.h"
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+// Below this many multiply-adds a kernel runs on one thread
+constexpr int64_t kParallelElements = 1 << 15;
+
+// Records a forward sparse op with the profiler, timed from `start` (-1 when
+// the profiler was disabled at the start of the op)
+void _profileForward(int64_t start, const std::string &op,
+                     const std::string &label, const std::string &shapes,
+                     OpCost cost) {
+  if (start < 0)
+    return;
+
+  ProfileEvent event;
+  event.op = op;
+  event.label = label;
+  event.shapes = shapes;
+  event.phase = ProfilePhase::Forward;
+  event.startNs = start;
+  event.durationNs = Profiler::now() - start;
+  event.cost = cost;
+  Profiler::record(std::move(event));
+}
+
+void _checkShape(const std::vector<int64_t> &shape) {
+  if (shape.size() != 2 || shape[0] < 0 || shape[1] < 0) {
+    throw std::invalid_argument(
+        "Sparse arrays must have a non-negative 2D shape.");
+  }
+}
+
+// First row whose start (counting every row as one extra unit of work) is at
+// or past `part / parts` of the total, so rows are split by non-zero count
+int64_t _splitRow(const int64_t *rowPointers, int64_t rows, int part,
+                  int parts) {
+  int64_t total = rowPointers[rows] + rows;
+  int64_t target = total / parts * part + total % parts * part / parts;
+  int64_t lo = 0;
+  int64_t hi = rows;
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (rowPointers[mid] + mid < target)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Rows [begin, end) handled by the calling thread of a parallel region
+void _threadRows(const int64_t *rowPointers, int64_t rows, int64_t &begin,
+                 int64_t &end) {
+#ifdef _OPENMP
+  int thread = omp_get_thread_num();
+  int threads = omp_get_num_threads();
+#else
+  int thread = 0;
+  int threads = 1;
+#endif
+  begin = _splitRow(rowPointers, rows, thread, threads);
+  end = _splitRow(rowPointers, rows, thread + 1, threads);
+}
+
+void _axpy(float *y, const float *x, float a, int64_t n) {
+  for (int64_t j = 0; j < n; ++j) {
+    y[j] += a * x[j];
+  }
+}
+
+// Dot product with 8 lanes combined in a fixed order (vectorizes without
+// reassociating, and gives the same value wherever it runs)
+float _dot(const float *a, const float *b, int64_t n) {
+  float lanes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int64_t j = 0;
+  for (; j + 8 <= n; j += 8) {
+    for (int l = 0; l < 8; ++l) {
+      lanes[l] += a[j + l] * b[j + l];
+    }
+  }
+  for (; j < n; ++j) {
+    lanes[0] += a[j] * b[j];
+  }
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+         ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+// y (rows x n, zeroed) = A * b for A in CSR form and b row-major (k x n)
+void _spmm(const int64_t *rowPointers, const int64_t *cols, const float *vals,
+           int64_t rows, const float *b, int64_t n, float *y) {
+#pragma omp parallel if (rowPointers[rows] * n >= kParallelElements)
+  {
+    int64_t begin, end;
+    _threadRows(rowPointers, rows, begin, end);
+    for (int64_t r = begin; r < end; ++r) {
+      for (int64_t e = rowPointers[r]; e < rowPointers[r + 1]; ++e) {
+        _axpy(y + r * n, b + cols[e] * n, vals[e], n);
+      }
+    }
+  }
+}
+
+// Column-major view of a CSR pattern: entries of column c are
+// [pointers[c], pointers[c + 1]), listing their row and position in `vals`
+// in increasing row order
+struct Transposed {
+  std::vector<int64_t> pointers;
+  std::vector<int64_t> rows;
+  std::vector<int64_t> entries;
+};
+
+Transposed _transpose(const int64_t *rowPointers, const int64_t *cols,
+                      int64_t rows, int64_t columns) {
+  int64_t nnz = rowPointers[rows];
+  Transposed t;
+  t.pointers.assign(columns + 1, 0);
+  t.rows.resize(nnz);
+  t.entries.resize(nnz);
+  for (int64_t e = 0; e < nnz; ++e) {
+    ++t.pointers[cols[e] + 1];
+  }
+  std::partial_sum(t.pointers.begin(), t.pointers.end(), t.pointers.begin());
+
+  std::vector<int64_t> next(t.pointers.begin(), t.pointers.end() - 1);
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int64_t e = rowPointers[r]; e < rowPointers[r + 1]; ++e) {
+      int64_t slot = next[cols[e]]++;
+      t.rows[slot] = r;
+      t.entries[slot] = e;
+    }
+  }
+  return t;
+}
+
+std::vector<int64_t> _rowIndices(const std::vector<int64_t> &rowPointers) {
+  int64_t rows = static_cast<int64_t>(rowPointers.size()) - 1;
+  std::vector<int64_t> result(rowPointers.back());
+  for (int64_t r = 0; r < rows; ++r) {
+    std::fill(result.begin() + rowPointers[r],
+              result.begin() + rowPointers[r + 1], r);
+  }
+  return result;
+}
+} // namespace
+
+SparseNDArray::SparseNDArray(std::vector<int64_t> inputShape,
+                             const std::vector<int64_t> &rows,
+                             const std::vector<int64_t> &cols,
+                             const std::vector<float> &inputValues,
+                             SparseFormat inputFormat)
+    : shape(std::move(inputShape)), format(inputFormat) {
+  _checkShape(shape);
+  if (rows.size() != cols.size() || rows.size() != inputValues.size()) {
+    throw std::invalid_argument("Sparse triplets must have equal lengths.");
+  }
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (rows[i] < 0 || rows[i] >= shape[0] || cols[i] < 0 ||
+        cols[i] >= shape[1]) {
+      throw std::out_of_range("Sparse entry (" + std::to_string(rows[i]) +
+                              ", " + std::to_string(cols[i]) +
+                              ") is out of range.");
+    }
+  }
+
+  // Row-major order; stable so duplicates are summed in input order
+  std::vector<size_t> order(rows.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return rows[a] != rows[b] ? rows[a] < rows[b] : cols[a] < cols[b];
+  });
+
+  rowPointers.assign(shape[0] + 1, 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    size_t k = order[i];
+    if (i > 0 && rows[k] == rows[order[i - 1]] &&
+        cols[k] == cols[order[i - 1]]) {
+      values.back() += inputValues[k];
+      continue;
+    }
+    ++rowPointers[rows[k] + 1];
+    colIndices.push_back(cols[k]);
+    values.push_back(inputValues[k]);
+  }
+  std::partial_sum(rowPointers.begin(), rowPointers.end(),
+                   rowPointers.begin());
+  grad.assign(values.size(), 0.0f);
+
+  if (format == SparseFormat::COO) {
+    rowIndices = _rowIndices(rowPointers);
+    rowPointers.clear();
+  }
+}
+
+SparseNDArray SparseNDArray::fromCSR(std::vector<int64_t> inputShape,
+                                     std::vector<int64_t> inputRowPointers,
+                                     std::vector<int64_t> inputColIndices,
+                                     std::vector<float> inputValues) {
+  _checkShape(inputShape);
+  int64_t rows = inputShape[0];
+  int64_t nnz = static_cast<int64_t>(inputValues.size());
+  if (static_cast<int64_t>(inputRowPointers.size()) != rows + 1 ||
+      inputRowPointers.front() != 0 || inputRowPointers.back() != nnz ||
+      static_cast<int64_t>(inputColIndices.size()) != nnz) {
+    throw std::invalid_argument(
+        "CSR row pointers must run from 0 to nnz over rows + 1 entries.");
+  }
+  for (int64_t r = 0; r < rows; ++r) {
+    int64_t begin = inputRowPointers[r];
+    int64_t end = inputRowPointers[r + 1];
+    if (end < begin || end > nnz) {
+      throw std::invalid_argument("CSR row pointers must be non-decreasing.");
+    }
+    for (int64_t e = begin; e < end; ++e) {
+      int64_t c = inputColIndices[e];
+      if (c < 0 || c >= inputShape[1] ||
+          (e > begin && c <= inputColIndices[e - 1])) {
+        throw std::invalid_argument(
+            "CSR column indices must be in range and increasing per row.");
+      }
+    }
+  }
+
+  SparseNDArray result;
+  result.shape = std::move(inputShape);
+  result.format = SparseFormat::CSR;
+  result.rowPointers = std::move(inputRowPointers);
+  result.colIndices = std::move(inputColIndices);
+  result.values = std::move(inputValues);
+  result.grad.assign(nnz, 0.0f);
+  return result;
+}
+
+SparseNDArray SparseNDArray::fromDense(const NDArray &dense, float threshold,
+                                       SparseFormat format) {
+  if (dense.ndim != 2) {
+    throw std::invalid_argument("fromDense() expects a 2D array.");
+  }
+  if (!(threshold >= 0.0f)) {
+    throw std::invalid_argument("Sparsity threshold must be non-negative.");
+  }
+
+  int64_t rows = dense.shape[0];
+  int64_t cols = dense.shape[1];
+  int64_t rowStride = dense.strides[0];
+  int64_t colStride = dense.strides[1];
+  const float *data = dense.data;
+  // NaN compares false, so it is kept like any other large entry
+  auto keep = [threshold](float x) { return !(std::fabs(x) <= threshold); };
+
+  // Count per row, then fill each row at its final offset
+  SparseNDArray result;
+  result.shape = {rows, cols};
+  result.rowPointers.assign(rows + 1, 0);
+#pragma omp parallel for schedule(static) if (dense.size >= kParallelElements)
+  for (int64_t r = 0; r < rows; ++r) {
+    int64_t count = 0;
+    for (int64_t c = 0; c < cols; ++c) {
+      count += keep(data[r * rowStride + c * colStride]) ? 1 : 0;
+    }
+    result.rowPointers[r + 1] = count;
+  }
+  std::partial_sum(result.rowPointers.begin(), result.rowPointers.end(),
+                   result.rowPointers.begin());
+
+  int64_t nnz = result.rowPointers[rows];
+  result.colIndices.resize(nnz);
+  result.values.resize(nnz);
+  result.grad.assign(nnz, 0.0f);
+#pragma omp parallel for schedule(static) if (dense.size >= kParallelElements)
+  for (int64_t r = 0; r < rows; ++r) {
+    int64_t e = result.rowPointers[r];
+    for (int64_t c = 0; c < cols; ++c) {
+      float x = data[r * rowStride + c * colStride];
+      if (keep(x)) {
+        result.colIndices[e] = c;
+        result.values[e] = x;
+        ++e;
+      }
+    }
+  }
+
+  return format == SparseFormat::CSR ? result : result.toCOO();
+}
+
+std::vector<int64_t> SparseNDArray::csrRowPointers() const {
+  if (format == SparseFormat::CSR)
+    return rowPointers;
+
+  std::vector<int64_t> result(shape[0] + 1, 0);
+  for (int64_t r : rowIndices) {
+    ++result[r + 1];
+  }
+  std::partial_sum(result.begin(), result.end(), result.begin());
+  return result;
+}
+
+SparseNDArray SparseNDArray::toCSR() const {
+  SparseNDArray result = *this;
+  if (format == SparseFormat::COO) {
+    result.rowPointers = csrRowPointers();
+    result.rowIndices.clear();
+    result.format = SparseFormat::CSR;
+  }
+  return result;
+}
+
+SparseNDArray SparseNDArray::toCOO() const {
+  SparseNDArray result = *this;
+  if (format == SparseFormat::CSR) {
+    result.rowIndices = _rowIndices(rowPointers);
+    result.rowPointers.clear();
+    result.format = SparseFormat::COO;
+  }
+  return result;
+}
+
+NDArray SparseNDArray::toDense() const {
+  NDArray result({shape[0], shape[1]});
+  std::vector<int64_t> pointers = csrRowPointers();
+  for (int64_t r = 0; r < shape[0]; ++r) {
+    for (int64_t e = pointers[r]; e < pointers[r + 1]; ++e) {
+      result.data[r * shape[1] + colIndices[e]] = values[e];
+    }
+  }
+  return result;
+}
+
+NDArray SparseNDArray::gradToDense() const {
+  NDArray result({shape[0], shape[1]});
+  std::vector<int64_t> pointers = csrRowPointers();
+  for (int64_t r = 0; r < shape[0]; ++r) {
+    for (int64_t e = pointers[r]; e < pointers[r + 1]; ++e) {
+      result.data[r * shape[1] + colIndices[e]] = grad[e];
+    }
+  }
+  return result;
+}
+
+void SparseNDArray::zeroGrad() { std::fill(grad.begin(), grad.end(), 0.0f); }
+
+NDArray SparseNDArray::matmul(NDArray &dense) {
+  if (dense.ndim != 2 || dense.shape[0] != shape[1]) {
+    throw std::invalid_argument(
+        "Sparse matmul expects a 2D dense operand with " +
+        std::to_string(shape[1]) + " rows.");
+  }
+
+  int64_t profileStart = Profiler::enabled() ? Profiler::now() : -1;
+  int64_t rows = shape[0];
+  int64_t inner = shape[1];
+  int64_t n = dense.shape[1];
+
+  // Rows of the dense operand must be contiguous for the row updates
+  auto packed = std::make_shared<std::vector<float>>();
+  const float *b = dense.data;
+  if (!dense.isContiguous()) {
+    packed->resize(inner * n);
+    for (int64_t k = 0; k < inner; ++k) {
+      for (int64_t j = 0; j < n; ++j) {
+        (*packed)[k * n + j] =
+            dense.data[k * dense.strides[0] + j * dense.strides[1]];
+      }
+    }
+    b = packed->data();
+  }
+
+  auto pointers = std::make_shared<std::vector<int64_t>>(csrRowPointers());
+  NDArray result({rows, n}, "", "spmm", {std::ref(dense)});
+  _spmm(pointers->data(), colIndices.data(), values.data(), rows, b, n,
+        result.data);
+
+  // Nominal cost: one multiply-add per stored value and output column; reads
+  // the CSR arrays and the dense operand, writes the output
+  int64_t nnz = static_cast<int64_t>(values.size());
+  OpCost cost;
+  cost.flops = static_cast<uint64_t>(2 * nnz * n);
+  cost.bytesRead = static_cast<uint64_t>(
+      nnz * (sizeof(float) + sizeof(int64_t)) + (rows + 1) * sizeof(int64_t) +
+      inner * n * sizeof(float));
+  cost.bytesWritten = static_cast<uint64_t>(rows * n * sizeof(float));
+  // Backward: a dot and an axpy of length n per stored value
+  result.backwardCost.flops = 2 * cost.flops;
+  result.backwardCost.bytesRead =
+      cost.bytesRead + static_cast<uint64_t>(rows * n * sizeof(float));
+  result.backwardCost.bytesWritten = static_cast<uint64_t>(
+      nnz * sizeof(float) + inner * n * sizeof(float));
+
+  std::string labels = label;
+  if (!dense.label.empty())
+    labels += (labels.empty() ? "" : ", ") + dense.label;
+  _profileForward(profileStart, result.op, labels,
+                  std::to_string(rows) + "x" + std::to_string(inner) +
+                      " (nnz " + std::to_string(nnz) + "), " +
+                      std::to_string(inner) + "x" + std::to_string(n) +
+                      " -> " + std::to_string(rows) + "x" + std::to_string(n),
+                  cost);
+
+  // Buffers of both operands outlive backward() like NDArray operands do
+  const int64_t *cols = colIndices.data();
+  const float *vals = values.data();
+  float *valsGrad = grad.data();
+  float *outGrad = result.grad;
+  const float *denseData = dense.data;
+  float *denseGrad = dense.grad;
+  bool contiguous = dense.isContiguous();
+  int64_t rowStride = dense.strides[0];
+  int64_t colStride = dense.strides[1];
+  result._backward = [=]() {
+    const int64_t *rowPointers = pointers->data();
+    const float *b = contiguous ? denseData : packed->data();
+    int64_t work = rowPointers[rows] * n;
+
+    // Sparse grad: dY[r, :] . B[c, :] for every stored (r, c)
+#pragma omp parallel if (work >= kParallelElements)
+    {
+      int64_t begin, end;
+      _threadRows(rowPointers, rows, begin, end);
+      for (int64_t r = begin; r < end; ++r) {
+        for (int64_t e = rowPointers[r]; e < rowPointers[r + 1]; ++e) {
+          valsGrad[e] += _dot(outGrad + r * n, b + cols[e] * n, n);
+        }
+      }
+    }
+
+    // Dense grad: A^T * dY, one output row per column of A so that threads
+    // never share a row
+    Transposed t = _transpose(rowPointers, cols, rows, inner);
+    std::vector<float> scratch;
+    float *dB = denseGrad;
+    if (!contiguous) {
+      scratch.assign(inner * n, 0.0f);
+      dB = scratch.data();
+    }
+#pragma omp parallel if (work >= kParallelElements)
+    {
+      int64_t begin, end;
+      _threadRows(t.pointers.data(), inner, begin, end);
+      for (int64_t k = begin; k < end; ++k) {
+        for (int64_t e = t.pointers[k]; e < t.pointers[k + 1]; ++e) {
+          _axpy(dB + k * n, outGrad + t.rows[e] * n, vals[t.entries[e]], n);
+        }
+      }
+    }
+
+    // Strided (possibly self-overlapping) grads are accumulated serially
+    if (!contiguous) {
+      for (int64_t k = 0; k < inner; ++k) {
+        for (int64_t j = 0; j < n; ++j) {
+          denseGrad[k * rowStride + j * colStride] += scratch[k * n + j];
+        }
+      }
+    }
+  };
+
+  return result;
+}
@@ -0,0 +1,348 @@
+#include "../include/NDArray.h"
+#include "./npy.h"
+#include "./utils.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INCLIARRAY_HAVE_MMAP 1
+#endif
+
+namespace {
+const char kNpyMagic[] = "\x93NUMPY";
+const size_t kNpyMagicLength = 6;
+// Header + preamble is padded to this many bytes so the payload is aligned
+const size_t kNpyAlignment = 64;
+
+// NumPy dtype string matching the element type
+template <typename T> std::string _npyDescr() {
+  if constexpr (std::is_same_v<T, float>)
+    return "<f4";
+  else if constexpr (std::is_same_v<T, double>)
+    return "<f8";
+  else if constexpr (std::is_same_v<T, int32_t>)
+    return "<i4";
+  else
+    return "<i8";
+}
+
+// Column-major strides for Fortran-ordered payloads
+Shape _fortranStrides(const Shape &shape) {
+  Shape result(shape.size(), 1);
+  for (size_t i = 1; i < shape.size(); ++i) {
+    result[i] = result[i - 1] * shape[i - 1];
+  }
+  return result;
+}
+
+size_t _elementCount(const std::vector<int64_t> &shape) {
+  size_t count = 1;
+  for (int64_t dim : shape)
+    count *= static_cast<size_t>(dim);
+  return count;
+}
+
+// Returns the text following `'key':` in the header dictionary
+size_t _findKey(const std::string &dict, const std::string &key) {
+  size_t pos = dict.find("'" + key + "'");
+  if (pos == std::string::npos)
+    pos = dict.find("\"" + key + "\"");
+  if (pos == std::string::npos)
+    throw std::runtime_error("Malformed .npy header: missing '" + key + "'.");
+
+  pos = dict.find(':', pos);
+  if (pos == std::string::npos)
+    throw std::runtime_error("Malformed .npy header: missing ':' after '" +
+                             key + "'.");
+  return pos + 1;
+}
+} // namespace
+
+detail::NpyHeader detail::_parseNpyHeader(const char *bytes, size_t available) {
+  if (available < kNpyMagicLength + 4 ||
+      std::memcmp(bytes, kNpyMagic, kNpyMagicLength) != 0) {
+    throw std::runtime_error("Not a .npy file (bad magic string).");
+  }
+
+  unsigned char major = static_cast<unsigned char>(bytes[6]);
+  size_t headerLength = 0;
+  size_t preamble = 0;
+  if (major == 1) {
+    headerLength = static_cast<unsigned char>(bytes[8]) |
+                   (static_cast<unsigned char>(bytes[9]) << 8);
+    preamble = 10;
+  } else if (major == 2 || major == 3) {
+    if (available < 12)
+      throw std::runtime_error("Truncated .npy header.");
+    for (int i = 3; i >= 0; --i) {
+      headerLength = (headerLength << 8) |
+                     static_cast<unsigned char>(bytes[8 + i]);
+    }
+    preamble = 12;
+  } else {
+    throw std::runtime_error("Unsupported .npy format version " +
+                             std::to_string(major) + ".");
+  }
+
+  if (available < preamble + headerLength)
+    throw std::runtime_error("Truncated .npy header.");
+
+  std::string dict(bytes + preamble, headerLength);
+  NpyHeader header;
+  header.dataOffset = preamble + headerLength;
+
+  // 'descr': '<f4'
+  size_t pos = _findKey(dict, "descr");
+  size_t open = dict.find_first_of("'\"", pos);
+  size_t close = open == std::string::npos ? std::string::npos
+                                           : dict.find(dict[open], open + 1);
+  if (close == std::string::npos)
+    throw std::runtime_error("Malformed .npy header: bad 'descr'.");
+  header.descr = dict.substr(open + 1, close - open - 1);
+
+  // 'fortran_order': False
+  pos = _findKey(dict, "fortran_order");
+  pos = dict.find_first_not_of(' ', pos);
+  header.fortranOrder = dict.compare(pos, 4, "True") == 0;
+
+  // 'shape': (3, 4)
+  pos = _findKey(dict, "shape");
+  open = dict.find('(', pos);
+  close = dict.find(')', open);
+  if (open == std::string::npos || close == std::string::npos)
+    throw std::runtime_error("Malformed .npy header: bad 'shape'.");
+  std::string dims = dict.substr(open + 1, close - open - 1);
+  size_t start = 0;
+  while (start < dims.size()) {
+    size_t comma = dims.find(',', start);
+    std::string token = dims.substr(start, comma == std::string::npos
+                                               ? std::string::npos
+                                               : comma - start);
+    if (token.find_first_not_of(' ') != std::string::npos)
+      header.shape.push_back(std::stoll(token));
+    if (comma == std::string::npos)
+      break;
+    start = comma + 1;
+  }
+
+  // A 0-d array is stored as a single element
+  if (header.shape.empty())
+    header.shape.push_back(1);
+
+  return header;
+}
+
+std::string detail::_buildNpyHeader(const std::string &descr,
+                            const std::vector<int64_t> &shape) {
+  std::string dict = "{'descr': '" + descr +
+                     "', 'fortran_order': False, 'shape': (";
+  for (size_t i = 0; i < shape.size(); ++i) {
+    dict += std::to_string(shape[i]);
+    if (shape.size() == 1 || i + 1 < shape.size())
+      dict += ",";
+    if (i + 1 < shape.size())
+      dict += " ";
+  }
+  dict += "), }";
+
+  // Version 1.0 stores the header length in 2 bytes, 2.0 in 4 bytes
+  size_t preamble = 10;
+  if (dict.size() + 1 + kNpyAlignment > 65535)
+    preamble = 12;
+  size_t total = preamble + dict.size() + 1;
+  size_t padding = (kNpyAlignment - total % kNpyAlignment) % kNpyAlignment;
+  dict.append(padding, ' ');
+  dict += '\n';
+
+  std::string out(kNpyMagic, kNpyMagicLength);
+  size_t headerLength = dict.size();
+  if (preamble == 10) {
+    out += static_cast<char>(1);
+    out += static_cast<char>(0);
+    out += static_cast<char>(headerLength & 0xff);
+    out += static_cast<char>((headerLength >> 8) & 0xff);
+  } else {
+    out += static_cast<char>(2);
+    out += static_cast<char>(0);
+    for (int i = 0; i < 4; ++i)
+      out += static_cast<char>((headerLength >> (8 * i)) & 0xff);
+  }
+  return out + dict;
+}
+detail::NpyHeader detail::_readNpyHeader(std::istream &in) {
+  // The preamble is at most 12 bytes; read it, then the rest of the header
+  std::vector<char> head(12);
+  in.read(head.data(), head.size());
+  size_t headerLength = 0;
+  if (in.gcount() >= 10 && static_cast<unsigned char>(head[6]) == 1) {
+    headerLength = 10 + (static_cast<unsigned char>(head[8]) |
+                         (static_cast<unsigned char>(head[9]) << 8));
+  } else if (in.gcount() == 12) {
+    for (int i = 3; i >= 0; --i) {
+      headerLength =
+          (headerLength << 8) | static_cast<unsigned char>(head[8 + i]);
+    }
+    headerLength += 12;
+  }
+  if (headerLength < head.size())
+    throw std::runtime_error("Not a .npy file (bad header).");
+  head.resize(headerLength);
+  in.read(head.data() + 12, headerLength - 12);
+
+  // Leave the stream at the start of the payload
+  in.clear();
+  in.seekg(headerLength, std::ios::beg);
+  return _parseNpyHeader(head.data(), head.size());
+}
+
+template <typename T>
+BasicNDArray<T> BasicNDArray<T>::loadNpy(const std::string &path,
+                                         bool mapped) {
+#if defined(INCLIARRAY_HAVE_MMAP)
+  if (mapped) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Could not open '" + path + "'.");
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Could not stat '" + path + "'.");
+    }
+    size_t fileSize = static_cast<size_t>(info.st_size);
+
+    // Private mapping: writes through set() never reach the file
+    void *base = fileSize > 0 ? ::mmap(nullptr, fileSize,
+                                       PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                                       fd, 0)
+                              : MAP_FAILED;
+    ::close(fd);
+    if (base == MAP_FAILED)
+      throw std::runtime_error("Could not map '" + path + "'.");
+
+    std::shared_ptr<void> mapping(
+        base, [fileSize](void *ptr) { ::munmap(ptr, fileSize); });
+
+    const char *bytes = static_cast<const char *>(base);
+    detail::NpyHeader header = detail::_parseNpyHeader(bytes, fileSize);
+    if (header.descr != _npyDescr<T>()) {
+      throw std::invalid_argument("dtype mismatch in loadNpy: file has '" +
+                                  header.descr + "', array expects '" +
+                                  _npyDescr<T>() + "'.");
+    }
+    if (fileSize < header.dataOffset +
+                       _elementCount(header.shape) * sizeof(T)) {
+      throw std::runtime_error("Truncated .npy payload in '" + path + "'.");
+    }
+
+    // The header is padded to 16 (or 64) bytes, so this only fails for
+    // hand-crafted files; fall back to reading in that case.
+    if (header.dataOffset % alignof(T) == 0) {
+      Shape viewStrides =
+          header.fortranOrder ? _fortranStrides(header.shape)
+                              : detail::_computeStrides(header.shape);
+      T *payload = reinterpret_cast<T *>(static_cast<char *>(base) +
+                                         header.dataOffset);
+      BasicNDArray result(header.shape, viewStrides, payload, false);
+      result.dataOwner = mapping;
+      return result;
+    }
+  }
+#endif
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Could not open '" + path + "'.");
+
+  detail::NpyHeader header = detail::_readNpyHeader(file);
+  if (header.descr != _npyDescr<T>()) {
+    throw std::invalid_argument("dtype mismatch in loadNpy: file has '" +
+                                header.descr + "', array expects '" +
+                                _npyDescr<T>() + "'.");
+  }
+
+  BasicNDArray result(header.shape);
+  std::streamsize bytes =
+      static_cast<std::streamsize>(result.size) * sizeof(T);
+  if (!header.fortranOrder) {
+    file.read(reinterpret_cast<char *>(result.data), bytes);
+    if (file.gcount() != bytes)
+      throw std::runtime_error("Truncated .npy payload in '" + path + "'.");
+    return result;
+  }
+
+  // Fortran order: read as-is, then materialize row-major through a view
+  std::vector<T> raw(result.size);
+  file.read(reinterpret_cast<char *>(raw.data()), bytes);
+  if (file.gcount() != bytes)
+    throw std::runtime_error("Truncated .npy payload in '" + path + "'.");
+  BasicNDArray view(header.shape, _fortranStrides(header.shape), raw.data(),
+                    false);
+  return view.clone();
+}
+
+template <typename T>
+void BasicNDArray<T>::saveNpy(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+    throw std::runtime_error("Could not open '" + path + "' for writing.");
+
+  std::string header = detail::_buildNpyHeader(_npyDescr<T>(), shape);
+  file.write(header.data(), header.size());
+
+  if (isContiguous()) {
+    // One large sequential write of the whole payload
+    file.write(reinterpret_cast<const char *>(data),
+               static_cast<std::streamsize>(size) * sizeof(T));
+  } else {
+    // Gather strided elements into large chunks before writing
+    const int64_t chunkElements = 1 << 16;
+    std::vector<T> chunk(std::min(size, chunkElements));
+    Shape index(shape.size(), 0);
+    int filled = 0;
+    for (int64_t i = 0; i < size; ++i) {
+      chunk[filled++] = data[detail::_computeOffset(index, strides)];
+      if (filled == static_cast<int>(chunk.size())) {
+        file.write(reinterpret_cast<const char *>(chunk.data()),
+                   static_cast<std::streamsize>(filled) * sizeof(T));
+        filled = 0;
+      }
+
+      for (int dim = static_cast<int>(shape.size()) - 1; dim >= 0; --dim) {
+        index[dim]++;
+        if (index[dim] < shape[dim])
+          break;
+        index[dim] = 0;
+      }
+    }
+    if (filled > 0) {
+      file.write(reinterpret_cast<const char *>(chunk.data()),
+                 static_cast<std::streamsize>(filled) * sizeof(T));
+    }
+  }
+
+  if (!file)
+    throw std::runtime_error("Failed writing '" + path + "'.");
+}
+
+#define INCLIARRAY_INSTANTIATE_NPY(T)                                          \
+  template BasicNDArray<T> BasicNDArray<T>::loadNpy(const std::string &,      \
+                                                    bool);                     \
+  template void BasicNDArray<T>::saveNpy(const std::string &) const;
+
+INCLIARRAY_INSTANTIATE_NPY(float)
+INCLIARRAY_INSTANTIATE_NPY(double)
+INCLIARRAY_INSTANTIATE_NPY(int32_t)
+INCLIARRAY_INSTANTIATE_NPY(int64_t)
+
+#undef INCLIARRAY_INSTANTIATE_NPY
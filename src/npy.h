@@ -0,0 +1,53 @@
+/**
+ * @file npy.h
+ * @brief Helpers for reading and writing NumPy `.npy` headers.
+ *
+ * This file contains helper functions within the `detail` namespace shared by
+ * NDArray::loadNpy/saveNpy and the file-backed OutOfCoreNDArray.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace detail {
+/**
+ * @brief Parsed contents of an `.npy` header.
+ */
+struct NpyHeader {
+  std::string descr;         /**< dtype string, e.g. "<f4". */
+  bool fortranOrder = false; /**< Whether the payload is column-major. */
+  std::vector<int64_t> shape; /**< Dimensions ({1} for 0-d arrays). */
+  size_t dataOffset = 0;     /**< Byte offset of the payload in the file. */
+};
+
+/**
+ * @brief Parses the preamble (magic, version, length) and header dictionary.
+ * @param bytes Start of the file contents
+ * @param available Number of valid bytes at `bytes`
+ * @return Parsed header
+ */
+NpyHeader _parseNpyHeader(const char *bytes, size_t available);
+
+/**
+ * @brief Reads and parses a header from a stream positioned at file start.
+ *
+ * On return the stream is positioned at the start of the payload.
+ *
+ * @param in Binary input stream
+ * @return Parsed header
+ */
+NpyHeader _readNpyHeader(std::istream &in);
+
+/**
+ * @brief Builds a C-ordered header padded so the payload is 64-byte aligned.
+ * @param descr dtype string, e.g. "<f4"
+ * @param shape Dimensions of the array
+ * @return Preamble and header bytes
+ */
+std::string _buildNpyHeader(const std::string &descr,
+                            const std::vector<int64_t> &shape);
+} // namespace detail
@@ -1,12 +1,12 @@
 #include "./utils.h"
 #include <stdexcept>
 
-std::vector<int> detail::_computeStrides(std::vector<int> newShape) {
-  std::vector<int> computedStrides;
+Shape detail::_computeStrides(const Shape &newShape) {
+  Shape computedStrides;
 
   if (newShape.size() > 1) {
     for (int i = 0; i < newShape.size() - 1; i++) {
-      int currentStrideValue = 1;
+      int64_t currentStrideValue = 1;
       for (int j = i + 1; j < newShape.size(); j++) {
         currentStrideValue *= newShape[j];
       }
@@ -19,17 +19,18 @@ std::vector<int> detail::_computeStrides(std::vector<int> newShape) {
   return computedStrides;
 }
 
-std::vector<int> detail::_broadcastShape(std::vector<int> a,
-                                         std::vector<int> b) {
-  std::vector<int> result;
+Shape detail::_broadcastShape(const Shape &a, const Shape &b) {
+  Shape result;
 
   int aLength = a.size();
   int bLength = b.size();
   int resultNdim = std::max(aLength, bLength);
 
   for (int i = 0; i < resultNdim; i++) {
-    int aDim = (i < resultNdim - aLength) ? 1 : a[i - (resultNdim - aLength)];
-    int bDim = (i < resultNdim - bLength) ? 1 : b[i - (resultNdim - bLength)];
+    int64_t aDim =
+        (i < resultNdim - aLength) ? 1 : a[i - (resultNdim - aLength)];
+    int64_t bDim =
+        (i < resultNdim - bLength) ? 1 : b[i - (resultNdim - bLength)];
 
     if (aDim != bDim && aDim != 1 && bDim != 1) {
       throw std::invalid_argument("Shapes not broadcastable.");
@@ -41,12 +42,12 @@ std::vector<int> detail::_broadcastShape(std::vector<int> a,
   return result;
 }
 
-std::vector<int> detail::_broadcastStrides(std::vector<int> originalShape,
-                                           std::vector<int> originalStrides,
-                                           std::vector<int> targetShape) {
+Shape detail::_broadcastStrides(const Shape &originalShape,
+                                const Shape &originalStrides,
+                                const Shape &targetShape) {
   int ndim = targetShape.size();
   int offset = ndim - originalShape.size();
-  std::vector<int> result(ndim, 0);
+  Shape result(ndim, 0);
 
   for (int i = 0; i < ndim; ++i) {
     if (i < offset) {
@@ -61,10 +62,78 @@ std::vector<int> detail::_broadcastStrides(std::vector<int> originalShape,
   return result;
 }
 
-int detail::_computeOffset(std::vector<int> index, std::vector<int> strides) {
-  int offset = 0;
-  for (size_t i = 0; i < index.size(); ++i) {
-    offset += index[i] * strides[i];
+bool detail::_reshapeStrides(const Shape &oldShape, const Shape &oldStrides,
+                             const Shape &newShape, Shape &newStrides) {
+  int64_t size = 1;
+  for (int64_t dim : oldShape)
+    size *= dim;
+
+  if (size == 0) {
+    newStrides = _computeStrides(newShape);
+    return true;
+  }
+
+  // Size-1 axes never constrain the layout
+  Shape dims;
+  Shape steps;
+  for (size_t i = 0; i < oldShape.size(); ++i) {
+    if (oldShape[i] != 1) {
+      dims.push_back(oldShape[i]);
+      steps.push_back(oldStrides[i]);
+    }
+  }
+
+  int oldNdim = dims.size();
+  int newNdim = newShape.size();
+  Shape result(newNdim, 0);
+
+  // Match groups of old axes [oi, oj) with groups of new axes [ni, nj) that
+  // cover the same number of elements
+  int oi = 0, oj = 1, ni = 0, nj = 1;
+  while (ni < newNdim && oi < oldNdim) {
+    int64_t newCount = newShape[ni];
+    int64_t oldCount = dims[oi];
+
+    while (newCount != oldCount) {
+      if (newCount < oldCount)
+        newCount *= newShape[nj++];
+      else
+        oldCount *= dims[oj++];
+    }
+
+    // The old group must be contiguous relative to itself
+    for (int k = oi; k < oj - 1; ++k) {
+      if (steps[k] != dims[k + 1] * steps[k + 1])
+        return false;
+    }
+
+    // Split the innermost old stride across the new group
+    result[nj - 1] = steps[oj - 1];
+    for (int k = nj - 1; k > ni; --k)
+      result[k - 1] = result[k] * newShape[k];
+
+    ni = nj++;
+    oi = oj++;
+  }
+
+  // Remaining new axes have size 1; any stride works
+  int64_t lastStride = ni > 0 ? result[ni - 1] : 1;
+  for (int k = ni; k < newNdim; ++k)
+    result[k] = lastStride;
+
+  newStrides = result;
+  return true;
+}
+
+bool detail::_isRowMajor(const Shape &shape, const Shape &strides) {
+  if (shape.size() != strides.size())
+    return false;
+
+  int64_t expected = 1;
+  for (int i = static_cast<int>(shape.size()) - 1; i >= 0; --i) {
+    if (strides[i] != expected)
+      return false;
+    expected *= shape[i];
   }
-  return offset;
+  return true;
 }
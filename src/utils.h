@@ -4,11 +4,12 @@
  *
  * This file contains helper functions within the `detail` namespace
  * for computing strides, broadcasting shapes and strides, and calculating
- * offsets.
+ * offsets. All of them work on inline `Shape` metadata passed by reference
+ * and never allocate.
  */
 #pragma once
 
-#include <vector>
+#include "../include/Shape.h"
 
 namespace detail {
 /**
@@ -16,7 +17,7 @@ namespace detail {
  * @param newShape Shape with which strides should be computed
  * @return Computed strides
  */
-std::vector<int> _computeStrides(std::vector<int> newShape);
+Shape _computeStrides(const Shape &newShape);
 
 /**
  * @brief Computes the broadcasted shape of a and b together.
@@ -24,7 +25,7 @@ std::vector<int> _computeStrides(std::vector<int> newShape);
  * @param a Second object for shape broadcasting
  * @return Broadcasted shape
  */
-std::vector<int> _broadcastShape(std::vector<int> a, std::vector<int> b);
+Shape _broadcastShape(const Shape &a, const Shape &b);
 
 /**
  * @brief Computes the broadcasted strides based on original shape and
@@ -35,9 +36,9 @@ std::vector<int> _broadcastShape(std::vector<int> a, std::vector<int> b);
  * will correspond to
  * @return Computed strides
  */
-std::vector<int> _broadcastStrides(std::vector<int> originalShape,
-                                   std::vector<int> originalStrides,
-                                   std::vector<int> targetShape);
+Shape _broadcastStrides(const Shape &originalShape,
+                        const Shape &originalStrides,
+                        const Shape &targetShape);
 
 /**
  * @brief Computes offset based on the index and strides.
@@ -45,5 +46,34 @@ std::vector<int> _broadcastStrides(std::vector<int> originalShape,
  * @param strides Strides that will be used to compute the offset
  * @return Computed offset value
  */
-int _computeOffset(std::vector<int> index, std::vector<int> strides);
+inline int64_t _computeOffset(const Shape &index, const Shape &strides) {
+  int64_t offset = 0;
+  for (size_t i = 0; i < index.size(); ++i) {
+    offset += index[i] * strides[i];
+  }
+  return offset;
+}
+
+/**
+ * @brief Computes strides that view existing memory under a new shape.
+ *
+ * Succeeds when every group of old axes merged or split by the reshape is
+ * laid out contiguously relative to each other (as in NumPy's no-copy
+ * reshape); size-1 axes and zero strides are handled.
+ * @param oldShape Current shape
+ * @param oldStrides Current strides
+ * @param newShape Target shape (same element count)
+ * @param newStrides Receives the strides for newShape on success
+ * @return Whether the reshape is possible without copying
+ */
+bool _reshapeStrides(const Shape &oldShape, const Shape &oldStrides,
+                     const Shape &newShape, Shape &newStrides);
+
+/**
+ * @brief Whether strides are the row‑major strides of shape (no allocation).
+ * @param shape Shape of the array
+ * @param strides Strides to check
+ * @return Whether the layout is contiguous row‑major
+ */
+bool _isRowMajor(const Shape &shape, const Shape &strides);
 } // namespace detail